@@ -122,7 +122,7 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelete					1
 #define INCLUDE_vTaskCleanUpResources		1
 #define INCLUDE_vTaskSuspend				0
-#define INCLUDE_vTaskDelayUntil				0
+#define INCLUDE_vTaskDelayUntil				1
 #define INCLUDE_vTaskDelay					1
 #define INCLUDE_uxTaskGetStackHighWaterMark	1
 
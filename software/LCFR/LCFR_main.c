@@ -6,7 +6,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 // ISR
 #include "system.h"
@@ -14,6 +17,10 @@
 #include "alt_types.h"
 #include "sys/alt_irq.h"
 #include "altera_up_avalon_ps2.h"
+#include "altera_avalon_uart.h"
+#include "altera_avalon_jtag_uart.h"
+#include "sys/ioctl.h"
+#include "sys/alt_alarm.h"
 #include "io.h"
 #include "altera_up_avalon_video_character_buffer_with_dma.h"
 #include "altera_up_avalon_video_pixel_buffer_dma.h"
@@ -25,6 +32,13 @@
 #include "freertos/timers.h"
 #include "freertos/semphr.h"
 
+// Relay
+#include "relay_tasks.h"
+#include "display.h"
+#include "format.h"
+#include "telemetry.h"
+#include "console.h"
+
 /*==============*/
 /* Definitions. */
 /*==============*/
@@ -32,105 +46,62 @@
 #define mainREG_DECIDE_PARAMETER    ( ( void * ) 0x12345678 )
 #define mainREG_LED_OUT_PARAMETER   ( ( void * ) 0x87654321 )
 #define mainREG_VGA_OUT_PARAMETER 	( ( void * ) 0x12348765 )
+#define mainREG_LOG_PARAMETER       ( ( void * ) 0x56781234 )
+#define mainREG_TELEMETRY_PARAMETER ( ( void * ) 0x43218765 )
+#define mainREG_CONSOLE_PARAMETER   ( ( void * ) 0x65872143 )
+#define mainREG_KEYBOARD_PARAMETER  ( ( void * ) 0x21436587 )
 #define mainREG_TEST_PRIORITY       ( tskIDLE_PRIORITY + 1)
-#define SAMPLE_FREQ 				16000
-
-// Keyboard
-#define PS2_1 0x69
-#define PS2_2 0x72
-#define PS2_3 0x7A
-#define PS2_4 0x6B
-#define PS2_5 0x73
-#define PS2_6 0x74
-#define PS2_7 0x6C
-#define PS2_8 0x75
-#define PS2_9 0x7D
-#define PS2_0 0x70
-#define PS2_dp 0x71
-#define PS2_ENTER 0x5A
-#define PS2_DP 0x71
-#define PS2_KEYRELEASE 0xF0
-
-// Graphs
-#define FREQPLT_ORI_X 101		// X axis pixel position at the plot origin
-#define FREQPLT_GRID_SIZE_X 5	// Pixel separation in the x axis between two data points
-#define FREQPLT_ORI_Y 199.0		// Y axis pixel position at the plot origin
-#define FREQPLT_FREQ_RES 20.0	// Number of pixels per Hz (y axis scale)
-
-#define ROCPLT_ORI_X 101
-#define ROCPLT_GRID_SIZE_X 5
-#define ROCPLT_ORI_Y 259.0
-#define ROCPLT_ROC_RES 0.5		// Number of pixels per Hz/s (y axis scale)
-#define MIN_FREQ 45.0 			// Minimum frequency to draw
+#define mainREG_LOG_PRIORITY        ( tskIDLE_PRIORITY )		// Console output only runs when nothing else needs to
+#define mainREG_CONSOLE_PRIORITY    ( tskIDLE_PRIORITY )		// As do console commands and benchmarks
+
+// Console output
+#define CONSOLE_OVERFLOW ALTERA_AVALON_JTAG_UART_COALESCE // What the JTAG UART does with output it has no room for
+
+// Command console
+#define CONSOLE_DEVICE JTAG_UART_NAME	// UART_NAME works too, telemetry_decode skips the text between frames
+#define CONSOLE_POLL 20					// Milliseconds between checks for input
+#define CONSOLE_REPLY 640				// Longest reply, help is the longest
+#define CONSOLE_BENCH_CALLS 10000		// Default calls per benchmark
+
+// Telemetry
+#define TELEMETRY_DEVICE UART_NAME	// JTAG_UART_NAME also works, the decoder skips the console text between frames
+#define TELEMETRY_BUFFERS 4			// Frames queued on the UART at once, beyond that frames are dropped
+#define TELEMETRY_PERIOD 20			// Milliseconds between samples, 1 streams at 1 kHz
+#define TELEMETRY_STATS_PERIOD 1000	// Milliseconds between latency statistics frames
+
+// VGA
+#define VGA_STRIP_CHART 1 // 1 draws only new plot segments each frame, 0 redraws the whole history
 
 /*========================*/
 /* Function Declarations. */
 /*========================*/
-static void prvDecideTask(void *pvParameters);
 static void prvLEDOutTask(void *pvParameters);
 static void prvVGAOutTask(void *pvParameters);
-void translate_ps2(unsigned char byte, double *value);
+static void prvTelemetryTask(void *pvParameters);
+static void prvConsoleTask(void *pvParameters);
 
 /*===================*/
 /* Global Variables. */
 /*===================*/
-// Flags
-int first_load_shed = 0;
-int shed_flag = 0;
-int reconnect_load_timeout = 0;
-int drop_load_timeout = 0;
-int maintenance = 0;
-int desired_flag = 0;
-
-// Configurations
-double desired_max_roc_freq = 8;
-double desired_min_freq = 48.5;
-
-// Data
-double signal_freq = 0;
-double roc_freq = 0;
-int loads[8] = { 1, 1, 1, 1, 1, 1, 1, 1 };
-int switches[8] = { 1, 1, 1, 1, 1, 1, 1, 1 };
-double input_number = 0.0, input_decimal = 0.0, input_decimal_equiv = 0.0, input_final_number = 0.0;
-int input_number_counter = 0, input_decimal_flag = 0, input_duplicate_flag = 0;
+// Relay, with the state the relay tasks share in relay_tasks.c
+Telemetry telemetry;
+unsigned char telemetry_frames[TELEMETRY_BUFFERS][TELEMETRY_MAX_FRAME];
+altera_avalon_uart_tx telemetry_tx[TELEMETRY_BUFFERS];
+volatile int telemetry_queued[TELEMETRY_BUFFERS];		// Cleared by the UART ISR once a frame is sent
+Console console;
+int console_overflow = CONSOLE_OVERFLOW;
 
 // System Status
 int system_uptime = 0;
-int drop_delay = 0;
-double drop_average = 0.0;
-int drop_delay_flag = 0;
-int min_drop_delay = 0;
-int max_drop_delay = 0;
-double store_freq[5] = { 0, 0, 0, 0, 0 };
-double store_dfreq[5] = { 0, 0, 0, 0, 0 };
-char system_uptime_string[10];
-char min_freq_string[12];
-char max_roc_string[12];
-char min_drop_string[8];
-char max_drop_string[8];
-char average_drop_string[12];
-char m1[5], m2[5], m3[5], m4[5], m5[5];
-char n1[5], n2[5], n3[5], n4[5], n5[5];
+int store_freq[5] = { 0, 0, 0, 0, 0 };		// mHz
+int store_dfreq[5] = { 0, 0, 0, 0, 0 };		// mHz/s
+DisplayStatus display_status;
+History history;
 
 /*==========*/
 /* Handles. */
 /*==========*/
-TimerHandle_t drop_timer;
-TimerHandle_t recon_timer;
 TimerHandle_t system_up_timer;
-TimerHandle_t drop_delay_timer;
-static QueueHandle_t Q_freq_data;
-SemaphoreHandle_t shared_resource_mutex;
-
-/*=============*/
-/* Structures. */
-/*=============*/
-typedef struct{
-	unsigned int x1;
-	unsigned int y1;
-	unsigned int x2;
-	unsigned int y2;
-} Line;
 
 /*=======*/
 /* ISRs. */
@@ -139,23 +110,21 @@ typedef struct{
 void button_interrupts_function(void* context, alt_u32 id) {
 	int* temp = (int*) context;
 	(*temp) = IORD_ALTERA_AVALON_PIO_EDGE_CAP(PUSH_BUTTON_BASE); // Store which button was pressed
+	input_log_record(&input_log, INPUT_BUTTON, *temp, xTaskGetTickCountFromISR());
 
-	if (maintenance == 1) { // Toggle Maintenance Mode
+	if (relay.maintenance == 1) { // Toggle Maintenance Mode
 		xSemaphoreTakeFromISR(shared_resource_mutex, NULL);
-		maintenance = 0; // Disable maintenance mode
+		relay_set_maintenance(&relay, 0); // Disable maintenance mode
 		xSemaphoreGiveFromISR(shared_resource_mutex, NULL);
-		printf("Maintenance Mode Disabled\n");
+		message_log_post(&message_logs[MESSAGES_BUTTON], MESSAGE_MAINTENANCE_DISABLED, 0, 0, xTaskGetTickCountFromISR());
 
 		alt_up_ps2_dev *ps2_device = alt_up_ps2_open_dev(PS2_NAME);
 		alt_up_ps2_disable_read_interrupt(ps2_device); // Disable keyboard
-
-		drop_delay = 0;
-		drop_delay_flag = 0;
 	} else {
 		xSemaphoreTakeFromISR(shared_resource_mutex, NULL);
-		maintenance = 1; // Enable maintenance mode
+		relay_set_maintenance(&relay, 1); // Enable maintenance mode
 		xSemaphoreGiveFromISR(shared_resource_mutex, NULL);
-		printf("Maintenance Mode Enabled\n");
+		message_log_post(&message_logs[MESSAGES_BUTTON], MESSAGE_MAINTENANCE_ENABLED, 0, 0, xTaskGetTickCountFromISR());
 
 		alt_up_ps2_dev *ps2_device = alt_up_ps2_open_dev(PS2_NAME);
 		alt_up_ps2_clear_fifo(ps2_device); // Clear keyboard buffer
@@ -164,208 +133,42 @@ void button_interrupts_function(void* context, alt_u32 id) {
 	IOWR_ALTERA_AVALON_PIO_EDGE_CAP(PUSH_BUTTON_BASE, 0x7); // Clear edge capture register
 }
 
-// Frequency Analyser
-void freq_relay() {
-	unsigned int temp = IORD(FREQUENCY_ANALYSER_BASE, 0); // Get the sample count between the two most recent peaks
-
-	// Important: do not swap the order of the two operations otherwise the roc will be 0 all the time
-	if (temp > 0) {
-		xSemaphoreTakeFromISR(shared_resource_mutex, NULL);
-		roc_freq = ((SAMPLE_FREQ / (double) temp) - signal_freq) * (SAMPLE_FREQ / (double) temp); // Calculate and storeROC Frequency
-		signal_freq = SAMPLE_FREQ / (double) temp; // Calculate abd store Instantaneous Frequency
-		xSemaphoreGiveFromISR(shared_resource_mutex, NULL);
-	}
-
-	if ((first_load_shed == 0) && (drop_delay_flag == 0)) {
-		if (fabs(roc_freq) > desired_max_roc_freq || desired_min_freq > signal_freq) {
-			xSemaphoreTakeFromISR(shared_resource_mutex, NULL);
-			drop_delay_flag = 1;
-			drop_delay = 0;
-			xSemaphoreGiveFromISR(shared_resource_mutex, NULL);
-		}
-	}
-
-	xQueueSendToBackFromISR( Q_freq_data, &signal_freq, pdFALSE ); // Add data to xQueue
-
-	return;
-}
-
-// Keyboard
+// Keyboard: drains the PS/2 FIFO into keypad_ring for prvKeyboardTask to decode
 void ps2_isr(void* ps2_device, alt_u32 id){
-	unsigned char byte;
-	alt_up_ps2_read_data_byte_timeout(ps2_device, &byte);
-
-	if (byte == PS2_ENTER) { // Enter key pressed
-		if (input_duplicate_flag == 1) { // Ignore key releases
-			xSemaphoreTakeFromISR(shared_resource_mutex, NULL);
-			input_duplicate_flag = 0;
-			xSemaphoreGiveFromISR(shared_resource_mutex, NULL);
-		} else {
-			xSemaphoreTakeFromISR(shared_resource_mutex, NULL);
-			if (input_decimal_flag == 1) {
-				input_decimal *= 10;
-			} else {
-				input_number /= 10;
-			}
-			input_final_number = input_number + input_decimal;
-			
-			if (desired_flag == 0) {
-				desired_min_freq = input_final_number; // Store entered value
-				printf("The preferred minimum frequency was set to: %f\n", desired_min_freq);
-				desired_flag = 1;
-			} else {
-				desired_max_roc_freq = input_final_number; // Store entered value
-				printf("The preferred maximum rate of change of frequency was set to: %f\n", desired_max_roc_freq);
-				desired_flag = 0;
-			}
-
-			// Clear numbers
-			input_number = 0.0;
-			input_decimal = 0.0;
-			input_final_number = 0.0;
-			input_decimal_equiv = 0.0;
-
-			input_decimal_flag = 0;
-			input_number_counter = 0;
-			xSemaphoreGiveFromISR(shared_resource_mutex, NULL);
-		}
-	} else if (byte == PS2_KEYRELEASE) { // Ignore key releases
-		xSemaphoreTakeFromISR(shared_resource_mutex, NULL);
-		input_duplicate_flag = 1;
-		xSemaphoreGiveFromISR(shared_resource_mutex, NULL);
-	} else {
-		if (input_duplicate_flag == 1) {
-			xSemaphoreTakeFromISR(shared_resource_mutex, NULL);
-			input_duplicate_flag = 0;
-			xSemaphoreGiveFromISR(shared_resource_mutex, NULL);
-		} else {
-			xSemaphoreTakeFromISR(shared_resource_mutex, NULL);
-			// Take care of decimal point
-			if (byte == PS2_DP) { // Handle decimal point
-				input_decimal_flag = 1;
-			}
-
-			if (input_decimal_flag == 0) {
-				// Take care of upper part of number
-				input_number *= 10;
-				
-				// Translate and add to upper part of number
-				translate_ps2(byte, &input_number);
-			} else {
-				// Take care of lower part of number
-				input_number_counter += 1;
-				input_decimal_equiv *= 10;
-
-				// Translate and add to lower part of number
-				translate_ps2(byte, &input_decimal_equiv);
-
-				// Convert to 'normal' decimal
-				int i = 0;
-				input_decimal = input_decimal_equiv;
-				for(i = 0; i < input_number_counter; i++) {
-					input_decimal /= 10.0;
-				}
-			}
-			xSemaphoreGiveFromISR(shared_resource_mutex, NULL);
+	unsigned char bytes[16];
+	BaseType_t woken = pdFALSE;
+	int count, i;
+
+	do {
+		count = alt_up_ps2_read_data_bytes(ps2_device, bytes, sizeof(bytes));
+		for (i = 0; i < count; i++) {
+			keypad_ring_put(&keypad_ring, bytes[i]);
 		}
-	}
-}
+	} while (count == sizeof(bytes));
 
-/*==================*/
-/* Function Macros. */
-/*==================*/
-#define drop_load() { \
-	if (loads[7] == 1) loads[7] = 0; \
-	else if (loads[6] == 1) loads[6] = 0; \
-	else if (loads[5] == 1) loads[5] = 0; \
-	else if (loads[4] == 1) loads[4] = 0; \
-	else if (loads[3] == 1) loads[3] = 0; \
-	else if (loads[2] == 1) loads[2] = 0; \
-	else if (loads[1] == 1) loads[1] = 0; \
-	else loads[0] = 0; \
-}
-
-#define reconnect_load() { \
-	if ((loads[0] == 0) && (switches[0] == 1)) loads[0] = 1; \
-	else if ((loads[1] == 0) && (switches[1] == 1)) loads[1] = 1; \
-	else if ((loads[2] == 0) && (switches[2] == 1)) loads[2] = 1; \
-	else if ((loads[3] == 0) && (switches[3] == 1)) loads[3] = 1; \
-	else if ((loads[4] == 0) && (switches[4] == 1)) loads[4] = 1; \
-	else if ((loads[5] == 0) && (switches[5] == 1)) loads[5] = 1; \
-	else if ((loads[6] == 0) && (switches[6] == 1)) loads[6] = 1; \
-	else if (switches[7] == 1) loads[7] = 1; \
-}
-/*============*/
-/* Functions. */
-/*============*/
-void translate_ps2(unsigned char byte, double *value) {
-	switch(byte) {
-		case PS2_0:
-			*value += 0.0;
-			break;
-		case PS2_1:
-			*value += 1.0;
-			break;
-		case PS2_2:
-			*value += 2.0;
-			break;
-		case PS2_3:
-			*value += 3.0;
-			break;
-		case PS2_4:
-			*value += 4.0;
-			break;
-		case PS2_5:
-			*value += 5.0;
-			break;
-		case PS2_6:
-			*value += 6.0;
-			break;
-		case PS2_7:
-			*value += 7.0;
-			break;
-		case PS2_8:
-			*value += 8.0;
-			break;
-		case PS2_9:
-			*value += 9.0;
-			break;
-		default:
-			break;
-	}
+	xSemaphoreGiveFromISR(keyboard_ready, &woken);
+	portEND_SWITCHING_ISR(woken);
 }
 
 /*============*/
 /* Callbacks. */
 /*============*/
-void vTimerDropCallback(xTimerHandle t_timer) {
-	xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-	drop_load_timeout = 1;
-	xSemaphoreGive(shared_resource_mutex);
-}
-
-void vTimerReconnectCallback(xTimerHandle t_timer) {
-	xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-	reconnect_load_timeout = 1;
-	xSemaphoreGive(shared_resource_mutex);
-}
-
 void vTimerSystemUptimeCallback(xTimerHandle t_timer){
 	xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
 	system_uptime += 1;
 	xSemaphoreGive(shared_resource_mutex);
 }
 
-void vTimerDropDelayCallback(xTimerHandle t_timer){
-	xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-	drop_delay += 1;
-	xSemaphoreGive(shared_resource_mutex);
-}
-
 /*================*/
 /* Main function. */
 /*================*/
 int main(void) {
+	relay_tasks_init();
+	telemetry_init(&telemetry, TELEMETRY_PERIOD);
+
+	// Console output never waits on the JTAG UART, whether or not a host is attached
+	ioctl(fileno(stdout), TIOCSOVERFLOW, &console_overflow);
+
 	// Set up Interrupts
 	int button_value = 0;
 	IOWR_ALTERA_AVALON_PIO_EDGE_CAP(PUSH_BUTTON_BASE, 0x7);
@@ -386,24 +189,18 @@ int main(void) {
 	alt_irq_register(PS2_IRQ, ps2_device, ps2_isr);
 
 	// Create Timers
-	drop_timer = xTimerCreate("Shedding Timer", 500, pdFALSE, NULL, vTimerDropCallback);
-	recon_timer = xTimerCreate("Reconnect Timer", 500, pdFALSE, NULL, vTimerReconnectCallback);
 	system_up_timer = xTimerCreate("System Uptime Timer", 1000, pdTRUE, NULL, vTimerSystemUptimeCallback);
-	drop_delay_timer = xTimerCreate("Drop Delay Timer", 1, pdTRUE, NULL, vTimerDropDelayCallback);
 
 	xTimerStart(system_up_timer, 0);
-	xTimerStart(drop_delay_timer, 0);
-
-	//Create queue
-	Q_freq_data = xQueueCreate( 100, sizeof(double) );
-
-	//Create mutex
-	shared_resource_mutex = xSemaphoreCreateMutex();
 
 	// Set up Tasks
 	xTaskCreate( prvDecideTask, "Rreg1", configMINIMAL_STACK_SIZE, mainREG_DECIDE_PARAMETER, mainREG_TEST_PRIORITY, NULL);
 	xTaskCreate( prvLEDOutTask, "Rreg2", configMINIMAL_STACK_SIZE, mainREG_LED_OUT_PARAMETER, mainREG_TEST_PRIORITY, NULL);
 	xTaskCreate( prvVGAOutTask, "Rreg3", configMINIMAL_STACK_SIZE, mainREG_VGA_OUT_PARAMETER, mainREG_TEST_PRIORITY, NULL);
+	xTaskCreate( prvLogTask, "Log", configMINIMAL_STACK_SIZE, mainREG_LOG_PARAMETER, mainREG_LOG_PRIORITY, NULL);
+	xTaskCreate( prvTelemetryTask, "Telemetry", configMINIMAL_STACK_SIZE, mainREG_TELEMETRY_PARAMETER, mainREG_TEST_PRIORITY, NULL);
+	xTaskCreate( prvConsoleTask, "Console", configMINIMAL_STACK_SIZE, mainREG_CONSOLE_PARAMETER, mainREG_CONSOLE_PRIORITY, NULL);
+	xTaskCreate( prvKeyboardTask, "Keyboard", configMINIMAL_STACK_SIZE, mainREG_KEYBOARD_PARAMETER, mainREG_TEST_PRIORITY, NULL);
 	
 	//Start task scheduler
 	vTaskStartScheduler();
@@ -415,126 +212,6 @@ int main(void) {
 /*========*/
 /* Tasks. */
 /*========*/
-// Decision Task
-static void prvDecideTask(void *pvParameters) {
-	while (1) {
-		// Switch Load Management
-		int switch_value = IORD_ALTERA_AVALON_PIO_DATA(SLIDE_SWITCH_BASE);
-		int masked_switch_value = switch_value & 0x000ff;
-
-		int i, k, no_loads_shed = 1;
-		for (i = 7; i >= 0; i--) { // Iterate through switches array and set if the switch is on or off
-			k = masked_switch_value >> i;
-			if (k & 1) { // If the switch at this position is on
-				xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-				switches[7-i] = 1;
-				xSemaphoreGive(shared_resource_mutex);
-				if (loads[7-i] == 0) {
-					no_loads_shed = 0;
-				}
-				if (maintenance == 1) {
-					xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-					loads[7-i] = 1;
-					xSemaphoreGive(shared_resource_mutex);
-				}
-			} else { // If the switch at this position is off
-				xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-				switches[7-i] = 0;
-				loads[7-i] = 0;
-				xSemaphoreGive(shared_resource_mutex);
-			}
-		}
-
-		if (no_loads_shed == 1) { // If all available loads are connected, we are not managing loads.
-			xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-			first_load_shed = 0;
-			xSemaphoreGive(shared_resource_mutex);
-		}
-
-		// Frequency Load Management
-		if (maintenance == 0) {
-			if (fabs(roc_freq) > desired_max_roc_freq || desired_min_freq > signal_freq) { // If the current system is unstable
-				if (first_load_shed == 0) { // Drop a load, if we have no dropped loads. First load drop.
-					xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-					first_load_shed = 1;
-					drop_load();
-					xSemaphoreGive(shared_resource_mutex);
-
-					// Timing Drop Delay
-					if (drop_delay_flag == 1) {
-						// Set min and max
-						if (drop_delay > max_drop_delay) {
-							xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-							max_drop_delay = drop_delay;
-							xSemaphoreGive(shared_resource_mutex);
-						}
-						if (((drop_delay < min_drop_delay) && (drop_delay != 0)) || (min_drop_delay == 0)) {
-							xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-							min_drop_delay = drop_delay;
-							xSemaphoreGive(shared_resource_mutex);
-						}
-
-						xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-						// Calculate accumulated average
-						if (drop_average == 0) {
-							drop_average = (double) drop_delay;
-						} else {
-							drop_average = (drop_average + (double) drop_delay) / 2.0;
-						}
-
-						if (drop_delay != 0) {
-							printf("Drop Time: %d ms\n", drop_delay);
-						}
-
-						drop_delay_flag = 0;
-						xSemaphoreGive(shared_resource_mutex);
-					}
-				} else {
-					xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-					reconnect_load_timeout = 0; // No longer a continuous run of stable data
-					xSemaphoreGive(shared_resource_mutex);
-
-					if(shed_flag == 0) { // Stop the timer if we are timing a 500ms for a load reconnection
-						xTimerStop(recon_timer, 0);
-					}
-
-					if (drop_load_timeout == 0) { // If we haven't had a continuous run of unstable data
-						if (xTimerIsTimerActive(drop_timer) == pdFALSE) {
-							xTimerStart(drop_timer, 0);
-						}
-					} else {
-						drop_load();
-					}
-					xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-					shed_flag = 1;
-					xSemaphoreGive(shared_resource_mutex);
-				}
-			} else {
-				xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-				drop_load_timeout = 0; // No longer a continuous run of unstable data
-				xSemaphoreGive(shared_resource_mutex);
-
-				if (shed_flag == 1) { // Stop the timer if we are timing a 500ms for a load drop
-					xTimerStop(drop_timer, 0);
-				}
-
-				if (reconnect_load_timeout == 0) { // If we haven't had a continuous run of stable data
-					if (xTimerIsTimerActive(recon_timer) == pdFALSE) {
-						xTimerStart(recon_timer, 0);
-					}
-				} else {
-					reconnect_load();
-				}
-				xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-				shed_flag = 0;
-				xSemaphoreGive(shared_resource_mutex);
-
-			}
-		}
-		vTaskDelay(20);
-	}
-}
-
 // LED Output Task
 static void prvLEDOutTask(void *pvParameters) {
 	while (1) {
@@ -545,7 +222,7 @@ static void prvLEDOutTask(void *pvParameters) {
 		// Inverse array for Red LEDS
 		int rev_loads[8];
 		for (i = 0; i < 8; i++) {
-			if (loads[i] == 0) {
+			if (relay.loads[i] == 0) {
 				rev_loads[i] = 1;
 			} else {
 				rev_loads[i] = 0;
@@ -555,13 +232,13 @@ static void prvLEDOutTask(void *pvParameters) {
 		// Translate to binary
 		for (i = 0; i < 8; i++) {
 			loads_num = loads_num << 1;
-			loads_num = loads_num + loads[i];
+			loads_num = loads_num + relay.loads[i];
 			loads_num_rev = loads_num_rev << 1;
 			loads_num_rev = loads_num_rev + rev_loads[i];
 		}
 
 		// Write to LEDs base
-		if (maintenance == 0) {
+		if (relay.maintenance == 0) {
 			IOWR_ALTERA_AVALON_PIO_DATA(GREEN_LEDS_BASE, loads_num_rev);
 		} else {
 			IOWR_ALTERA_AVALON_PIO_DATA(GREEN_LEDS_BASE, 0);
@@ -576,32 +253,33 @@ static void prvLEDOutTask(void *pvParameters) {
 			xSemaphoreGive(shared_resource_mutex);
 		}
 		xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-		store_freq[0] = signal_freq;
-		store_dfreq[0] = roc_freq;
+		store_freq[0] = relay.signal_mhz;
+		store_dfreq[0] = relay.roc_mhz;
 		xSemaphoreGive(shared_resource_mutex);
 
 		xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
-		snprintf(m1, 5,"%f", store_freq[0]);
-		snprintf(m2, 5,"%f", store_freq[1]);
-		snprintf(m3, 5,"%f", store_freq[2]);
-		snprintf(m4, 5,"%f", store_freq[3]);
-		snprintf(m5, 5,"%f", store_freq[4]);
-
-		snprintf(n1, 5,"%f", store_dfreq[0]);
-		snprintf(n2, 5,"%f", store_dfreq[1]);
-		snprintf(n3, 5,"%f", store_dfreq[2]);
-		snprintf(n4, 5,"%f", store_dfreq[3]);
-		snprintf(n5, 5,"%f", store_dfreq[4]);
+		for (i = 0; i < 5; i++) {
+			format_fixed(display_status.freq[i], 5, store_freq[i], 3, 0);
+			format_fixed(display_status.dfreq[i], 5, store_dfreq[i], 3, 0);
+		}
 		
-		snprintf(system_uptime_string, 10,"%d s",system_uptime);
+		format_int(display_status.system_uptime, 10, system_uptime, " s");
 
-		snprintf(min_freq_string, 12, "%.1f Hz  ", desired_min_freq);
-		snprintf(max_roc_string, 12, "%.1f Hz/s  ", desired_max_roc_freq);
+		format_fixed(display_status.min_freq, 12, (relay.desired_min_mhz + 50) / 100, 1, " Hz  ");
+		format_fixed(display_status.max_roc, 12, (relay.desired_max_roc_mhz + 50) / 100, 1, " Hz/s  ");
 
-		snprintf(min_drop_string, 8, "%d ms  ", min_drop_delay);
-		snprintf(max_drop_string, 8, "%d ms  ", max_drop_delay);
+		format_int(display_status.min_drop, 8, relay.min_drop_delay, " ms  ");
+		format_int(display_status.max_drop, 8, relay.max_drop_delay, " ms  ");
 
-		snprintf(average_drop_string, 12, "%.2f ms  ", drop_average);
+		format_fixed(display_status.average_drop, 12, relay.drop_average, 2, " ms  ");
+
+		if (relay.maintenance == 1) {
+			display_status.mode = DISPLAY_MAINTENANCE;
+		} else if (relay.first_load_shed == 0) {
+			display_status.mode = DISPLAY_MONITORING;
+		} else {
+			display_status.mode = DISPLAY_LOAD_MANAGEMENT;
+		}
 		
 		xSemaphoreGive(shared_resource_mutex);
 
@@ -617,131 +295,441 @@ static void prvVGAOutTask(void *pvParameters) {
 	if (pixel_buf == NULL) {
 		printf("can't find pixel buffer device\n");
 	}
-	alt_up_pixel_buffer_dma_clear_screen(pixel_buf, 0);
-
 	alt_up_char_buffer_dev *char_buf;
 	char_buf = alt_up_char_buffer_open_dev("/dev/video_character_buffer_with_dma");
 	if (char_buf == NULL) {
 		printf("can't find char buffer device\n");
 	}
-	alt_up_char_buffer_clear(char_buf);
-
-	// Set up plot axes
-	alt_up_pixel_buffer_dma_draw_hline(pixel_buf, 100, 590, 200, ((0x3ff << 20) + (0x3ff << 10) + (0x3ff)), 0);
-	alt_up_pixel_buffer_dma_draw_hline(pixel_buf, 100, 590, 300, ((0x3ff << 20) + (0x3ff << 10) + (0x3ff)), 0);
-	alt_up_pixel_buffer_dma_draw_vline(pixel_buf, 100, 50, 200, ((0x3ff << 20) + (0x3ff << 10) + (0x3ff)), 0);
-	alt_up_pixel_buffer_dma_draw_vline(pixel_buf, 100, 220, 300, ((0x3ff << 20) + (0x3ff << 10) + (0x3ff)), 0);
-
-	alt_up_char_buffer_string(char_buf, "Frequency(Hz)", 4, 4);
-	alt_up_char_buffer_string(char_buf, "52", 10, 7);
-	alt_up_char_buffer_string(char_buf, "50", 10, 12);
-	alt_up_char_buffer_string(char_buf, "48", 10, 17);
-	alt_up_char_buffer_string(char_buf, "46", 10, 22);
-
-	alt_up_char_buffer_string(char_buf, "df/dt(Hz/s)", 4, 26);
-	alt_up_char_buffer_string(char_buf, "60", 10, 28);
-	alt_up_char_buffer_string(char_buf, "30", 10, 30);
-	alt_up_char_buffer_string(char_buf, "0", 10, 32);
-	alt_up_char_buffer_string(char_buf, "-30", 9, 34);
-	alt_up_char_buffer_string(char_buf, "-60", 9, 36);
-
-	// Write static text
-	alt_up_char_buffer_string(char_buf, "Frequency Relay System v1.4", 28, 2);
-	alt_up_char_buffer_string(char_buf, "System uptime: ", 10, 40);
-	alt_up_char_buffer_string(char_buf, "Current mode: ", 10, 42);
-	alt_up_char_buffer_string(char_buf, "Latest 5 frequency measurements: ", 10, 44);
-	alt_up_char_buffer_string(char_buf, "Latest 5 df/dt measurements: ", 10, 46);
-	alt_up_char_buffer_string(char_buf, "Minimum Allowable Frequency: ", 10, 48);
-	alt_up_char_buffer_string(char_buf, "Maximum Allowable Frequency ROC: ", 10, 50);
-	alt_up_char_buffer_string(char_buf, "Minimum Time Taken: ", 10, 52);
-	alt_up_char_buffer_string(char_buf, "Maximum Time Taken: ", 10, 54);
-	alt_up_char_buffer_string(char_buf, "Average Time Taken: ", 10, 56);
-
-
-	double freq[100], dfreq[100];
-	int i = 99, j = 0;
-	Line line_freq, line_roc;
+
+	Display display;
+	history_init(&history);
+	display_init(&display, pixel_buf, char_buf, VGA_STRIP_CHART, &history);
 
 	while(1){
 		// Receive frequency data from queue
-		while(uxQueueMessagesWaiting( Q_freq_data ) != 0){
-			xQueueReceive( Q_freq_data, freq+i, 0 );
+		int mhz;
+		while (xQueueReceive(Q_freq_data, &mhz, 0) == pdTRUE) {
+			display_push(&display, mhz);
+		}
+
+		xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
+		int zoom = vga_zoom;
+		xSemaphoreGive(shared_resource_mutex);
+		display_zoom(&display, zoom);
+		display_draw(&display, &display_status);
+		vTaskDelay(20);
+	}
+}
 
-			// Calculate frequency RoC
-			if(i==0){
-				dfreq[0] = (freq[0]-freq[99]) * 2.0 * freq[0] * freq[99] / (freq[0]+freq[99]);
+// Telemetry Task: streams the relay state every telemetry.period ms, in
+// frames of TELEMETRY_BATCH samples, and the latency statistics every second.
+// On the serial UART frames are built in place and queued without copying,
+// so the task never waits on the device. Any other TELEMETRY_DEVICE gets a
+// plain non-blocking write() of each frame.
+static void telemetry_sent(altera_avalon_uart_tx *tx) {
+	*(volatile int *) tx->context = 0;
+}
+
+// Free frame buffer, or -1 if all are still queued
+static int telemetry_buffer(void) {
+	int i;
+	for (i = 0; i < TELEMETRY_BUFFERS; i++) {
+		if (!telemetry_queued[i]) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void telemetry_send(altera_avalon_uart_state *uart, int fd, int buffer, int length) {
+	if (length == 0) {
+		return;
+	}
+	if (buffer < 0) {
+		telemetry.unsent++; // The UART is behind, drop the frame
+		return;
+	}
+	if (uart == NULL) {
+		if (write(fd, telemetry_frames[buffer], length) != length) {
+			telemetry.unsent++; // Device buffer full; the decoder drops the torn frame
+		}
+		return;
+	}
+	telemetry_tx[buffer].ptr = telemetry_frames[buffer];
+	telemetry_tx[buffer].len = length;
+	telemetry_tx[buffer].done = telemetry_sent;
+	telemetry_tx[buffer].context = (void *) &telemetry_queued[buffer];
+	telemetry_queued[buffer] = 1;
+	altera_avalon_uart_write_sg(uart, &telemetry_tx[buffer], 1);
+}
+
+static void prvTelemetryTask(void *pvParameters) {
+	unsigned char scratch[TELEMETRY_MAX_FRAME];
+	altera_avalon_uart_state *uart = NULL;
+	int fd = -1, buffer, length;
+
+	if (strcmp(TELEMETRY_DEVICE, UART_NAME) == 0) {
+		uart = altera_avalon_uart_find_state(UART_NAME);
+	} else {
+		fd = open(TELEMETRY_DEVICE, O_WRONLY | O_NONBLOCK); // Never wait on the device
+	}
+	if ((uart == NULL) && (fd < 0)) {
+		printf("can't open telemetry device\n");
+		vTaskDelete(NULL);
+	}
+
+	TickType_t last_wake = xTaskGetTickCount();
+	TickType_t last_stats = last_wake;
+	while (1) {
+		vTaskDelayUntil(&last_wake, telemetry.period);
+
+		buffer = telemetry_buffer();
+		xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
+		length = telemetry_sample(&telemetry, &relay, last_wake, (buffer >= 0) ? telemetry_frames[buffer] : scratch);
+		xSemaphoreGive(shared_resource_mutex);
+		telemetry_send(uart, fd, buffer, length);
+
+		if (last_wake - last_stats >= TELEMETRY_STATS_PERIOD) {
+			last_stats = last_wake;
+			buffer = telemetry_buffer();
+			xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
+			length = telemetry_stats(&telemetry, &relay, last_wake, (buffer >= 0) ? telemetry_frames[buffer] : scratch);
+			xSemaphoreGive(shared_resource_mutex);
+			telemetry_send(uart, fd, buffer, length);
+		}
+	}
+}
+
+// Console Task: commands over CONSOLE_DEVICE to get and set the relay's
+// thresholds and policies, show statistics and run benchmarks. Input is read
+// without blocking and fed to the line editor a byte at a time, and the task
+// runs at idle priority, so neither typing nor a benchmark holds up the
+// real-time tasks.
+#define PARAM_MIN_FREQ 0
+#define PARAM_MAX_ROC 1
+#define PARAM_PREDICT 2
+#define PARAM_HORIZON 3
+#define PARAM_WINDOW 4
+#define PARAM_OVERFLOW 5
+#define PARAM_ZOOM 6
+
+static const char *const param_names[] = { "min_freq", "max_roc", "predict", "horizon", "window", "overflow", "zoom", 0 };
+static const char *const predict_names[] = { "off", "arm", "shed", 0 };				// PREDICT_OFF, _ARM, _SHED
+static const char *const overflow_names[] = { "block", "newest", "oldest", "coalesce", 0 };	// ALTERA_AVALON_JTAG_UART_BLOCK...
+static const char *const zoom_names[] = { "live", "1min", "10min", "1h", "6h", "1day", "1week", 0 };	// vga_zoom, as the keypad +/- keys
+
+static volatile int bench_sink;
+
+static int param_get(int param, char *out, int size) {
+	int n = format_text(out, size, param_names[param]);
+	n += format_text(out + n, size - n, " ");
+
+	xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
+	switch (param) {
+		case PARAM_MIN_FREQ:
+			n += format_fixed(out + n, size - n, relay.desired_min_mhz, RELAY_DECIMALS, " Hz\n");
+			break;
+		case PARAM_MAX_ROC:
+			n += format_fixed(out + n, size - n, relay.desired_max_roc_mhz, RELAY_DECIMALS, " Hz/s\n");
+			break;
+		case PARAM_PREDICT:
+			n += format_text(out + n, size - n, predict_names[relay.predict_mode]);
+			n += format_text(out + n, size - n, "\n");
+			break;
+		case PARAM_HORIZON:
+			n += format_fixed(out + n, size - n, relay.predict_horizon_ms, 3, " s\n");
+			break;
+		case PARAM_WINDOW:
+			n += format_int(out + n, size - n, relay.stability_window, " ms\n");
+			break;
+		case PARAM_OVERFLOW:
+			n += format_text(out + n, size - n, overflow_names[console_overflow]);
+			n += format_text(out + n, size - n, "\n");
+			break;
+		case PARAM_ZOOM:
+			n += format_text(out + n, size - n, zoom_names[vga_zoom]);
+			n += format_text(out + n, size - n, "\n");
+			break;
+	}
+	xSemaphoreGive(shared_resource_mutex);
+	return n;
+}
+
+// Returns -1 if the value is out of range for the parameter. Numbers are
+// read straight into fixed point with 3 decimals, which is the relay's mHz,
+// mHz/s and ms.
+static int param_set(int param, const char *text) {
+	int value = 0, choice = -1;
+
+	if (param == PARAM_PREDICT) {
+		choice = console_choice(text, predict_names);
+	} else if (param == PARAM_OVERFLOW) {
+		choice = console_choice(text, overflow_names);
+	} else if (param == PARAM_ZOOM) {
+		choice = console_choice(text, zoom_names);
+	} else if (console_number(text, 3, &value) != 0) {
+		return -1;
+	}
+
+	switch (param) {
+		case PARAM_MIN_FREQ:
+			if ((value <= 0) || (value > RELAY_MIN_FREQ_LIMIT)) {
+				return -1;
 			}
-			else{
-				dfreq[i] = (freq[i]-freq[i-1]) * 2.0 * freq[i]* freq[i-1] / (freq[i]+freq[i-1]);
+			break;
+		case PARAM_MAX_ROC:
+			if ((value <= 0) || (value > RELAY_MAX_ROC_LIMIT)) {
+				return -1;
 			}
-
-			if (dfreq[i] > 100.0){
-				dfreq[i] = 100.0;
+			break;
+		case PARAM_HORIZON:
+			if ((value < 0) || (value > RELAY_HORIZON_LIMIT)) {
+				return -1;
+			}
+			break;
+		case PARAM_WINDOW:
+			if ((value < 0) || (value > 60000 * 1000) || (value % 1000 != 0)) {
+				return -1;
+			}
+			value /= 1000;
+			break;
+		default:
+			if (choice < 0) {
+				return -1;
 			}
+			break;
+	}
+
+	if (param == PARAM_OVERFLOW) {
+		if (ioctl(fileno(stdout), TIOCSOVERFLOW, &choice) != 0) {
+			return -1;
+		}
+		console_overflow = choice;
+		return 0;
+	}
 
-			i =	++i%100; // Point to the next data (oldest) to be overwritten
+	xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
+	switch (param) {
+		case PARAM_MIN_FREQ:
+			relay.desired_min_mhz = value;
+			break;
+		case PARAM_MAX_ROC:
+			relay.desired_max_roc_mhz = value;
+			break;
+		case PARAM_PREDICT:
+			relay.predict_mode = choice;
+			break;
+		case PARAM_HORIZON:
+			relay.predict_horizon_ms = value;
+			break;
+		case PARAM_WINDOW:
+			relay.stability_window = (unsigned int) value;
+			break;
+		case PARAM_ZOOM:
+			vga_zoom = choice;
+			break;
+	}
+	xSemaphoreGive(shared_resource_mutex);
+	return 0;
+}
 
+static int command_help(int argc, char *argv[], char *out, int size) {
+	return console_help(&console, out, size);
+}
+
+static int command_get(int argc, char *argv[], char *out, int size) {
+	int n = 0, param;
+
+	if (argc == 1) {
+		for (param = 0; param_names[param] != 0; param++) {
+			n += param_get(param, out + n, size - n);
 		}
+		return n;
+	}
+	if ((argc != 2) || ((param = console_choice(argv[1], param_names)) < 0)) {
+		return -1;
+	}
+	return param_get(param, out, size);
+}
+
+static int command_set(int argc, char *argv[], char *out, int size) {
+	int param;
+
+	if ((argc != 3) || ((param = console_choice(argv[1], param_names)) < 0)) {
+		return -1;
+	}
+	if (param_set(param, argv[2]) != 0) {
+		return format_text(out, size, "Invalid value\n");
+	}
+	return param_get(param, out, size);
+}
+
+static int command_stats(int argc, char *argv[], char *out, int size) {
+	altera_avalon_jtag_uart_stats jtag = { 0 };
+	unsigned int dropped = 0, unsent;
+	int n, i, uptime, shed, min_drop, max_drop, average_drop;
+
+	for (i = 0; i < MESSAGE_SOURCES; i++) {
+		dropped += message_logs[i].dropped;
+	}
+	ioctl(fileno(stdout), TIOCGTXSTATS, &jtag);
+
+	xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
+	uptime = system_uptime;
+	shed = relay.shed_count;
+	min_drop = relay.min_drop_delay;
+	max_drop = relay.max_drop_delay;
+	average_drop = relay.drop_average;
+	unsent = telemetry.unsent;
+	xSemaphoreGive(shared_resource_mutex);
+
+	n = format_int(out, size, uptime, " s uptime\n");
+	n += format_int(out + n, size - n, shed, " loads shed\n");
+	n += format_text(out + n, size - n, "Drop delay min ");
+	n += format_int(out + n, size - n, min_drop, " ms, max ");
+	n += format_int(out + n, size - n, max_drop, " ms, average ");
+	n += format_fixed(out + n, size - n, average_drop, 2, " ms\n");
+	n += format_int(out + n, size - n, unsent, " telemetry frames dropped\n");
+	n += format_int(out + n, size - n, dropped, " console messages dropped\n");
+	n += format_int(out + n, size - n, keypad_ring.dropped, " keyboard bytes dropped\n");
+	n += format_int(out + n, size - n, jtag.dropped, " console bytes dropped in ");
+	n += format_int(out + n, size - n, jtag.overflows, " writes, ");
+	n += format_int(out + n, size - n, jtag.stalls, " writes stalled for ");
+	n += format_int(out + n, size - n, jtag.stall_ticks * 1000 / alt_ticks_per_second(), " ms\n");
+	return n;
+}
+
+static void bench_format(int calls) {
+	char buf[16];
+	int i;
+	for (i = 0; i < calls; i++) {
+		bench_sink += format_fixed(buf, sizeof(buf), 49000 + i % 2000, 3, " Hz");
+	}
+}
+
+static void bench_snprintf(int calls) {
+	char buf[16];
+	int i;
+	for (i = 0; i < calls; i++) {
+		bench_sink += snprintf(buf, sizeof(buf), "%.3f Hz", (49000 + i % 2000) / 1000.0);
+	}
+}
+
+// Steps a copy, so the live relay is untouched
+static void bench_relay(int calls) {
+	Relay copy;
+	int i;
+
+	xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
+	copy = relay;
+	xSemaphoreGive(shared_resource_mutex);
+	for (i = 0; i < calls; i++) {
+		bench_sink += relay_step(&copy, 0xff, i * 20);
+	}
+}
+
+static void bench_telemetry(int calls) {
+	unsigned char frame[TELEMETRY_MAX_FRAME];
+	Telemetry scratch;
+	Relay copy;
+	int i;
 
-		// Clear old graph to draw new graph
-		alt_up_pixel_buffer_dma_draw_box(pixel_buf, 101, 0, 639, 199, 0, 0);
-		alt_up_pixel_buffer_dma_draw_box(pixel_buf, 101, 201, 639, 299, 0, 0);
-
-		for (j = 0; j < 99; ++j) { // i here points to the oldest data, j loops through all the data to be drawn on VGA
-			if (((int)(freq[(i+j)%100]) > MIN_FREQ) && ((int)(freq[(i+j+1)%100]) > MIN_FREQ)){
-				// Calculate coordinates of the two data points to draw a line in between
-				// Frequency plot
-				line_freq.x1 = FREQPLT_ORI_X + FREQPLT_GRID_SIZE_X * j;
-				line_freq.y1 = (int)(FREQPLT_ORI_Y - FREQPLT_FREQ_RES * (freq[(i+j)%100] - MIN_FREQ));
-
-				line_freq.x2 = FREQPLT_ORI_X + FREQPLT_GRID_SIZE_X * (j + 1);
-				line_freq.y2 = (int)(FREQPLT_ORI_Y - FREQPLT_FREQ_RES * (freq[(i+j+1)%100] - MIN_FREQ));
-
-				// Frequency RoC plot
-				line_roc.x1 = ROCPLT_ORI_X + ROCPLT_GRID_SIZE_X * j;
-				line_roc.y1 = (int)(ROCPLT_ORI_Y - ROCPLT_ROC_RES * dfreq[(i+j)%100]);
-
-				line_roc.x2 = ROCPLT_ORI_X + ROCPLT_GRID_SIZE_X * (j + 1);
-				line_roc.y2 = (int)(ROCPLT_ORI_Y - ROCPLT_ROC_RES * dfreq[(i+j+1)%100]);
-
-				// Draw
-				alt_up_pixel_buffer_dma_draw_line(pixel_buf, line_freq.x1, line_freq.y1, line_freq.x2, line_freq.y2, 0x3ff << 0, 0);
-				alt_up_pixel_buffer_dma_draw_line(pixel_buf, line_roc.x1, line_roc.y1, line_roc.x2, line_roc.y2, 0x3ff << 0, 0);
-
-				// Write dynamic text
-				alt_up_char_buffer_string(char_buf, system_uptime_string, 25, 40);
-
-				if (maintenance == 0) {
-					if (first_load_shed == 0) {
-						alt_up_char_buffer_string(char_buf, "Monitoring     ", 24, 42);
-					} else {
-						alt_up_char_buffer_string(char_buf, "Load Management", 24, 42);
-					}
-				} else {
-					alt_up_char_buffer_string(char_buf, "Maintenance    ", 24, 42);
-				}
-
-				alt_up_char_buffer_string(char_buf, m1, 43, 44);
-				alt_up_char_buffer_string(char_buf, m2, 48, 44);
-				alt_up_char_buffer_string(char_buf, m3, 53, 44);
-				alt_up_char_buffer_string(char_buf, m4, 58, 44);
-				alt_up_char_buffer_string(char_buf, m5, 63, 44);
-
-				alt_up_char_buffer_string(char_buf, n1, 39, 46);
-				alt_up_char_buffer_string(char_buf, n2, 44, 46);
-				alt_up_char_buffer_string(char_buf, n3, 49, 46);
-				alt_up_char_buffer_string(char_buf, n4, 54, 46);
-				alt_up_char_buffer_string(char_buf, n5, 59, 46);
-
-				alt_up_char_buffer_string(char_buf, min_freq_string, 39, 48);
-				alt_up_char_buffer_string(char_buf, max_roc_string, 43, 50);
-
-				alt_up_char_buffer_string(char_buf, min_drop_string, 30, 52);
-				alt_up_char_buffer_string(char_buf, max_drop_string, 30, 54);
-
-				alt_up_char_buffer_string(char_buf, average_drop_string, 30, 56);
+	xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
+	copy = relay;
+	xSemaphoreGive(shared_resource_mutex);
+	telemetry_init(&scratch, 1);
+	for (i = 0; i < calls; i++) {
+		bench_sink += telemetry_sample(&scratch, &copy, i, frame);
+	}
+}
+
+static const char *const bench_names[] = { "format", "snprintf", "relay", "telemetry", 0 };
+static void (*const bench_functions[])(int calls) = { bench_format, bench_snprintf, bench_relay, bench_telemetry };
+#define BENCHES (sizeof(bench_functions) / sizeof(bench_functions[0]))
+
+// Wall time in ticks, so anything that preempts the console is counted too
+static int command_bench(int argc, char *argv[], char *out, int size) {
+	int first = 0, last = BENCHES, calls = CONSOLE_BENCH_CALLS, n = 0, i;
+
+	if ((argc >= 2) && (strcmp(argv[1], "all") != 0)) {
+		if ((first = console_choice(argv[1], bench_names)) < 0) {
+			return -1;
+		}
+		last = first + 1;
+	}
+	if ((argc > 3) || ((argc == 3) && (console_number(argv[2], 0, &calls) != 0)) || (calls < 1) || (calls > 1000000)) {
+		return -1;
+	}
+
+	for (i = first; i < last; i++) {
+		TickType_t start = xTaskGetTickCount();
+		bench_functions[i](calls);
+		TickType_t ticks = xTaskGetTickCount() - start;
+
+		n += format_text(out + n, size - n, bench_names[i]);
+		n += format_text(out + n, size - n, " ");
+		n += format_fixed(out + n, size - n, (int) ((long long) ticks * (1000000 / configTICK_RATE_HZ) * 10 / calls), 1,
+				" us per call\n");
+	}
+	return n;
+}
+
+static const ConsoleCommand console_commands[] = {
+	{ "help", "", "List the commands", command_help },
+	{ "get", "[min_freq|max_roc|predict|horizon|window|overflow|zoom]", "Show one or all settings", command_get },
+	{ "set", "<setting> <value>", "Change a setting, predict is off|arm|shed, overflow block|newest|oldest|coalesce, zoom live|1min|10min|1h|6h|1day|1week",
+			command_set },
+	{ "stats", "", "Show shedding, latency and dropped output statistics", command_stats },
+	{ "bench", "[all|format|snprintf|relay|telemetry] [calls]", "Time a routine at idle priority", command_bench },
+};
+#define CONSOLE_COMMANDS (sizeof(console_commands) / sizeof(console_commands[0]))
+
+// Writes all of a reply, under console_mutex so it never interleaves with the
+// log task's lines. The console is opened non-blocking, so with the block
+// overflow policy a full device takes part of a write or none of it; the
+// rest is retried every CONSOLE_POLL ms. Gives up if the host goes away.
+static void console_write(int fd, const char *reply, int n) {
+	int written;
+
+	xSemaphoreTake(console_mutex, portMAX_DELAY);
+	while (n > 0) {
+		written = write(fd, reply, n);
+		if (written > 0) {
+			reply += written;
+			n -= written;
+		} else if ((written == 0) || (errno == EWOULDBLOCK) || (errno == EAGAIN)) {
+			vTaskDelay(CONSOLE_POLL);
+		} else {
+			break;
+		}
+	}
+	xSemaphoreGive(console_mutex);
+}
+
+static void prvConsoleTask(void *pvParameters) {
+	char input[32];
+	char reply[CONSOLE_REPLY];
+	int fd, count, n, i;
+
+	fd = open(CONSOLE_DEVICE, O_RDWR | O_NONBLOCK);
+	if (fd < 0) {
+		printf("can't open the console device\n");
+		vTaskDelete(NULL);
+	}
+	console_init(&console, console_commands, CONSOLE_COMMANDS);
+	console_write(fd, reply, console_prompt(reply, sizeof(reply)));
+
+	while (1) {
+		count = read(fd, input, sizeof(input)); // Returns at once, -1 when nothing has arrived
+		if (count <= 0) {
+			vTaskDelay(CONSOLE_POLL);
+			continue;
+		}
+		for (i = 0; i < count; i++) {
+			n = console_byte(&console, input[i], reply, sizeof(reply));
+			if (n > 0) {
+				console_write(fd, reply, n);
 			}
 		}
-		vTaskDelay(20);
 	}
 }
@@ -0,0 +1,170 @@
+/*===========*/
+/* Includes. */
+/*===========*/
+#include <string.h>
+
+#include "console.h"
+#include "format.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define CONSOLE_CTRL_C 0x03
+#define CONSOLE_CTRL_U 0x15
+#define CONSOLE_BACKSPACE 0x08
+#define CONSOLE_DELETE 0x7F
+
+/*============*/
+/* Functions. */
+/*============*/
+void console_init(Console *console, const ConsoleCommand *commands, int num_commands) {
+	console->commands = commands;
+	console->num_commands = num_commands;
+	console->length = 0;
+	console->overflow = 0;
+	console->last_cr = 0;
+}
+
+// Split the line in place and run it, then prompt for the next one
+static int console_run(Console *console, char *out, int size) {
+	char *argv[CONSOLE_MAX_ARGS];
+	char *p = console->line;
+	int argc = 0, n, i;
+
+	console->line[console->length] = '\0';
+	n = format_text(out, size, "\n");
+
+	if (console->overflow) {
+		n += format_text(out + n, size - n, "Line too long\n");
+		argc = -1;
+	}
+	while (argc >= 0) {
+		while (*p == ' ') {
+			p++;
+		}
+		if (*p == '\0') {
+			break;
+		}
+		if (argc == CONSOLE_MAX_ARGS) {
+			n += format_text(out + n, size - n, "Too many arguments\n");
+			argc = -1;
+			break;
+		}
+		argv[argc++] = p;
+		while ((*p != ' ') && (*p != '\0')) {
+			p++;
+		}
+		if (*p != '\0') {
+			*p++ = '\0';
+		}
+	}
+
+	if (argc > 0) {
+		for (i = 0; i < console->num_commands; i++) {
+			if (strcmp(argv[0], console->commands[i].name) == 0) {
+				break;
+			}
+		}
+		if (i == console->num_commands) {
+			n += format_text(out + n, size - n, "Unknown command, try help\n");
+		} else {
+			const ConsoleCommand *command = &console->commands[i];
+			int reply = command->handler(argc, argv, out + n, size - n);
+			if (reply < 0) {
+				n += format_text(out + n, size - n, "Usage: ");
+				n += format_text(out + n, size - n, command->name);
+				n += format_text(out + n, size - n, " ");
+				n += format_text(out + n, size - n, command->usage);
+				n += format_text(out + n, size - n, "\n");
+			} else {
+				n += reply;
+			}
+		}
+	}
+
+	console->length = 0;
+	console->overflow = 0;
+	return n + console_prompt(out + n, size - n);
+}
+
+// Feed one received byte. Returns the length of the text to send back, the
+// echo or a command's reply, written to out like snprintf.
+int console_byte(Console *console, char c, char *out, int size) {
+	char echo[2] = { c, '\0' };
+
+	if ((c == '\n') && console->last_cr) {
+		console->last_cr = 0;
+		return 0;
+	}
+	console->last_cr = (c == '\r');
+
+	switch (c) {
+		case '\r':
+		case '\n':
+			return console_run(console, out, size);
+		case CONSOLE_CTRL_C:
+		case CONSOLE_CTRL_U:
+			console->length = 0;
+			console->overflow = 0;
+			return format_text(out, size, (c == CONSOLE_CTRL_C) ? "^C\n" CONSOLE_PROMPT : "^U\n" CONSOLE_PROMPT);
+		case CONSOLE_BACKSPACE:
+		case CONSOLE_DELETE:
+			if ((console->length == 0) || console->overflow) {
+				return 0;
+			}
+			console->length--;
+			return format_text(out, size, "\b \b");
+		default:
+			break;
+	}
+
+	if ((c < ' ') || (c > '~')) {
+		return 0; // Other control characters and escape sequences are ignored
+	}
+	if (console->length == CONSOLE_LINE - 1) {
+		console->overflow = 1;
+		return 0;
+	}
+	console->line[console->length++] = c;
+	return format_text(out, size, echo);
+}
+
+int console_prompt(char *out, int size) {
+	return format_text(out, size, CONSOLE_PROMPT);
+}
+
+// One line per command: name, arguments and what it does
+int console_help(const Console *console, char *out, int size) {
+	int n = 0, i;
+
+	for (i = 0; i < console->num_commands; i++) {
+		const ConsoleCommand *command = &console->commands[i];
+		n += format_text(out + n, size - n, command->name);
+		if (command->usage[0] != '\0') {
+			n += format_text(out + n, size - n, " ");
+			n += format_text(out + n, size - n, command->usage);
+		}
+		n += format_text(out + n, size - n, "\n    ");
+		n += format_text(out + n, size - n, command->help);
+		n += format_text(out + n, size - n, "\n");
+	}
+	return n;
+}
+
+// A whole argument as a decimal number, in fixed point with the given
+// decimals. Returns -1 if it isn't one or is out of the int range.
+int console_number(const char *text, int decimals, int *value) {
+	return format_parse(text, decimals, value);
+}
+
+// Index of text in a 0 terminated list of names, or -1
+int console_choice(const char *text, const char *const *choices) {
+	int i;
+
+	for (i = 0; choices[i] != 0; i++) {
+		if (strcmp(text, choices[i]) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
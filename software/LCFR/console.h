@@ -0,0 +1,50 @@
+#ifndef CONSOLE_H_
+#define CONSOLE_H_
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+// Command line console. Input is fed in a byte at a time as it arrives, so
+// the caller never waits for a whole line: printable characters are
+// echoed, backspace/delete erase, Ctrl-U clears the line and Ctrl-C drops
+// it. CR, LF or CR LF ends a line, which is split on spaces and run
+// through the caller's command table. Nothing here does I/O; every
+// function returns the text to send back.
+#define CONSOLE_LINE 64				// Longest command line, longer ones are refused
+#define CONSOLE_MAX_ARGS 4			// Command name included
+#define CONSOLE_PROMPT "> "
+
+/*=============*/
+/* Structures. */
+/*=============*/
+// Runs a command with argv[0] its name, writing the reply to out like
+// snprintf. Returns the reply length, or -1 to have the usage printed.
+typedef int (*ConsoleHandler)(int argc, char *argv[], char *out, int size);
+
+typedef struct {
+	const char *name;
+	const char *usage;		// Arguments, for help and usage errors
+	const char *help;
+	ConsoleHandler handler;
+} ConsoleCommand;
+
+typedef struct {
+	const ConsoleCommand *commands;
+	int num_commands;
+	char line[CONSOLE_LINE];
+	int length;
+	int overflow;			// The line outgrew the buffer, refuse it at its end
+	int last_cr;			// Swallow the LF of a CR LF
+} Console;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+void console_init(Console *console, const ConsoleCommand *commands, int num_commands);
+int console_byte(Console *console, char c, char *out, int size);
+int console_prompt(char *out, int size);
+int console_help(const Console *console, char *out, int size);
+int console_number(const char *text, int decimals, int *value);
+int console_choice(const char *text, const char *const *choices);
+
+#endif /* CONSOLE_H_ */
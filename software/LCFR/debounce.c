@@ -0,0 +1,40 @@
+/*===========*/
+/* Includes. */
+/*===========*/
+#include "debounce.h"
+
+/*============*/
+/* Functions. */
+/*============*/
+void debounce_init(Debounce *debounce, unsigned int value) {
+	debounce->value = value;
+	debounce->held = 0;
+}
+
+// Feed one raw sample. Returns the bits of the debounced value it changed.
+unsigned int debounce_sample(Debounce *debounce, unsigned int raw, unsigned int now) {
+	unsigned int changed = raw ^ debounce->value;
+	unsigned int bits;
+	int i;
+
+	if ((changed == 0) && (debounce->held == 0)) {
+		return 0; // Nothing moved and nothing settling
+	}
+
+	// Release the bits whose hold-off has ended
+	for (i = 0, bits = debounce->held; bits != 0; i++, bits >>= 1) {
+		if ((bits & 1) && (now - debounce->held_since[i] >= DEBOUNCE_HOLDOFF)) {
+			debounce->held &= ~(1u << i);
+		}
+	}
+
+	changed &= ~debounce->held;
+	debounce->value ^= changed;
+	debounce->held |= changed;
+	for (i = 0, bits = changed; bits != 0; i++, bits >>= 1) {
+		if (bits & 1) {
+			debounce->held_since[i] = now;
+		}
+	}
+	return changed;
+}
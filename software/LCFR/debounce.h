@@ -0,0 +1,29 @@
+#ifndef DEBOUNCE_H_
+#define DEBOUNCE_H_
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+// Debouncing for a polled bank of switches with no edge capture, such as the
+// slide switch PIO. A sample that matches the debounced value costs one XOR.
+// A bit that differs is taken at once, so debouncing adds no latency, and is
+// then held for DEBOUNCE_HOLDOFF so contact bounce cannot flip it back.
+#define DEBOUNCE_BITS 32
+#define DEBOUNCE_HOLDOFF 50			// Milliseconds (ticks)
+
+/*=============*/
+/* Structures. */
+/*=============*/
+typedef struct {
+	unsigned int value;						// Debounced
+	unsigned int held;						// Bits changed within the hold-off, ignored until it ends
+	unsigned int held_since[DEBOUNCE_BITS];	// When each held bit changed
+} Debounce;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+void debounce_init(Debounce *debounce, unsigned int value);
+unsigned int debounce_sample(Debounce *debounce, unsigned int raw, unsigned int now);
+
+#endif /* DEBOUNCE_H_ */
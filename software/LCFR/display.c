@@ -0,0 +1,328 @@
+/*===========*/
+/* Includes. */
+/*===========*/
+#include "display.h"
+
+/*===================*/
+/* Global Variables. */
+/*===================*/
+// Seconds shown by each zoom level, and the label drawn over the frequency plot
+static const unsigned int zoom_spans[DISPLAY_ZOOM_LEVELS] = { 0, 60, 600, 3600, 6 * 3600, 24 * 3600, 7 * 24 * 3600 };
+static const char *zoom_labels[DISPLAY_ZOOM_LEVELS] = { "              ", "History 1 min ", "History 10 min", "History 1 h   ",
+		"History 6 h   ", "History 1 day ", "History 1 week" };
+static HistoryBin zoom_columns[DISPLAY_COLUMNS];
+
+// Plot rows by frequency and by RoC, see FREQ_LUT_MIN
+static short freq_lut[FREQ_LUT_SIZE];
+static short roc_lut[ROC_LUT_SIZE];
+
+/*============*/
+/* Functions. */
+/*============*/
+// Rows from the plot scales at the start of each entry, so a row only differs
+// from the floating point one for values within one entry above a row
+// boundary; 0 Hz/s and every 200 mHz are entry starts. Out of range values
+// are held at the plot edge rather than drawn outside it.
+static void display_build_tables(void) {
+	int i, row;
+
+	for (i = 0; i < FREQ_LUT_SIZE; i++) {
+		double freq = (FREQ_LUT_MIN + (i << FREQ_LUT_SHIFT)) / 1000.0;
+		row = (int)(FREQPLT_ORI_Y - FREQPLT_FREQ_RES * (freq - MIN_FREQ));
+		freq_lut[i] = (row < 0) ? 0 : row;
+	}
+	for (i = 0; i < ROC_LUT_SIZE; i++) {
+		double roc = (ROC_LUT_MIN + (i << ROC_LUT_SHIFT)) / 1000.0;
+		row = (int)(ROCPLT_ORI_Y - ROCPLT_ROC_RES * roc);
+		roc_lut[i] = (row < 201) ? 201 : (row > 299) ? 299 : row;
+	}
+}
+
+// Frequency plot row of a frequency in mHz, 200 (below the plot) under FREQ_LUT_MIN
+static int freq_row(int freq) {
+	int i;
+	if (freq < FREQ_LUT_MIN) {
+		return 200;
+	}
+	i = (freq - FREQ_LUT_MIN) >> FREQ_LUT_SHIFT;
+	return freq_lut[(i < FREQ_LUT_SIZE) ? i : FREQ_LUT_SIZE - 1];
+}
+
+// RoC plot row of a RoC in mHz/s
+static int roc_row(int roc) {
+	if (roc < ROC_LUT_MIN) {
+		roc = ROC_LUT_MIN;
+	}
+	return roc_lut[(roc - ROC_LUT_MIN) >> ROC_LUT_SHIFT];
+}
+
+// Clear both screens and draw everything that never changes: axes, labels and static text
+void display_init(Display *display, alt_up_pixel_buffer_dma_dev *pixel_buf, alt_up_char_buffer_dev *char_buf, int strip_chart, History *history) {
+	int i;
+
+	display_build_tables();
+	display->pixel_buf = pixel_buf;
+	display->char_buf = char_buf;
+	for (i = 0; i < DISPLAY_RING; i++) {
+		display->freq[i] = 0;
+		display->freq_y[i] = DISPLAY_NO_POINT;
+		display->roc_y[i] = roc_row(0);
+	}
+	display->count = 0;
+	display->strip_chart = strip_chart;
+	display->drawn = 0;
+	display->history = history;
+	display->zoom = 0;
+	display->zoom_drawn = 0;
+	display->zoom_dirty = 0;
+
+	alt_up_pixel_buffer_dma_clear_screen(pixel_buf, 0);
+	alt_up_char_buffer_clear(char_buf);
+
+	// Set up plot axes
+	alt_up_pixel_buffer_dma_draw_hline(pixel_buf, 100, 590, 200, ((0x3ff << 20) + (0x3ff << 10) + (0x3ff)), 0);
+	alt_up_pixel_buffer_dma_draw_hline(pixel_buf, 100, 590, 300, ((0x3ff << 20) + (0x3ff << 10) + (0x3ff)), 0);
+	alt_up_pixel_buffer_dma_draw_vline(pixel_buf, 100, 50, 200, ((0x3ff << 20) + (0x3ff << 10) + (0x3ff)), 0);
+	alt_up_pixel_buffer_dma_draw_vline(pixel_buf, 100, 220, 300, ((0x3ff << 20) + (0x3ff << 10) + (0x3ff)), 0);
+
+	alt_up_char_buffer_string(char_buf, "Frequency(Hz)", 4, 4);
+	alt_up_char_buffer_string(char_buf, "52", 10, 7);
+	alt_up_char_buffer_string(char_buf, "50", 10, 12);
+	alt_up_char_buffer_string(char_buf, "48", 10, 17);
+	alt_up_char_buffer_string(char_buf, "46", 10, 22);
+
+	alt_up_char_buffer_string(char_buf, "df/dt(Hz/s)", 4, 26);
+	alt_up_char_buffer_string(char_buf, "60", 10, 28);
+	alt_up_char_buffer_string(char_buf, "30", 10, 30);
+	alt_up_char_buffer_string(char_buf, "0", 10, 32);
+	alt_up_char_buffer_string(char_buf, "-30", 9, 34);
+	alt_up_char_buffer_string(char_buf, "-60", 9, 36);
+
+	// Write static text
+	alt_up_char_buffer_string(char_buf, "Frequency Relay System v1.4", 28, 2);
+	alt_up_char_buffer_string(char_buf, "System uptime: ", 10, 40);
+	alt_up_char_buffer_string(char_buf, "Current mode: ", 10, 42);
+	alt_up_char_buffer_string(char_buf, "Latest 5 frequency measurements: ", 10, 44);
+	alt_up_char_buffer_string(char_buf, "Latest 5 df/dt measurements: ", 10, 46);
+	alt_up_char_buffer_string(char_buf, "Minimum Allowable Frequency: ", 10, 48);
+	alt_up_char_buffer_string(char_buf, "Maximum Allowable Frequency ROC: ", 10, 50);
+	alt_up_char_buffer_string(char_buf, "Minimum Time Taken: ", 10, 52);
+	alt_up_char_buffer_string(char_buf, "Maximum Time Taken: ", 10, 54);
+	alt_up_char_buffer_string(char_buf, "Average Time Taken: ", 10, 56);
+}
+
+// Add a frequency sample in mHz from the analyser queue, overwriting the
+// oldest. The RoC is worked out in mHz/s.
+void display_push(Display *display, int mhz) {
+	unsigned int i = display->count & DISPLAY_RING_MASK;
+	int prev = display->freq[(display->count - 1) & DISPLAY_RING_MASK];
+	int roc = 0;
+
+	if (mhz < 0) {
+		mhz = 0;
+	}
+
+	// Calculate frequency RoC, (f - f_prev) * 2 f f_prev / (f + f_prev)
+	if (mhz + prev > 0) {
+		long long harmonic = 2LL * mhz * prev / (mhz + prev);
+		roc = (int)((mhz - prev) * harmonic / 1000);
+	}
+	if (roc > ROC_LUT_MAX) {
+		roc = ROC_LUT_MAX;
+	}
+
+	display->freq[i] = mhz;
+	display->freq_y[i] = (mhz / 1000 > (int) MIN_FREQ) ? freq_row(mhz) : DISPLAY_NO_POINT;
+	display->roc_y[i] = roc_row(roc);
+	display->count++;
+
+	if (display->history != NULL) {
+		history_push(display->history, mhz);
+	}
+}
+
+// Switch between the live plot (0) and the history views. Both plots are
+// cleared; the live plot is redrawn from the ring on the next frame.
+void display_zoom(Display *display, int zoom) {
+	if ((zoom < 0) || (zoom >= DISPLAY_ZOOM_LEVELS) || (display->history == NULL) || (zoom == display->zoom)) {
+		return;
+	}
+	display->zoom = zoom;
+	display->zoom_dirty = 1;
+	display->drawn = 0;
+
+	alt_up_pixel_buffer_dma_draw_box(display->pixel_buf, 101, 0, 639, 199, 0, 0);
+	alt_up_pixel_buffer_dma_draw_box(display->pixel_buf, 101, 201, 639, 299, 0, 0);
+	alt_up_char_buffer_string(display->char_buf, zoom_labels[zoom], 30, 4);
+}
+
+static void display_text(alt_up_char_buffer_dev *char_buf, const DisplayStatus *status) {
+	alt_up_char_buffer_string(char_buf, status->system_uptime, 25, 40);
+
+	if (status->mode == DISPLAY_MONITORING) {
+		alt_up_char_buffer_string(char_buf, "Monitoring     ", 24, 42);
+	} else if (status->mode == DISPLAY_LOAD_MANAGEMENT) {
+		alt_up_char_buffer_string(char_buf, "Load Management", 24, 42);
+	} else {
+		alt_up_char_buffer_string(char_buf, "Maintenance    ", 24, 42);
+	}
+
+	alt_up_char_buffer_string(char_buf, status->freq[0], 43, 44);
+	alt_up_char_buffer_string(char_buf, status->freq[1], 48, 44);
+	alt_up_char_buffer_string(char_buf, status->freq[2], 53, 44);
+	alt_up_char_buffer_string(char_buf, status->freq[3], 58, 44);
+	alt_up_char_buffer_string(char_buf, status->freq[4], 63, 44);
+
+	alt_up_char_buffer_string(char_buf, status->dfreq[0], 39, 46);
+	alt_up_char_buffer_string(char_buf, status->dfreq[1], 44, 46);
+	alt_up_char_buffer_string(char_buf, status->dfreq[2], 49, 46);
+	alt_up_char_buffer_string(char_buf, status->dfreq[3], 54, 46);
+	alt_up_char_buffer_string(char_buf, status->dfreq[4], 59, 46);
+
+	alt_up_char_buffer_string(char_buf, status->min_freq, 39, 48);
+	alt_up_char_buffer_string(char_buf, status->max_roc, 43, 50);
+
+	alt_up_char_buffer_string(char_buf, status->min_drop, 30, 52);
+	alt_up_char_buffer_string(char_buf, status->max_drop, 30, 54);
+
+	alt_up_char_buffer_string(char_buf, status->average_drop, 30, 56);
+}
+
+// Clear the columns of one slot in both plots. Slot 0 also owns the first
+// column, every other slot shares its left column with the slot before.
+static void display_clear_slot(alt_up_pixel_buffer_dma_dev *pixel_buf, int slot) {
+	int left = FREQPLT_ORI_X + FREQPLT_GRID_SIZE_X * slot + ((slot == 0) ? 0 : 1);
+	int right = FREQPLT_ORI_X + FREQPLT_GRID_SIZE_X * (slot + 1);
+
+	alt_up_pixel_buffer_dma_draw_box(pixel_buf, left, 0, right, 199, 0, 0);
+	alt_up_pixel_buffer_dma_draw_box(pixel_buf, left, 201, right, 299, 0, 0);
+}
+
+// Strip chart: the segment ending at sample n is drawn in slot (n - 1) % DISPLAY_SLOTS,
+// so the plots sweep left to right and wrap, and each frame only draws the
+// samples pushed since the last one. The slot after the newest is kept
+// clear to mark where the sweep is.
+static void display_draw_strip(Display *display, const DisplayStatus *status) {
+	alt_up_pixel_buffer_dma_dev *pixel_buf = display->pixel_buf;
+	const short *freq_y = display->freq_y;
+	const short *roc_y = display->roc_y;
+	unsigned int n = display->drawn;
+
+	// Anything older than a screen width has already scrolled off
+	if (display->count - n > DISPLAY_SLOTS) {
+		n = display->count - DISPLAY_SLOTS;
+	}
+	if (n == 0) {
+		n = 1;
+	}
+
+	for (; n < display->count; n++) {
+		int slot = (n - 1) % DISPLAY_SLOTS;
+		int cur = n & DISPLAY_RING_MASK;
+		int prev = (n - 1) & DISPLAY_RING_MASK;
+		int x1 = FREQPLT_ORI_X + FREQPLT_GRID_SIZE_X * slot;
+
+		display_clear_slot(pixel_buf, slot);
+		display_clear_slot(pixel_buf, (slot + 1) % DISPLAY_SLOTS);
+
+		if ((freq_y[prev] != DISPLAY_NO_POINT) && (freq_y[cur] != DISPLAY_NO_POINT)) {
+			alt_up_pixel_buffer_dma_draw_line(pixel_buf, x1, freq_y[prev], x1 + FREQPLT_GRID_SIZE_X, freq_y[cur], 0x3ff << 0, 0);
+			alt_up_pixel_buffer_dma_draw_line(pixel_buf, x1, roc_y[prev], x1 + ROCPLT_GRID_SIZE_X, roc_y[cur], 0x3ff << 0, 0);
+		}
+	}
+	display->drawn = display->count;
+
+	display_text(display->char_buf, status);
+}
+
+// History view: each column of the frequency plot is a bar from the lowest
+// to the highest frequency in its share of the span, with the mean marked.
+// The newest data is at the right; until the history covers the span it
+// fills from the left. Redrawn only once a column's worth of samples has
+// arrived.
+static void display_draw_zoom(Display *display, const DisplayStatus *status) {
+	alt_up_pixel_buffer_dma_dev *pixel_buf = display->pixel_buf;
+	unsigned int span = zoom_spans[display->zoom] * DISPLAY_SAMPLE_RATE;
+	unsigned int count = display->history->count[0];
+	unsigned int first = (count > span) ? count - span : 0;
+	int c;
+
+	if (display->zoom_dirty || (count - display->zoom_drawn >= span / DISPLAY_COLUMNS)) {
+		history_query(display->history, first, first + span, zoom_columns, DISPLAY_COLUMNS);
+		alt_up_pixel_buffer_dma_draw_box(pixel_buf, 101, 0, 639, 199, 0, 0);
+
+		for (c = 0; c < DISPLAY_COLUMNS; c++) {
+			const HistoryBin *column = &zoom_columns[c];
+			int top, bottom, mean;
+
+			if (HISTORY_EMPTY(column)) {
+				continue;
+			}
+			top = freq_row(column->max);
+			bottom = freq_row(column->min);
+			if ((top > 199) || (bottom < 0)) {
+				continue; // Entirely off the plot
+			}
+			alt_up_pixel_buffer_dma_draw_vline(pixel_buf, FREQPLT_ORI_X + c, (top < 0) ? 0 : top, (bottom > 199) ? 199 : bottom, 0x3ff << 0, 0);
+
+			mean = freq_row(column->mean);
+			if ((mean >= 0) && (mean <= 199)) {
+				alt_up_pixel_buffer_dma_draw(pixel_buf, ((0x3ff << 20) + (0x3ff << 10) + (0x3ff)), FREQPLT_ORI_X + c, mean);
+			}
+		}
+		display->zoom_drawn = count;
+		display->zoom_dirty = 0;
+	}
+
+	display_text(display->char_buf, status);
+}
+
+// Redraw both plots and the status text
+void display_draw(Display *display, const DisplayStatus *status) {
+	alt_up_pixel_buffer_dma_dev *pixel_buf = display->pixel_buf;
+	alt_up_char_buffer_dev *char_buf = display->char_buf;
+	const short *freq_y = display->freq_y;
+	const short *roc_y = display->roc_y;
+	unsigned int i = display->count - DISPLAY_POINTS, j;
+	Line line_freq, line_roc;
+
+	if (display->zoom > 0) {
+		display_draw_zoom(display, status);
+		return;
+	}
+	if (display->strip_chart) {
+		display_draw_strip(display, status);
+		return;
+	}
+
+	// Clear old graph to draw new graph
+	alt_up_pixel_buffer_dma_draw_box(pixel_buf, 101, 0, 639, 199, 0, 0);
+	alt_up_pixel_buffer_dma_draw_box(pixel_buf, 101, 201, 639, 299, 0, 0);
+
+	for (j = 0; j < DISPLAY_SLOTS; ++j) { // i here is the oldest sample shown, j loops through all the data to be drawn on VGA
+		int a = (i + j) & DISPLAY_RING_MASK, b = (i + j + 1) & DISPLAY_RING_MASK;
+		if ((freq_y[a] != DISPLAY_NO_POINT) && (freq_y[b] != DISPLAY_NO_POINT)) {
+			// Coordinates of the two data points to draw a line in between
+			// Frequency plot
+			line_freq.x1 = FREQPLT_ORI_X + FREQPLT_GRID_SIZE_X * j;
+			line_freq.y1 = freq_y[a];
+
+			line_freq.x2 = FREQPLT_ORI_X + FREQPLT_GRID_SIZE_X * (j + 1);
+			line_freq.y2 = freq_y[b];
+
+			// Frequency RoC plot
+			line_roc.x1 = ROCPLT_ORI_X + ROCPLT_GRID_SIZE_X * j;
+			line_roc.y1 = roc_y[a];
+
+			line_roc.x2 = ROCPLT_ORI_X + ROCPLT_GRID_SIZE_X * (j + 1);
+			line_roc.y2 = roc_y[b];
+
+			// Draw
+			alt_up_pixel_buffer_dma_draw_line(pixel_buf, line_freq.x1, line_freq.y1, line_freq.x2, line_freq.y2, 0x3ff << 0, 0);
+			alt_up_pixel_buffer_dma_draw_line(pixel_buf, line_roc.x1, line_roc.y1, line_roc.x2, line_roc.y2, 0x3ff << 0, 0);
+
+			// Write dynamic text
+			display_text(char_buf, status);
+		}
+	}
+}
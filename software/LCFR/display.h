@@ -0,0 +1,96 @@
+#ifndef DISPLAY_H_
+#define DISPLAY_H_
+
+#include "altera_up_avalon_video_character_buffer_with_dma.h"
+#include "altera_up_avalon_video_pixel_buffer_dma.h"
+#include "history.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define DISPLAY_POINTS 100		// Frequency samples shown in the plots
+#define DISPLAY_SLOTS (DISPLAY_POINTS - 1)	// Segments across a plot
+#define DISPLAY_RING 128		// Samples kept, a power of two so the ring index is a mask
+#define DISPLAY_RING_MASK (DISPLAY_RING - 1)
+#define DISPLAY_NO_POINT -1		// Plot row of a sample that is not drawn
+
+// Graphs
+#define FREQPLT_ORI_X 101		// X axis pixel position at the plot origin
+#define FREQPLT_GRID_SIZE_X 5	// Pixel separation in the x axis between two data points
+#define FREQPLT_ORI_Y 199.0		// Y axis pixel position at the plot origin
+#define FREQPLT_FREQ_RES 20.0	// Number of pixels per Hz (y axis scale)
+
+#define ROCPLT_ORI_X 101
+#define ROCPLT_GRID_SIZE_X 5
+#define ROCPLT_ORI_Y 259.0
+#define ROCPLT_ROC_RES 0.5		// Number of pixels per Hz/s (y axis scale)
+#define MIN_FREQ 45.0 			// Minimum frequency to draw
+
+// Fixed point plotting: samples are converted to mHz and mHz/s once when
+// pushed, and plot rows are looked up in tables built by display_init from
+// the scales above, so drawing a frame needs no floating point.
+#define FREQ_LUT_MIN 45000		// mHz at the first entry
+#define FREQ_LUT_SHIFT 3		// 8 mHz per entry
+#define FREQ_LUT_SIZE 1280		// Up to 55.24 Hz, above the top of the plot
+#define ROC_LUT_MIN -128000		// mHz/s at the first entry
+#define ROC_LUT_MAX 100000		// RoC is clamped to 100 Hz/s
+#define ROC_LUT_SHIFT 7			// 128 mHz/s per entry
+#define ROC_LUT_SIZE (((ROC_LUT_MAX - ROC_LUT_MIN) >> ROC_LUT_SHIFT) + 1)
+
+// History zoom views, 0 is the live plot
+#define DISPLAY_ZOOM_LEVELS 7
+#define DISPLAY_SAMPLE_RATE 50	// Nominal samples per second, to turn zoom spans into samples
+#define DISPLAY_COLUMNS (640 - FREQPLT_ORI_X)
+
+// Current mode line
+#define DISPLAY_MONITORING 0
+#define DISPLAY_LOAD_MANAGEMENT 1
+#define DISPLAY_MAINTENANCE 2
+
+/*=============*/
+/* Structures. */
+/*=============*/
+// Status text, formatted by the LED task and drawn by the VGA task
+typedef struct {
+	char system_uptime[10];
+	char min_freq[12];
+	char max_roc[12];
+	char min_drop[8];
+	char max_drop[8];
+	char average_drop[12];
+	char freq[5][5];			// Latest 5 frequency measurements, newest first
+	char dfreq[5][5];			// Latest 5 df/dt measurements, newest first
+	int mode;
+} DisplayStatus;
+
+typedef struct {
+	alt_up_pixel_buffer_dma_dev *pixel_buf;
+	alt_up_char_buffer_dev *char_buf;
+	int freq[DISPLAY_RING];		// mHz
+	short freq_y[DISPLAY_RING];	// Frequency plot row, or DISPLAY_NO_POINT below MIN_FREQ
+	short roc_y[DISPLAY_RING];	// RoC plot row
+	unsigned int count;			// Samples pushed since display_init, the newest is at (count - 1) & DISPLAY_RING_MASK
+	int strip_chart;			// Draw only new segments at a moving column instead of redrawing the history
+	unsigned int drawn;			// Samples already on screen in strip chart mode
+	History *history;			// Long-term store for the zoom views, or NULL
+	int zoom;
+	unsigned int zoom_drawn;	// History samples when the zoom view was last drawn
+	int zoom_dirty;				// Zoom view needs drawing whatever the sample count
+} Display;
+
+typedef struct{
+	unsigned int x1;
+	unsigned int y1;
+	unsigned int x2;
+	unsigned int y2;
+} Line;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+void display_init(Display *display, alt_up_pixel_buffer_dma_dev *pixel_buf, alt_up_char_buffer_dev *char_buf, int strip_chart, History *history);
+void display_push(Display *display, int mhz);
+void display_zoom(Display *display, int zoom);
+void display_draw(Display *display, const DisplayStatus *status);
+
+#endif /* DISPLAY_H_ */
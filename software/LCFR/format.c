@@ -0,0 +1,182 @@
+/*===========*/
+/* Includes. */
+/*===========*/
+#include "format.h"
+
+/*===================*/
+/* Global Variables. */
+/*===================*/
+static const int powers_of_ten[FORMAT_MAX_DECIMALS + 1] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+/*============*/
+/* Functions. */
+/*============*/
+// Digits of value, most significant first, with at least min_digits of them
+static int format_digits(char *digits, unsigned int value, int min_digits) {
+	char reversed[10];
+	int n = 0, i;
+
+	do {
+		reversed[n++] = '0' + value % 10;
+		value /= 10;
+	} while ((value != 0) || (n < min_digits));
+
+	for (i = 0; i < n; i++) {
+		digits[i] = reversed[n - 1 - i];
+	}
+	return n;
+}
+
+// Write text[0..len) then suffix, cut to size - 1 characters. Returns the characters written.
+static int format_copy(char *buf, int size, const char *text, int len, const char *suffix) {
+	int n = 0;
+
+	if (size <= 0) {
+		return 0;
+	}
+	while ((n < len) && (n < size - 1)) {
+		buf[n] = text[n];
+		n++;
+	}
+	if (suffix != 0) {
+		while ((*suffix != '\0') && (n < size - 1)) {
+			buf[n++] = *suffix++;
+		}
+	}
+	buf[n] = '\0';
+	return n;
+}
+
+// As snprintf(buf, size, "%s", text)
+int format_text(char *buf, int size, const char *text) {
+	return format_copy(buf, size, 0, 0, text);
+}
+
+// As snprintf(buf, size, "%d<suffix>", value)
+int format_int(char *buf, int size, int value, const char *suffix) {
+	return format_fixed(buf, size, value, 0, suffix);
+}
+
+// value / 10^decimals with exactly decimals digits after the point, as
+// snprintf(buf, size, "%.<decimals>f<suffix>", value / 10^decimals)
+int format_fixed(char *buf, int size, int value, int decimals, const char *suffix) {
+	char text[12];
+	char digits[10];
+	unsigned int magnitude;
+	int len = 0, n, i;
+
+	if (value < 0) {
+		text[len++] = '-';
+		magnitude = 0u - (unsigned int) value;
+	} else {
+		magnitude = value;
+	}
+
+	n = format_digits(digits, magnitude, decimals + 1);
+	for (i = 0; i < n; i++) {
+		if (i == n - decimals) {
+			text[len++] = '.';
+		}
+		text[len++] = digits[i];
+	}
+	return format_copy(buf, size, text, len, suffix);
+}
+
+// Round a value to fixed point with the given decimals (half away from zero)
+// so it can be kept and formatted without floating point. Saturates at the
+// int range.
+int format_scaled(double value, int decimals) {
+	double scaled = value * powers_of_ten[decimals];
+
+	if (scaled >= 2147483647.0) {
+		return 2147483647;
+	} else if (scaled <= -2147483647.0) {
+		return -2147483647;
+	}
+	return (int) ((scaled < 0) ? scaled - 0.5 : scaled + 0.5);
+}
+
+void format_decimal_init(FormatDecimal *decimal) {
+	decimal->mantissa = 0;
+	decimal->fraction_digits = -1;
+	decimal->digits = 0;
+	decimal->invalid = 0;
+	decimal->overflow = 0;
+}
+
+// Add a digit or the point. Digits after the point beyond the one that
+// decides the rounding are counted but not kept.
+void format_decimal_char(FormatDecimal *decimal, char c, int decimals) {
+	if (c == '.') {
+		if (decimal->fraction_digits >= 0) {
+			decimal->invalid = 1;
+		}
+		decimal->fraction_digits = 0;
+		return;
+	}
+	if ((c < '0') || (c > '9')) {
+		decimal->invalid = 1;
+		return;
+	}
+
+	decimal->digits++;
+	if (decimal->fraction_digits > decimals) {
+		return;
+	}
+	if (decimal->mantissa > (4294967295u - 9) / 10) {
+		decimal->overflow = 1;
+		return;
+	}
+	decimal->mantissa = decimal->mantissa * 10 + (c - '0');
+	if (decimal->fraction_digits >= 0) {
+		decimal->fraction_digits++;
+	}
+}
+
+// The entered number in fixed point with the given decimals, rounded half
+// up. Returns -1 if nothing valid was entered or it does not fit an int.
+int format_decimal_value(const FormatDecimal *decimal, int decimals, int *value) {
+	unsigned int mantissa = decimal->mantissa;
+	int fraction_digits = (decimal->fraction_digits < 0) ? 0 : decimal->fraction_digits;
+
+	if ((decimal->digits == 0) || decimal->invalid || decimal->overflow) {
+		return -1;
+	}
+	if (fraction_digits > decimals) {
+		mantissa = (mantissa + 5) / 10; // Only the rounding digit was kept
+	} else if (mantissa > 2147483647u / powers_of_ten[decimals - fraction_digits]) {
+		return -1;
+	} else {
+		mantissa *= powers_of_ten[decimals - fraction_digits];
+	}
+	if (mantissa > 2147483647u) {
+		return -1;
+	}
+	*value = (int) mantissa;
+	return 0;
+}
+
+// A whole string, optionally signed, as a fixed point number with the
+// given decimals, e.g. "-0.25" with 3 decimals is -250. Returns -1 if it
+// isn't a number or does not fit an int.
+int format_parse(const char *text, int decimals, int *value) {
+	FormatDecimal decimal;
+	int negative = (*text == '-');
+
+	if ((*text == '-') || (*text == '+')) {
+		text++;
+	}
+	format_decimal_init(&decimal);
+	while (*text != '\0') {
+		format_decimal_char(&decimal, *text++, decimals);
+	}
+	if (format_decimal_value(&decimal, decimals, value) != 0) {
+		return -1;
+	}
+	if (negative) {
+		*value = -*value;
+	}
+	return 0;
+}
@@ -0,0 +1,43 @@
+#ifndef FORMAT_H_
+#define FORMAT_H_
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+// Integer only decimal formatting for the status text, in place of snprintf
+// with %d and %f, which pulls in newlib's soft-float printf. Values are
+// passed in fixed point: value / 10^decimals, e.g. mHz with 3 decimals.
+// Like snprintf, output is cut to size - 1 characters and always
+// terminated, and nothing is allocated.
+//
+// Decimal text is read back into fixed point the same way: digits are
+// gathered into an integer mantissa with a count of those after the point,
+// and converted once at the end, rounding half up, so "48.5" is exactly
+// 48500 with 3 decimals.
+#define FORMAT_MAX_DECIMALS 9
+
+/*=============*/
+/* Structures. */
+/*=============*/
+// A decimal number being entered, a character at a time
+typedef struct {
+	unsigned int mantissa;		// Digits kept, without the point
+	int fraction_digits;		// Digits kept after the point, -1 before the point
+	int digits;					// Digits entered
+	int invalid;				// A second point or a character that is not a digit
+	int overflow;				// Too many digits before the point
+} FormatDecimal;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+int format_text(char *buf, int size, const char *text);
+int format_int(char *buf, int size, int value, const char *suffix);
+int format_fixed(char *buf, int size, int value, int decimals, const char *suffix);
+int format_scaled(double value, int decimals);
+void format_decimal_init(FormatDecimal *decimal);
+void format_decimal_char(FormatDecimal *decimal, char c, int decimals);
+int format_decimal_value(const FormatDecimal *decimal, int decimals, int *value);
+int format_parse(const char *text, int decimals, int *value);
+
+#endif /* FORMAT_H_ */
@@ -0,0 +1,112 @@
+/*===========*/
+/* Includes. */
+/*===========*/
+#include "history.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define HISTORY_MASK (HISTORY_CAPACITY - 1)
+
+/*============*/
+/* Functions. */
+/*============*/
+void history_init(History *history) {
+	int k;
+	for (k = 0; k < HISTORY_LEVELS; k++) {
+		history->count[k] = 0; // The bins are only read once written
+	}
+}
+
+// Append a sample in mHz. Every second entry at a level completes an entry
+// at the next, so a push costs one entry on average.
+void history_push(History *history, int freq) {
+	HistoryBin bin;
+	int k;
+
+	bin.min = (freq < 0) ? 0 : (freq > 65535) ? 65535 : freq;
+	bin.max = bin.min;
+	bin.mean = bin.min;
+
+	for (k = 0; k < HISTORY_LEVELS; k++) {
+		unsigned int i = history->count[k]++;
+		history->bins[k][i & HISTORY_MASK] = bin;
+		if (((i & 1) == 0) || (k == HISTORY_LEVELS - 1)) {
+			break;
+		}
+
+		// Combine with the entry before it for the next level
+		const HistoryBin *pair = &history->bins[k][(i - 1) & HISTORY_MASK];
+		if (pair->min < bin.min) {
+			bin.min = pair->min;
+		}
+		if (pair->max > bin.max) {
+			bin.max = pair->max;
+		}
+		bin.mean = (pair->mean + bin.mean + 1) >> 1;
+	}
+}
+
+// Summarise samples [first, last) of the history (sample 0 is the first ever
+// pushed) into width columns of min, max and mean. Each column is built from
+// the largest whole entries inside it, so a column costs O(HISTORY_LEVELS)
+// entries whatever the span. Where the finer levels have been overwritten the
+// oldest columns use the coarser entry around them. Columns with no samples,
+// before the first or after the latest, are left empty (min > max). Returns
+// the number of non-empty columns.
+int history_query(const History *history, unsigned int first, unsigned int last, HistoryBin *columns, int width) {
+	unsigned long long span = last - first;
+	int c, filled = 0;
+
+	for (c = 0; c < width; c++) {
+		unsigned int s = first + (unsigned int) (span * c / width);
+		unsigned int e = first + (unsigned int) (span * (c + 1) / width);
+		unsigned long long sum = 0, weight = 0;
+		HistoryBin *column = &columns[c];
+
+		column->min = 0xFFFF;
+		column->max = 0;
+		column->mean = 0;
+
+		while (s < e) {
+			unsigned int index;
+			int k = 0;
+
+			// Widest aligned entry starting at s that fits in the column and has been completed
+			while ((k + 1 < HISTORY_LEVELS) && ((s & ((2u << k) - 1)) == 0) && (e - s >= (2u << k))
+					&& ((s >> (k + 1)) < history->count[k + 1])) {
+				k++;
+			}
+			index = s >> k;
+			if (index >= history->count[k]) {
+				break; // Not sampled yet
+			}
+			// Overwritten: fall back to coarser entries
+			while ((history->count[k] - index > HISTORY_CAPACITY) && (k + 1 < HISTORY_LEVELS)) {
+				k++;
+				index = s >> k;
+			}
+			if (history->count[k] - index <= HISTORY_CAPACITY) {
+				const HistoryBin *bin = &history->bins[k][index & HISTORY_MASK];
+				if (bin->min < column->min) {
+					column->min = bin->min;
+				}
+				if (bin->max > column->max) {
+					column->max = bin->max;
+				}
+				sum += (unsigned long long) bin->mean << k;
+				weight += 1ull << k;
+			}
+			s = (index + 1) << k;
+			if (s == 0) {
+				break; // Wrapped past the last sample index
+			}
+		}
+
+		if (weight > 0) {
+			column->mean = (unsigned short) ((sum + weight / 2) / weight);
+			filled++;
+		}
+	}
+	return filled;
+}
@@ -0,0 +1,37 @@
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+// Long-term frequency history for the VGA zoom views. Level 0 holds raw
+// samples, level k holds the min, max and mean of each aligned run of 2^k
+// samples. Every level is a ring of the same capacity, so the raw samples
+// cover the last 43 minutes at 50 Hz and level 16 covers about five years.
+// About 13 MB, in SDRAM (.bss).
+#define HISTORY_LEVELS 17
+#define HISTORY_CAPACITY (1 << 17)		// Entries per level, a power of two
+#define HISTORY_EMPTY(bin) ((bin)->min > (bin)->max)
+
+/*=============*/
+/* Structures. */
+/*=============*/
+typedef struct {
+	unsigned short min;			// mHz, 0 to 65.535 Hz
+	unsigned short max;
+	unsigned short mean;
+} HistoryBin;
+
+typedef struct {
+	unsigned int count[HISTORY_LEVELS];	// Entries ever written to each level
+	HistoryBin bins[HISTORY_LEVELS][HISTORY_CAPACITY];
+} History;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+void history_init(History *history);
+void history_push(History *history, int freq);
+int history_query(const History *history, unsigned int first, unsigned int last, HistoryBin *columns, int width);
+
+#endif /* HISTORY_H_ */
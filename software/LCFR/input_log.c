@@ -0,0 +1,28 @@
+/*===========*/
+/* Includes. */
+/*===========*/
+#include "input_log.h"
+
+/*============*/
+/* Functions. */
+/*============*/
+#if INPUT_LOG
+void input_log_init(InputLog *log) {
+	log->magic = INPUT_LOG_MAGIC;
+	log->capacity = INPUT_LOG_CAPACITY;
+	log->count = 0;
+	log->dropped = 0;
+}
+
+// Callers must not be interrupted by another recorder, so tasks call this inside a critical section.
+// Once full, the log keeps the start of the capture since replay has to begin from power-on state.
+void input_log_record(InputLog *log, unsigned int type, unsigned int value, unsigned int time) {
+	if (log->count < log->capacity) {
+		log->events[log->count].time = time;
+		log->events[log->count].event = (type << 24) | (value & 0xffffff);
+		log->count++;
+	} else {
+		log->dropped++;
+	}
+}
+#endif /* INPUT_LOG */
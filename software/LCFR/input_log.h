@@ -0,0 +1,61 @@
+#ifndef INPUT_LOG_H_
+#define INPUT_LOG_H_
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+// Every input the relay reacts to, in the order it reacted to them, so a
+// host build can replay a field capture and reproduce the shed timeline.
+// The log lives in SDRAM (.bss); pull it off the board by halting and
+// dumping input_log from nios2-elf-gdb:
+//   dump binary memory inputs.bin &input_log ((char *) &input_log) + sizeof(input_log)
+// Both settings can be given in the Makefile's APP_CFLAGS_DEFINED_SYMBOLS.
+// INPUT_LOG=0 leaves the log and its buffer out of the build. At one
+// frequency sample and one decision cycle every 20 ms the default capacity
+// (2 MB) holds about 40 minutes; -DINPUT_LOG_CAPACITY=9437184 (72 MB)
+// holds about 25 hours for a field capture.
+#ifndef INPUT_LOG
+#define INPUT_LOG 1
+#endif
+#ifndef INPUT_LOG_CAPACITY
+#define INPUT_LOG_CAPACITY (256 * 1024)
+#endif
+#define INPUT_LOG_MAGIC 0x474f4c49	// "ILOG"
+
+// Event types, value is in the low 24 bits
+#define INPUT_FREQ 1		// Frequency analyser sample count
+#define INPUT_DECIDE 2		// Decision cycle, with the slide switch value it read
+#define INPUT_BUTTON 3		// Push button edge capture (maintenance toggle)
+#define INPUT_PS2 4			// Keyboard byte
+
+#define INPUT_TYPE(event) ((event)->event >> 24)
+#define INPUT_VALUE(event) ((event)->event & 0xffffff)
+
+/*=============*/
+/* Structures. */
+/*=============*/
+typedef struct {
+	unsigned int time;			// Milliseconds (ticks)
+	unsigned int event;			// type << 24 | value
+} InputEvent;
+
+typedef struct {
+	unsigned int magic;
+	unsigned int capacity;
+	unsigned int count;
+	unsigned int dropped;		// Events lost after the log filled up
+	InputEvent events[INPUT_LOG_CAPACITY];
+} InputLog;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+#if INPUT_LOG
+void input_log_init(InputLog *log);
+void input_log_record(InputLog *log, unsigned int type, unsigned int value, unsigned int time);
+#else
+#define input_log_init(log) ((void) 0)
+#define input_log_record(log, type, value, time) ((void) 0)
+#endif
+
+#endif /* INPUT_LOG_H_ */
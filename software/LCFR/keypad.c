@@ -0,0 +1,178 @@
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <string.h>
+
+#include "keypad.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define KEYPAD_RING_MASK (KEYPAD_RING_CAPACITY - 1)
+#define KEYPAD_RING_BARRIER() __asm__ __volatile__ ("" : : : "memory")	// As MESSAGE_LOG_BARRIER
+
+// Scancode decoder states
+#define SCAN_IDLE 0
+#define SCAN_BREAK 1				// After F0, the next code is a release
+#define SCAN_EXTENDED 2				// After E0
+#define SCAN_EXTENDED_BREAK 3		// After E0 F0
+#define SCAN_STATES 4
+
+// Byte classes
+#define SCAN_CODE 0
+#define SCAN_PREFIX_BREAK 1
+#define SCAN_PREFIX_EXTENDED 2
+#define SCAN_CLASSES 3
+
+// What a byte does in a state
+#define SCAN_NONE 0					// Prefix, or a release
+#define SCAN_MAKE 1					// A key press
+#define SCAN_MAKE_EXTENDED 2		// An extended key press
+
+/*=============*/
+/* Structures. */
+/*=============*/
+typedef struct {
+	unsigned char next;
+	unsigned char action;
+} ScanTransition;
+
+/*===================*/
+/* Global Variables. */
+/*===================*/
+// Scancode set 2. A stray prefix after F0 starts over rather than being
+// taken as a key.
+static const ScanTransition scan_table[SCAN_STATES][SCAN_CLASSES] = {
+	//                      code                         F0                              E0
+	/* SCAN_IDLE */ { { SCAN_IDLE, SCAN_MAKE }, { SCAN_BREAK, SCAN_NONE }, { SCAN_EXTENDED, SCAN_NONE } },
+	/* SCAN_BREAK */ { { SCAN_IDLE, SCAN_NONE }, { SCAN_BREAK, SCAN_NONE }, { SCAN_EXTENDED, SCAN_NONE } },
+	/* SCAN_EXTENDED */ { { SCAN_IDLE, SCAN_MAKE_EXTENDED }, { SCAN_EXTENDED_BREAK, SCAN_NONE }, { SCAN_EXTENDED, SCAN_NONE } },
+	/* SCAN_EXTENDED_BREAK */ { { SCAN_IDLE, SCAN_NONE }, { SCAN_BREAK, SCAN_NONE }, { SCAN_EXTENDED, SCAN_NONE } },
+};
+
+// Make codes to keys, anything not listed is KEY_OTHER
+static const unsigned char scan_keys[256] = {
+	[PS2_0] = KEY_DIGIT + 0, [PS2_1] = KEY_DIGIT + 1, [PS2_2] = KEY_DIGIT + 2, [PS2_3] = KEY_DIGIT + 3,
+	[PS2_4] = KEY_DIGIT + 4, [PS2_5] = KEY_DIGIT + 5, [PS2_6] = KEY_DIGIT + 6, [PS2_7] = KEY_DIGIT + 7,
+	[PS2_8] = KEY_DIGIT + 8, [PS2_9] = KEY_DIGIT + 9, [PS2_DP] = KEY_POINT, [PS2_ENTER] = KEY_ENTER,
+	[PS2_PLUS] = KEY_PLUS, [PS2_MINUS] = KEY_MINUS,
+};
+
+static const unsigned char scan_extended_keys[256] = {
+	[PS2_ENTER] = KEY_ENTER,		// Keypad ENTER
+};
+
+
+/*============*/
+/* Functions. */
+/*============*/
+void keypad_init(Keypad *keypad) {
+	memset(keypad, 0, sizeof(Keypad));
+	format_decimal_init(&keypad->input);
+}
+
+// Store the number typed as the threshold being entered, in one conversion
+// to fixed point
+static int keypad_enter(Keypad *keypad, Relay *relay) {
+	int value;
+
+	if (format_decimal_value(&keypad->input, RELAY_DECIMALS, &value) != 0) {
+		return KEYPAD_REFUSED;
+	}
+	if (keypad->desired_flag == 0) {
+		if ((value <= 0) || (value > RELAY_MIN_FREQ_LIMIT)) {
+			return KEYPAD_REFUSED;
+		}
+		relay->desired_min_mhz = value;
+		keypad->desired_flag = 1;
+		return KEYPAD_SET_MIN_FREQ;
+	}
+	if ((value <= 0) || (value > RELAY_MAX_ROC_LIMIT)) {
+		return KEYPAD_REFUSED;
+	}
+	relay->desired_max_roc_mhz = value;
+	keypad->desired_flag = 0;
+	return KEYPAD_SET_MAX_ROC;
+}
+
+// Act on one key press
+static int keypad_key(Keypad *keypad, Relay *relay, int key) {
+	int result;
+
+	switch (key) {
+		case KEY_ENTER:
+			result = keypad_enter(keypad, relay);
+			format_decimal_init(&keypad->input); // Clear number
+			return result;
+		case KEY_PLUS:
+			return KEYPAD_ZOOM_OUT;
+		case KEY_MINUS:
+			return KEYPAD_ZOOM_IN;
+		case KEY_POINT:
+			if (keypad->input.fraction_digits < 0) {
+				format_decimal_char(&keypad->input, '.', RELAY_DECIMALS);
+				return KEYPAD_NONE;
+			}
+			format_decimal_char(&keypad->input, '0', RELAY_DECIMALS); // A second decimal point is entered as a 0
+			return KEYPAD_NONE;
+		case KEY_OTHER:
+			format_decimal_char(&keypad->input, '0', RELAY_DECIMALS);
+			return KEYPAD_NONE;
+		default:
+			format_decimal_char(&keypad->input, '0' + key - KEY_DIGIT, RELAY_DECIMALS);
+			return KEYPAD_NONE;
+	}
+}
+
+// Feed one byte from the keyboard. Returns KEYPAD_SET_MIN_FREQ or KEYPAD_SET_MAX_ROC when ENTER stored a value in relay,
+// KEYPAD_REFUSED when it did not, or KEYPAD_ZOOM_OUT/IN for the history view keys. Releases and prefixes are consumed by
+// the scancode state machine.
+int keypad_byte(Keypad *keypad, Relay *relay, unsigned char byte) {
+	int class = (byte == PS2_KEYRELEASE) ? SCAN_PREFIX_BREAK : (byte == PS2_EXTENDED) ? SCAN_PREFIX_EXTENDED : SCAN_CODE;
+	const ScanTransition *transition = &scan_table[keypad->scan_state][class];
+
+	keypad->scan_state = transition->next;
+	switch (transition->action) {
+		case SCAN_MAKE:
+			return keypad_key(keypad, relay, scan_keys[byte]);
+		case SCAN_MAKE_EXTENDED:
+			return keypad_key(keypad, relay, scan_extended_keys[byte]);
+		default:
+			return KEYPAD_NONE;
+	}
+}
+
+void keypad_ring_init(KeypadRing *ring) {
+	ring->head = 0;
+	ring->tail = 0;
+	ring->dropped = 0;
+}
+
+// ISR side. Returns -1 and counts the byte as dropped if the ring is full.
+int keypad_ring_put(KeypadRing *ring, unsigned char byte) {
+	unsigned int head = ring->head;
+
+	if (head - ring->tail >= KEYPAD_RING_CAPACITY) {
+		ring->dropped++;
+		return -1;
+	}
+	ring->bytes[head & KEYPAD_RING_MASK] = byte;
+	KEYPAD_RING_BARRIER();
+	ring->head = head + 1;
+	return 0;
+}
+
+// Task side. Returns -1 if the ring is empty.
+int keypad_ring_get(KeypadRing *ring, unsigned char *byte) {
+	unsigned int tail = ring->tail;
+
+	if (tail == ring->head) {
+		return -1;
+	}
+	KEYPAD_RING_BARRIER();
+	*byte = ring->bytes[tail & KEYPAD_RING_MASK];
+	KEYPAD_RING_BARRIER();
+	ring->tail = tail + 1;
+	return 0;
+}
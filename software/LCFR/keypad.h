@@ -0,0 +1,77 @@
+#ifndef KEYPAD_H_
+#define KEYPAD_H_
+
+#include "relay.h"
+#include "format.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+// Keyboard
+#define PS2_1 0x69
+#define PS2_2 0x72
+#define PS2_3 0x7A
+#define PS2_4 0x6B
+#define PS2_5 0x73
+#define PS2_6 0x74
+#define PS2_7 0x6C
+#define PS2_8 0x75
+#define PS2_9 0x7D
+#define PS2_0 0x70
+#define PS2_dp 0x71
+#define PS2_ENTER 0x5A
+#define PS2_DP 0x71
+#define PS2_PLUS 0x79		// Keypad +
+#define PS2_MINUS 0x7B		// Keypad -
+#define PS2_KEYRELEASE 0xF0
+#define PS2_EXTENDED 0xE0	// Prefix of keypad ENTER and the other extended keys
+
+// Keys after scancode decoding
+#define KEY_OTHER 0			// No meaning on the keypad, entered as the digit 0
+#define KEY_POINT 1
+#define KEY_ENTER 2			// Either ENTER key
+#define KEY_PLUS 3
+#define KEY_MINUS 4
+#define KEY_DIGIT 0x10		// KEY_DIGIT + n is the digit n
+
+// Results of keypad_byte
+#define KEYPAD_NONE 0
+#define KEYPAD_SET_MIN_FREQ 1
+#define KEYPAD_SET_MAX_ROC 2
+#define KEYPAD_ZOOM_OUT 3		// Keypad + pressed, number entry is unaffected
+#define KEYPAD_ZOOM_IN 4		// Keypad - pressed
+#define KEYPAD_REFUSED 5		// ENTER with no number or one out of range, the same threshold is entered next
+
+// Scancode bytes in flight from ps2_isr to the decoder task, a power of two.
+// A keystroke is at most 3 bytes.
+#define KEYPAD_RING_CAPACITY 64
+
+/*=============*/
+/* Structures. */
+/*=============*/
+// Number entry state for the maintenance mode keypad
+typedef struct {
+	int scan_state;				// Position in a make/break/extended scancode sequence
+	FormatDecimal input;		// Number typed so far
+	int desired_flag;			// 0 for the minimum frequency, 1 for the maximum rate of change
+} Keypad;
+
+// Raw scancodes from the PS/2 ISR, which only writes head and dropped, to
+// the decoder task, which only writes tail
+typedef struct {
+	volatile unsigned int head;
+	volatile unsigned int tail;
+	volatile unsigned int dropped;	// Bytes lost to a full ring
+	unsigned char bytes[KEYPAD_RING_CAPACITY];
+} KeypadRing;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+void keypad_init(Keypad *keypad);
+int keypad_byte(Keypad *keypad, Relay *relay, unsigned char byte);
+void keypad_ring_init(KeypadRing *ring);
+int keypad_ring_put(KeypadRing *ring, unsigned char byte);
+int keypad_ring_get(KeypadRing *ring, unsigned char *byte);
+
+#endif /* KEYPAD_H_ */
@@ -0,0 +1,89 @@
+/*===========*/
+/* Includes. */
+/*===========*/
+#include "message_log.h"
+#include "format.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define MESSAGE_LOG_MASK (MESSAGE_LOG_CAPACITY - 1)
+
+// Keeps the compiler from moving message stores past the index update that
+// publishes them. One core, so nothing else can reorder them.
+#define MESSAGE_LOG_BARRIER() __asm__ __volatile__ ("" : : : "memory")
+
+/*============*/
+/* Functions. */
+/*============*/
+void message_log_init(MessageLog *log) {
+	log->head = 0;
+	log->tail = 0;
+	log->dropped = 0;
+	log->dropped_reported = 0;
+}
+
+// Producer side. Returns -1 and counts the message as dropped if the ring is full.
+int message_log_post(MessageLog *log, int id, int a, int b, unsigned int time) {
+	unsigned int head = log->head;
+
+	if (head - log->tail >= MESSAGE_LOG_CAPACITY) {
+		log->dropped++;
+		return -1;
+	}
+	Message *message = &log->messages[head & MESSAGE_LOG_MASK];
+	message->time = time;
+	message->id = id;
+	message->a = a;
+	message->b = b;
+	MESSAGE_LOG_BARRIER();
+	log->head = head + 1;
+	return 0;
+}
+
+// Drain side. Oldest message not yet taken, or NULL if the ring is empty.
+const Message *message_log_peek(const MessageLog *log) {
+	unsigned int tail = log->tail;
+
+	if (tail == log->head) {
+		return 0;
+	}
+	MESSAGE_LOG_BARRIER();
+	return &log->messages[tail & MESSAGE_LOG_MASK];
+}
+
+// Drain side. Frees the slot returned by message_log_peek.
+void message_log_take(MessageLog *log) {
+	MESSAGE_LOG_BARRIER();
+	log->tail = log->tail + 1;
+}
+
+// Message text, with its newline, in the wording the firmware printed before
+int message_log_format(const Message *message, char *buf, int size) {
+	const char *text;
+	int n = 0;
+
+	switch (message->id) {
+		case MESSAGE_MAINTENANCE_ENABLED:
+			return format_text(buf, size, "Maintenance Mode Enabled\n");
+		case MESSAGE_MAINTENANCE_DISABLED:
+			return format_text(buf, size, "Maintenance Mode Disabled\n");
+		case MESSAGE_MIN_FREQ_SET:
+			text = "The preferred minimum frequency was set to: ";
+			break;
+		case MESSAGE_MAX_ROC_SET:
+			text = "The preferred maximum rate of change of frequency was set to: ";
+			break;
+		case MESSAGE_DROP_TIME:
+			n = format_text(buf, size, "Drop Time: ");
+			return n + format_int(buf + n, size - n, message->a, " ms\n");
+		case MESSAGE_ENTRY_REFUSED:
+			return format_text(buf, size, (message->a == 0) ? "Refused, enter a minimum frequency up to 65 Hz\n"
+					: "Refused, enter a maximum rate of change up to 1000 Hz/s\n");
+		default:
+			n = format_text(buf, size, "Unknown message ");
+			return n + format_int(buf + n, size - n, message->id, "\n");
+	}
+	n = format_text(buf, size, text);
+	return n + format_fixed(buf + n, size - n, message->a, 3, "\n");
+}
@@ -0,0 +1,51 @@
+#ifndef MESSAGE_LOG_H_
+#define MESSAGE_LOG_H_
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+// Deferred console messages. Producers, ISRs included, post a message ID
+// and two integer arguments in constant time and never wait; a low priority
+// task formats them and does the blocking JTAG UART writes. Each producer
+// posts to its own ring, which only it writes and only the drain task
+// reads, so no locks or atomic instructions are needed. Messages that do
+// not fit are dropped and counted.
+#define MESSAGE_LOG_CAPACITY 32		// Messages per ring, a power of two
+#define MESSAGE_LOG_LINE 80			// Longest formatted message, with its newline
+
+// Message IDs
+#define MESSAGE_MAINTENANCE_ENABLED 1
+#define MESSAGE_MAINTENANCE_DISABLED 2
+#define MESSAGE_MIN_FREQ_SET 3		// a: mHz
+#define MESSAGE_MAX_ROC_SET 4		// a: mHz/s
+#define MESSAGE_DROP_TIME 5			// a: ms
+#define MESSAGE_ENTRY_REFUSED 6		// a: 0 for the minimum frequency, 1 for the maximum rate of change
+
+/*=============*/
+/* Structures. */
+/*=============*/
+typedef struct {
+	unsigned int time;			// Ticks when posted
+	int id;
+	int a;
+	int b;
+} Message;
+
+typedef struct {
+	volatile unsigned int head;		// Messages ever posted, written by the producer
+	volatile unsigned int tail;		// Messages ever taken, written by the drain task
+	volatile unsigned int dropped;	// Messages lost to a full ring, written by the producer
+	unsigned int dropped_reported;	// Written by the drain task
+	Message messages[MESSAGE_LOG_CAPACITY];
+} MessageLog;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+void message_log_init(MessageLog *log);
+int message_log_post(MessageLog *log, int id, int a, int b, unsigned int time);
+const Message *message_log_peek(const MessageLog *log);
+void message_log_take(MessageLog *log);
+int message_log_format(const Message *message, char *buf, int size);
+
+#endif /* MESSAGE_LOG_H_ */
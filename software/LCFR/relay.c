@@ -0,0 +1,223 @@
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stddef.h>
+#include <string.h>
+
+#include "relay.h"
+
+/*============*/
+/* Functions. */
+/*============*/
+// Drop the lowest priority load that is still connected
+static void relay_drop_load(Relay *relay) {
+	int i;
+	for (i = RELAY_NUM_LOADS - 1; i > 0; i--) {
+		if (relay->loads[i] == 1) {
+			relay->loads[i] = 0;
+			relay->shed_count += 1;
+			relay->shed_mask |= RELAY_SWITCH_BIT(i);
+			return;
+		}
+	}
+	if (relay->loads[0] == 1) {
+		relay->shed_count += 1;
+		relay->shed_mask |= RELAY_SWITCH_BIT(0);
+	}
+	relay->loads[0] = 0;
+}
+
+// Reconnect the highest priority load that is shed but switched on
+static void relay_reconnect_load(Relay *relay) {
+	int i;
+	for (i = 0; i < RELAY_NUM_LOADS; i++) {
+		if ((relay->loads[i] == 0) && (relay->switches[i] == 1)) {
+			relay->loads[i] = 1;
+			relay->shed_mask &= ~RELAY_SWITCH_BIT(i);
+			return;
+		}
+	}
+}
+
+void relay_init(Relay *relay) {
+	int i;
+	memset(relay, 0, sizeof(Relay));
+
+	relay->desired_max_roc_mhz = 8000;
+	relay->desired_min_mhz = 48500;
+	relay->predict_mode = PREDICT_OFF;		// Shedding on prediction false trips often, see sweep -m
+	relay->predict_horizon_ms = 200;
+	relay->stability_window = STABILITY_WINDOW;
+
+	for (i = 0; i < RELAY_NUM_LOADS; i++) {
+		relay->loads[i] = 1;
+		relay->switches[i] = 1;
+	}
+	relay->switch_value = (1u << RELAY_NUM_LOADS) - 1;
+}
+
+// Returns 1 if the projected time for the frequency to fall to desired_min_mhz at the current roc is within the horizon
+int relay_is_predicted_unstable(const Relay *relay) {
+	if (relay->roc_mhz >= 0 || relay->signal_mhz <= relay->desired_min_mhz) {
+		return 0; // Not falling, or already crossed
+	}
+	// (signal - min) / -roc < horizon, with the mHz difference scaled to match the ms horizon
+	return (long long) (relay->signal_mhz - relay->desired_min_mhz) * 1000 < (long long) relay->predict_horizon_ms * -relay->roc_mhz;
+}
+
+// Returns 1 if the latest measurement should be treated as unstable
+int relay_is_unstable(const Relay *relay) {
+	int roc = (relay->roc_mhz < 0) ? -relay->roc_mhz : relay->roc_mhz;
+
+	if (roc > relay->desired_max_roc_mhz || relay->desired_min_mhz > relay->signal_mhz) {
+		return 1;
+	}
+	if (relay->predict_mode == PREDICT_SHED) {
+		return relay_is_predicted_unstable(relay);
+	}
+	return 0;
+}
+
+// Start from a steady frequency instead of 0 Hz, so the first sample is not
+// taken as a jump
+void relay_set_frequency(Relay *relay, double freq) {
+	relay->signal_mhz = (int) (freq * 1000 + 0.5);
+	relay->signal_uhz = (long long) (freq * 1000000 + 0.5);
+}
+
+// The latest measurement in Hz and Hz/s, for host tools; the firmware only
+// uses the fixed point fields
+double relay_signal_freq(const Relay *relay) {
+	return relay->signal_mhz / 1000.0;
+}
+
+double relay_roc_freq(const Relay *relay) {
+	return relay->roc_mhz / 1000.0;
+}
+
+// Takes the sample count between the two most recent peaks, now is in
+// milliseconds. Runs in the frequency analyser ISR, so it is all integer.
+// roc is f * (f - f_previous) with f = SAMPLE_FREQ / count, which in mHz/s
+// is SAMPLE_FREQ * (SAMPLE_FREQ * 10^6 - previous_uhz * count) /
+// (1000 * count^2). Counts are capped at 16 bits (0.24 Hz) to keep it in 64
+// bits, and SAMPLE_FREQ is a whole number of kHz.
+void relay_measure(Relay *relay, unsigned int sample_count, unsigned int now) {
+	if (sample_count > 0) {
+		unsigned int count = (sample_count > 0xffff) ? 0xffff : sample_count;
+		long long difference = SAMPLE_FREQ * 1000000ll - relay->signal_uhz * count; // Before signal_uhz is replaced
+		long long numerator = ((difference < 0) ? -difference : difference) * (SAMPLE_FREQ / 1000);
+		long long roc = (numerator + count * count / 2) / (count * count);
+
+		if (roc > 2147483647) {
+			roc = 2147483647;
+		}
+		relay->roc_mhz = (difference < 0) ? -(int) roc : (int) roc;
+		relay->signal_mhz = (SAMPLE_FREQ * 1000 + count / 2) / count; // 32-bit divide
+		relay->signal_uhz = (SAMPLE_FREQ * 1000000ll + count / 2) / count;
+	}
+
+	// Start timing the drop delay on the first unstable measurement
+	if ((relay->first_load_shed == 0) && (relay->drop_delay_flag == 0)) {
+		if (relay_is_unstable(relay)) {
+			relay->drop_delay_flag = 1;
+			relay->drop_delay_start = now;
+		}
+	}
+}
+
+void relay_set_maintenance(Relay *relay, int maintenance) {
+	relay->maintenance = maintenance;
+	if (maintenance == 0) {
+		relay->drop_delay_flag = 0;
+	}
+}
+
+// One decision cycle. Returns the drop delay in milliseconds if a timed first load shed happened, otherwise -1
+int relay_step(Relay *relay, unsigned int switch_value, unsigned int now) {
+	int i;
+	int drop_delay = -1;
+	unsigned int masked_switch_value = switch_value & 0x000ff;
+	unsigned int changed = masked_switch_value ^ relay->switch_value;
+
+	// Switch Load Management, only for the switches that moved since the last cycle
+	for (i = 0; changed != 0; i++, changed >>= 1) {
+		if (changed & 1) {
+			int load = RELAY_NUM_LOADS - 1 - i;
+			if (masked_switch_value & (1u << i)) { // Switched on, its load stays off until reconnected
+				relay->switches[load] = 1;
+				relay->shed_mask |= 1u << i;
+			} else { // Switched off
+				relay->switches[load] = 0;
+				relay->loads[load] = 0;
+				relay->shed_mask &= ~(1u << i);
+			}
+		}
+	}
+	relay->switch_value = masked_switch_value;
+
+	if (relay->shed_mask == 0) { // If all available loads are connected, we are not managing loads.
+		relay->first_load_shed = 0;
+	} else if (relay->maintenance == 1) { // Maintenance connects every switched on load
+		for (i = 0; i < RELAY_NUM_LOADS; i++) {
+			if (relay->shed_mask & RELAY_SWITCH_BIT(i)) {
+				relay->loads[i] = 1;
+			}
+		}
+		relay->shed_mask = 0;
+	}
+
+	// Frequency Load Management
+	if (relay->maintenance == 0) {
+		if (relay_is_unstable(relay)) { // If the current system is unstable
+			if (relay->first_load_shed == 0) { // Drop a load, if we have no dropped loads. First load drop.
+				relay->first_load_shed = 1;
+				relay_drop_load(relay);
+
+				// Timing Drop Delay
+				if (relay->drop_delay_flag == 1) {
+					drop_delay = (int) (now - relay->drop_delay_start);
+
+					// Set min and max
+					if (drop_delay > relay->max_drop_delay) {
+						relay->max_drop_delay = drop_delay;
+					}
+					if (((drop_delay < relay->min_drop_delay) && (drop_delay != 0)) || (relay->min_drop_delay == 0)) {
+						relay->min_drop_delay = drop_delay;
+					}
+
+					// Calculate accumulated average, in hundredths of a ms rounded half up
+					if (relay->drop_average == 0) {
+						relay->drop_average = drop_delay * 100;
+					} else {
+						relay->drop_average = (relay->drop_average + drop_delay * 100 + 1) / 2;
+					}
+
+					relay->drop_delay_flag = 0;
+				}
+			} else {
+				relay->recon_window = 0; // No longer a continuous run of stable data
+
+				if (relay->drop_window == 0) { // Start timing a continuous run of unstable data
+					relay->drop_window = 1;
+					relay->drop_window_start = now;
+				} else if ((now - relay->drop_window_start) >= relay->stability_window) {
+					relay_drop_load(relay);
+				}
+			}
+		} else {
+			relay->drop_window = 0; // No longer a continuous run of unstable data
+
+			if ((relay->predict_mode == PREDICT_ARM) && relay_is_predicted_unstable(relay)) { // Heading for a crossing, don't reconnect into it
+				relay->recon_window = 0;
+			} else if (relay->recon_window == 0) { // Start timing a continuous run of stable data
+				relay->recon_window = 1;
+				relay->recon_window_start = now;
+			} else if ((now - relay->recon_window_start) >= relay->stability_window) {
+				relay_reconnect_load(relay);
+			}
+		}
+	}
+
+	return drop_delay;
+}
@@ -0,0 +1,79 @@
+#ifndef RELAY_H_
+#define RELAY_H_
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define SAMPLE_FREQ 				16000
+#define RELAY_NUM_LOADS 			8
+#define RELAY_SWITCH_BIT(load)		(1u << (RELAY_NUM_LOADS - 1 - (load)))	// Load 0, the highest priority, is switch 7
+#define STABILITY_WINDOW 			500 // Milliseconds of continuous (in)stability before the next drop/reconnect
+
+// Thresholds are kept in fixed point, mHz and mHz/s, and tested against
+// fixed point copies of each measurement, so deciding needs no floating
+// point. Entries from the keypad and console are limited to these.
+#define RELAY_DECIMALS				3
+#define RELAY_MIN_FREQ_LIMIT		65000		// mHz
+#define RELAY_MAX_ROC_LIMIT			1000000		// mHz/s
+#define RELAY_HORIZON_LIMIT			10000		// ms
+
+// Predictive shedding
+#define PREDICT_OFF 0			// Only react once a threshold has been crossed
+#define PREDICT_ARM 1			// A predicted crossing holds off load reconnection
+#define PREDICT_SHED 2			// A predicted crossing is treated as unstable
+
+/*=============*/
+/* Structures. */
+/*=============*/
+// All of the state of one frequency relay. Nothing in relay.c touches globals,
+// so any number of these can be stepped independently.
+typedef struct {
+	// Configurations
+	int desired_max_roc_mhz;	// mHz/s
+	int desired_min_mhz;		// mHz
+	int predict_mode;
+	unsigned int predict_horizon_ms;	// Extrapolation before a crossing counts
+	unsigned int stability_window;
+
+	// Data
+	int signal_mhz;				// Latest measurement, see relay_signal_freq()
+	int roc_mhz;				// mHz/s, saturated at the int range
+	long long signal_uhz;		// Finer, so roc_mhz is not thrown off by rounding signal_mhz
+	int loads[RELAY_NUM_LOADS];
+	int switches[RELAY_NUM_LOADS];
+	unsigned int switch_value;	// Switches as last processed, bit 7 - i is switches[i]
+	unsigned int shed_mask;		// Loads switched on but disconnected, in the same bits
+
+	// Flags
+	int first_load_shed;
+	int maintenance;
+
+	// Stability windows
+	int drop_window;
+	int recon_window;
+	unsigned int drop_window_start;
+	unsigned int recon_window_start;
+
+	// Statistics
+	int drop_delay_flag;
+	unsigned int drop_delay_start;
+	int min_drop_delay;
+	int max_drop_delay;
+	int drop_average;			// ms x 100
+	unsigned int shed_count;
+} Relay;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+void relay_init(Relay *relay);
+void relay_set_frequency(Relay *relay, double freq);
+double relay_signal_freq(const Relay *relay);
+double relay_roc_freq(const Relay *relay);
+void relay_measure(Relay *relay, unsigned int sample_count, unsigned int now);
+int relay_step(Relay *relay, unsigned int switch_value, unsigned int now);
+void relay_set_maintenance(Relay *relay, int maintenance);
+int relay_is_unstable(const Relay *relay);
+int relay_is_predicted_unstable(const Relay *relay);
+
+#endif /* RELAY_H_ */
@@ -0,0 +1,191 @@
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdio.h>
+
+// ISR
+#include "system.h"
+#include "altera_avalon_pio_regs.h"
+#include "io.h"
+
+// RTOS
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+// Relay
+#include "relay_tasks.h"
+#include "display.h"
+#include "debounce.h"
+
+/*===================*/
+/* Global Variables. */
+/*===================*/
+Relay relay;
+Keypad keypad;
+KeypadRing keypad_ring;
+#if INPUT_LOG
+InputLog input_log;
+#endif
+MessageLog message_logs[MESSAGE_SOURCES];
+volatile int vga_zoom = 0;
+
+/*==========*/
+/* Handles. */
+/*==========*/
+QueueHandle_t Q_freq_data;
+SemaphoreHandle_t keyboard_ready;
+SemaphoreHandle_t shared_resource_mutex;
+SemaphoreHandle_t console_mutex;
+
+/*=================*/
+/* Initialisation. */
+/*=================*/
+// Before the ISR is registered and the tasks are created
+void relay_tasks_init(void) {
+	int i;
+
+	relay_init(&relay);
+	keypad_init(&keypad);
+	keypad_ring_init(&keypad_ring);
+	input_log_init(&input_log);
+	for (i = 0; i < MESSAGE_SOURCES; i++) {
+		message_log_init(&message_logs[i]);
+	}
+
+	Q_freq_data = xQueueCreate( 100, sizeof(int) );
+	shared_resource_mutex = xSemaphoreCreateMutex();
+	console_mutex = xSemaphoreCreateMutex();
+	keyboard_ready = xSemaphoreCreateBinary();
+}
+
+/*=======*/
+/* ISRs. */
+/*=======*/
+// Frequency Analyser
+void freq_relay(void *context, alt_u32 id) {
+	unsigned int temp = IORD(FREQUENCY_ANALYSER_BASE, 0); // Get the sample count between the two most recent peaks
+
+	TickType_t now = xTaskGetTickCountFromISR();
+	input_log_record(&input_log, INPUT_FREQ, temp, now);
+
+	xSemaphoreTakeFromISR(shared_resource_mutex, NULL);
+	relay_measure(&relay, temp, now); // Calculate and store frequency and ROC, start timing the drop delay
+	xSemaphoreGiveFromISR(shared_resource_mutex, NULL);
+
+	xQueueSendToBackFromISR( Q_freq_data, &relay.signal_mhz, pdFALSE ); // Add data to xQueue
+
+	return;
+}
+
+/*========*/
+/* Tasks. */
+/*========*/
+// Decision Task. The slide switch PIO has no interrupt or edge capture, so
+// it is polled each cycle and debounced; the relay only acts on the
+// switches that changed.
+void prvDecideTask(void *pvParameters) {
+	Debounce slide_switches;
+
+	debounce_init(&slide_switches, IORD_ALTERA_AVALON_PIO_DATA(SLIDE_SWITCH_BASE));
+	while (1) {
+		debounce_sample(&slide_switches, IORD_ALTERA_AVALON_PIO_DATA(SLIDE_SWITCH_BASE), xTaskGetTickCount());
+		unsigned int switch_value = slide_switches.value;
+
+		xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
+		taskENTER_CRITICAL(); // Keep the recorded order identical to the order the relay saw
+		TickType_t now = xTaskGetTickCount();
+		input_log_record(&input_log, INPUT_DECIDE, switch_value, now);
+		int drop_delay = relay_step(&relay, switch_value, now);
+		taskEXIT_CRITICAL();
+		xSemaphoreGive(shared_resource_mutex);
+
+		if (drop_delay > 0) {
+			message_log_post(&message_logs[MESSAGES_DECIDE], MESSAGE_DROP_TIME, drop_delay, 0, now);
+		}
+		vTaskDelay(20);
+	}
+}
+
+// Keyboard Task: decodes the scancodes ps2_isr queued, a burst at a time
+void prvKeyboardTask(void *pvParameters) {
+	unsigned char byte;
+
+	while (1) {
+		xSemaphoreTake(keyboard_ready, portMAX_DELAY);
+
+		while (keypad_ring_get(&keypad_ring, &byte) == 0) {
+			xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
+			taskENTER_CRITICAL(); // Logged when the relay sees it, as the decision task does
+			TickType_t now = xTaskGetTickCount();
+			input_log_record(&input_log, INPUT_PS2, byte, now);
+			int result = keypad_byte(&keypad, &relay, byte);
+			taskEXIT_CRITICAL();
+			xSemaphoreGive(shared_resource_mutex);
+
+			if (result == KEYPAD_SET_MIN_FREQ) {
+				message_log_post(&message_logs[MESSAGES_KEYBOARD], MESSAGE_MIN_FREQ_SET, relay.desired_min_mhz, 0, now);
+			} else if (result == KEYPAD_SET_MAX_ROC) {
+				message_log_post(&message_logs[MESSAGES_KEYBOARD], MESSAGE_MAX_ROC_SET, relay.desired_max_roc_mhz, 0, now);
+			} else if (result == KEYPAD_REFUSED) {
+				message_log_post(&message_logs[MESSAGES_KEYBOARD], MESSAGE_ENTRY_REFUSED, keypad.desired_flag, 0, now);
+			} else if ((result == KEYPAD_ZOOM_OUT) || (result == KEYPAD_ZOOM_IN)) {
+				xSemaphoreTake(shared_resource_mutex, portMAX_DELAY); // The console sets it too
+				if ((result == KEYPAD_ZOOM_OUT) && (vga_zoom < DISPLAY_ZOOM_LEVELS - 1)) {
+					vga_zoom++;
+				} else if ((result == KEYPAD_ZOOM_IN) && (vga_zoom > 0)) {
+					vga_zoom--;
+				}
+				xSemaphoreGive(shared_resource_mutex);
+			}
+		}
+	}
+}
+
+// Console Task: formats and prints the messages posted by the ISRs and tasks.
+// The console task replies on the same JTAG UART, so each line is flushed
+// to the device under console_mutex; the driver's own lock does nothing
+// under FreeRTOS.
+static void log_print(const char *line) {
+	xSemaphoreTake(console_mutex, portMAX_DELAY);
+	fputs(line, stdout); // Never waits, the driver applies CONSOLE_OVERFLOW when the host falls behind
+	fflush(stdout);
+	xSemaphoreGive(console_mutex);
+}
+
+void prvLogTask(void *pvParameters) {
+	char line[MESSAGE_LOG_LINE];
+	int i;
+
+	while (1) {
+		MessageLog *oldest = NULL;
+		const Message *message = NULL;
+
+		for (i = 0; i < MESSAGE_SOURCES; i++) {
+			MessageLog *log = &message_logs[i];
+			unsigned int dropped = log->dropped;
+			if (dropped != log->dropped_reported) {
+				format_int(line, sizeof(line), dropped - log->dropped_reported, " console messages dropped\n");
+				log_print(line);
+				log->dropped_reported = dropped;
+			}
+
+			// Oldest across the rings, so the console keeps the order things happened in
+			const Message *next = message_log_peek(log);
+			if ((next != NULL) && ((message == NULL) || ((int) (next->time - message->time) < 0))) {
+				oldest = log;
+				message = next;
+			}
+		}
+
+		if (message == NULL) {
+			vTaskDelay(10);
+			continue;
+		}
+		message_log_format(message, line, sizeof(line));
+		message_log_take(oldest);
+		log_print(line);
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef RELAY_TASKS_H_
+#define RELAY_TASKS_H_
+
+#include "alt_types.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#include "relay.h"
+#include "keypad.h"
+#include "input_log.h"
+#include "message_log.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+// The relay's real-time path: the frequency analyser ISR, the decision,
+// keyboard and console log tasks, and the state they share. LCFR_main.c
+// creates these tasks next to its device tasks, and the host simulator
+// (../LCFR_host/rtos_sim.c) builds this file unchanged against register
+// models of the analyser and the slide switches.
+
+// Console messages, one ring per producer
+#define MESSAGES_BUTTON 0
+#define MESSAGES_KEYBOARD 1
+#define MESSAGES_DECIDE 2
+#define MESSAGE_SOURCES 3
+
+/*===================*/
+/* Global Variables. */
+/*===================*/
+extern Relay relay;
+extern Keypad keypad;
+extern KeypadRing keypad_ring;		// Scancodes from ps2_isr to prvKeyboardTask
+#if INPUT_LOG
+extern InputLog input_log;
+#endif
+extern MessageLog message_logs[MESSAGE_SOURCES];
+extern volatile int vga_zoom;		// Set by the keypad +/- keys and the console, under shared_resource_mutex
+
+extern QueueHandle_t Q_freq_data;		// Measured frequencies in mHz, from freq_relay to the VGA task
+extern SemaphoreHandle_t keyboard_ready;	// Given by ps2_isr when it has queued scancodes
+extern SemaphoreHandle_t shared_resource_mutex;
+extern SemaphoreHandle_t console_mutex;		// Held while writing to the JTAG UART, which the log and console tasks share
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+void relay_tasks_init(void);
+void freq_relay(void *context, alt_u32 id);
+void prvDecideTask(void *pvParameters);
+void prvKeyboardTask(void *pvParameters);
+void prvLogTask(void *pvParameters);
+
+#endif /* RELAY_TASKS_H_ */
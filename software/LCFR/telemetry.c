@@ -0,0 +1,171 @@
+/*===========*/
+/* Includes. */
+/*===========*/
+#include "telemetry.h"
+
+/*===================*/
+/* Global Variables. */
+/*===================*/
+// CRC-16/CCITT-FALSE (polynomial 0x1021, initial 0xFFFF), four bits at a time
+static const unsigned short crc_nibbles[16] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+	0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef
+};
+
+/*============*/
+/* Functions. */
+/*============*/
+unsigned short telemetry_crc16(const unsigned char *data, int length) {
+	unsigned short crc = 0xFFFF;
+	int i;
+
+	for (i = 0; i < length; i++) {
+		crc = (crc << 4) ^ crc_nibbles[(crc >> 12) ^ (data[i] >> 4)];
+		crc = (crc << 4) ^ crc_nibbles[(crc >> 12) ^ (data[i] & 0x0F)];
+	}
+	return crc;
+}
+
+static void put16(unsigned char *p, unsigned int value) {
+	p[0] = value;
+	p[1] = value >> 8;
+}
+
+static void put32(unsigned char *p, unsigned int value) {
+	p[0] = value;
+	p[1] = value >> 8;
+	p[2] = value >> 16;
+	p[3] = value >> 24;
+}
+
+static int clamp(int value, int min, int max) {
+	return (value < min) ? min : (value > max) ? max : value;
+}
+
+// Append the CRC, COBS encode payload into frame and add the delimiter. Returns the frame length.
+static int encode(unsigned char *payload, int length, unsigned char *frame) {
+	int code_at = 0, out = 1, i;
+	unsigned char code = 1;
+
+	put16(&payload[length], telemetry_crc16(payload, length));
+	length += 2;
+
+	for (i = 0; i < length; i++) {
+		if (payload[i] == 0) {
+			frame[code_at] = code;
+			code_at = out++;
+			code = 1;
+		} else {
+			frame[out++] = payload[i];
+			code++;
+		}
+	}
+	frame[code_at] = code; // Payloads are under 254 bytes, so a block never fills up
+	frame[out++] = 0;
+	return out;
+}
+
+void telemetry_init(Telemetry *telemetry, int period) {
+	telemetry->period = clamp(period, 1, 255);
+	telemetry->sequence = 0;
+	telemetry->count = 0;
+	telemetry->unsent = 0;
+}
+
+// Add the relay's state to the pending frame. Returns the length of the
+// frame written to frame (TELEMETRY_MAX_FRAME bytes) once the batch is
+// full, 0 otherwise.
+int telemetry_sample(Telemetry *telemetry, const Relay *relay, unsigned int now, unsigned char *frame) {
+	unsigned char *payload = telemetry->payload;
+	unsigned char *sample;
+	int loads = 0, flags = 0, roc, i;
+
+	if (telemetry->count == 0) {
+		payload[0] = TELEMETRY_SAMPLES;
+		put32(&payload[2], now);
+		payload[6] = telemetry->period;
+	}
+	for (i = 0; i < RELAY_NUM_LOADS; i++) {
+		loads |= (relay->loads[i] != 0) << i;
+	}
+	if (relay->maintenance) {
+		flags |= TELEMETRY_MAINTENANCE;
+	}
+	if (relay->first_load_shed) {
+		flags |= TELEMETRY_MANAGING;
+	}
+	if (relay_is_unstable(relay)) {
+		flags |= TELEMETRY_UNSTABLE;
+	}
+
+	sample = &payload[TELEMETRY_HEADER_BYTES + telemetry->count * TELEMETRY_SAMPLE_BYTES];
+	roc = clamp(relay->roc_mhz, -327680, 327670); // cHz/s, rounded half away from zero
+	put16(&sample[0], clamp(relay->signal_mhz, 0, 65535));
+	put16(&sample[2], (roc + ((roc < 0) ? -5 : 5)) / 10);
+	sample[4] = loads;
+	sample[5] = flags;
+
+	if (++telemetry->count < TELEMETRY_BATCH) {
+		return 0;
+	}
+	return telemetry_flush(telemetry, frame);
+}
+
+// Frame the pending samples now, e.g. before changing the period. Returns the frame length, 0 if none are pending.
+int telemetry_flush(Telemetry *telemetry, unsigned char *frame) {
+	unsigned char payload[TELEMETRY_MAX_PAYLOAD + 2];
+	int length = TELEMETRY_HEADER_BYTES + telemetry->count * TELEMETRY_SAMPLE_BYTES, i;
+
+	if (telemetry->count == 0) {
+		return 0;
+	}
+	for (i = 0; i < length; i++) {
+		payload[i] = telemetry->payload[i];
+	}
+	payload[1] = telemetry->sequence++;
+	payload[7] = telemetry->count;
+	telemetry->count = 0;
+	return encode(payload, length, frame);
+}
+
+// Latency statistics frame. Returns its length.
+int telemetry_stats(Telemetry *telemetry, const Relay *relay, unsigned int now, unsigned char *frame) {
+	unsigned char payload[TELEMETRY_STATS_BYTES + 2];
+
+	payload[0] = TELEMETRY_STATS;
+	payload[1] = telemetry->sequence++;
+	put32(&payload[2], now);
+	put32(&payload[6], relay->shed_count);
+	put16(&payload[10], clamp(relay->min_drop_delay, 0, 65535));
+	put16(&payload[12], clamp(relay->max_drop_delay, 0, 65535));
+	put32(&payload[14], (unsigned int) relay->drop_average);
+	put32(&payload[18], telemetry->unsent);
+	return encode(payload, TELEMETRY_STATS_BYTES, frame);
+}
+
+// Undo the COBS encoding of one frame (without its delimiter) and check
+// its CRC. Returns the payload length, or -1 for a torn or corrupt frame.
+int telemetry_decode(const unsigned char *frame, int length, unsigned char *payload) {
+	int in = 0, out = 0, i;
+
+	while (in < length) {
+		int code = frame[in++];
+		if ((code == 0) || (in + code - 1 > length)) {
+			return -1;
+		}
+		for (i = 1; i < code; i++) {
+			payload[out++] = frame[in++];
+		}
+		if ((code < 0xFF) && (in < length)) {
+			payload[out++] = 0;
+		}
+	}
+	if (out < 3) {
+		return -1;
+	}
+	out -= 2;
+	if (telemetry_crc16(payload, out) != (payload[out] | (payload[out + 1] << 8))) {
+		return -1;
+	}
+	return out;
+}
@@ -0,0 +1,64 @@
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include "relay.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+// Binary telemetry stream. Each frame is a payload followed by its CRC-16,
+// COBS encoded so it contains no zero bytes, then a zero delimiter. A
+// decoder that starts mid-stream or loses bytes resyncs at the next zero,
+// and the CRC rejects anything torn. Multi-byte fields are little-endian.
+//
+// Sample frame, up to TELEMETRY_BATCH samples taken every period ms:
+//   0  type (TELEMETRY_SAMPLES)   1  sequence
+//   2  time of first sample, ms (u32)
+//   6  period, ms (u8)            7  sample count
+//   8  per sample: frequency mHz (u16), RoC 10 mHz/s (s16), loads bitmap (u8), flags (u8)
+// Stats frame:
+//   0  type (TELEMETRY_STATS)     1  sequence
+//   2  time, ms (u32)             6  loads shed (u32)
+//   10 min drop delay, ms (u16)   12 max drop delay, ms (u16)
+//   14 average drop delay, 10 us (u32)
+//   18 frames the device did not take (u32)
+//
+// A full sample frame is 60 bytes on the wire, 7.5 bytes per sample, so
+// 1 kHz fits in the 115200 baud UART.
+#define TELEMETRY_SAMPLES 1
+#define TELEMETRY_STATS 2
+
+#define TELEMETRY_BATCH 8			// Samples per frame
+#define TELEMETRY_SAMPLE_BYTES 6
+#define TELEMETRY_HEADER_BYTES 8
+#define TELEMETRY_STATS_BYTES 22
+#define TELEMETRY_MAX_PAYLOAD (TELEMETRY_HEADER_BYTES + TELEMETRY_BATCH * TELEMETRY_SAMPLE_BYTES)
+#define TELEMETRY_MAX_FRAME (TELEMETRY_MAX_PAYLOAD + 2 + 2 + 1)	// CRC, COBS overhead (under 254 bytes), delimiter
+
+// Sample flags
+#define TELEMETRY_MAINTENANCE 0x01
+#define TELEMETRY_MANAGING 0x02		// Loads have been shed and not all reconnected
+#define TELEMETRY_UNSTABLE 0x04		// A threshold is crossed
+
+/*=============*/
+/* Structures. */
+/*=============*/
+typedef struct {
+	int period;					// Milliseconds between samples, 1 to 255
+	unsigned char sequence;		// Of the next frame
+	int count;					// Samples in the pending frame
+	unsigned char payload[TELEMETRY_MAX_PAYLOAD];
+	unsigned int unsent;		// Frames the output device did not take, reported in the stats frame
+} Telemetry;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+void telemetry_init(Telemetry *telemetry, int period);
+int telemetry_sample(Telemetry *telemetry, const Relay *relay, unsigned int now, unsigned char *frame);
+int telemetry_flush(Telemetry *telemetry, unsigned char *frame);
+int telemetry_stats(Telemetry *telemetry, const Relay *relay, unsigned int now, unsigned char *frame);
+int telemetry_decode(const unsigned char *frame, int length, unsigned char *payload);
+unsigned short telemetry_crc16(const unsigned char *data, int length);
+
+#endif /* TELEMETRY_H_ */
@@ -82,6 +82,48 @@ extern "C"
 #define ALT_JTAG_UART_WRITE_RDY 0x2
 #define ALT_JTAG_UART_TIMEOUT   0x4
 
+/*
+ * Transmit overflow policies, set with the TIOCSOVERFLOW ioctl. With no host
+ * attached, or one that reads slowly, the transmit buffer fills up and a
+ * blocking write waits for the host, up to the timeout, for every byte it
+ * frees. Under any other policy a write never waits and reports the whole
+ * count as written:
+ *
+ *  DROP_NEWEST discards a write that doesn't fit, so lines are never cut.
+ *  DROP_OLDEST discards unsent data from the front of the buffer to make
+ *    room, so the buffer holds the most recent output.
+ *  COALESCE discards like DROP_NEWEST, then once there is room again sends
+ *    a single "[N bytes dropped]" line in place of everything lost.
+ *
+ * A write larger than the whole buffer keeps what fits.
+ */
+
+#define ALTERA_AVALON_JTAG_UART_BLOCK       0
+#define ALTERA_AVALON_JTAG_UART_DROP_NEWEST 1
+#define ALTERA_AVALON_JTAG_UART_DROP_OLDEST 2
+#define ALTERA_AVALON_JTAG_UART_COALESCE    3
+
+/*
+ * ioctl calls specific to this driver, following TIOCSTIMEOUT and
+ * TIOCGCONNECTED in sys/ioctl.h.
+ */
+
+#define TIOCSOVERFLOW 0x6a03 /* Set the transmit overflow policy (int) */
+#define TIOCGTXSTATS  0x6a04 /* Get altera_avalon_jtag_uart_stats */
+
+/*
+ * Transmit statistics, returned by the TIOCGTXSTATS ioctl. Stalls are only
+ * possible under ALTERA_AVALON_JTAG_UART_BLOCK.
+ */
+
+typedef struct altera_avalon_jtag_uart_stats_s
+{
+  alt_u32 dropped;     /* Bytes discarded by the overflow policy */
+  alt_u32 overflows;   /* Writes that didn't fit in the buffer */
+  alt_u32 stalls;      /* Writes that waited for the host */
+  alt_u32 stall_ticks; /* System clock ticks spent waiting */
+} altera_avalon_jtag_uart_stats;
+
 /*
  * State structure definition. Each instance of the driver uses one
  * of these structures to hold its associated state.
@@ -113,6 +155,10 @@ typedef struct altera_avalon_jtag_uart_state_s
   char          rx_buf[ALTERA_AVALON_JTAG_UART_BUF_LEN];
   char          tx_buf[ALTERA_AVALON_JTAG_UART_BUF_LEN];
 
+  int           tx_policy;    /* Transmit overflow policy */
+  alt_u32       tx_coalesced; /* Bytes dropped but not yet reported */
+  altera_avalon_jtag_uart_stats stats;
+
 #endif /* !ALTERA_AVALON_JTAG_UART_SMALL */
 
 } altera_avalon_jtag_uart_state;
@@ -141,6 +141,37 @@ typedef struct altera_avalon_uart_state_s
 
 #define ALT_AVALON_UART_FC 0x2
 
+/*
+ * The most bytes a transmit interrupt hands to the device before it
+ * returns. The Avalon UART has a holding and a shift register, so it takes
+ * two bytes when idle and one after that; set this to the FIFO depth for a
+ * core with a transmit FIFO.
+ */
+
+#ifndef ALTERA_AVALON_UART_TX_BURST
+#define ALTERA_AVALON_UART_TX_BURST 16
+#endif
+
+/*
+ * Scatter/gather transmit descriptor for altera_avalon_uart_write_sg(). The
+ * data is sent straight from the caller's buffer, which must stay valid
+ * until "done" is called. "done" runs in the UART interrupt once the last
+ * byte has been handed to the device, and may be NULL.
+ */
+
+typedef struct altera_avalon_uart_tx_s altera_avalon_uart_tx;
+
+typedef void (*altera_avalon_uart_tx_done)(altera_avalon_uart_tx* tx);
+
+struct altera_avalon_uart_tx_s
+{
+  const alt_u8*              ptr;     /* Data to send */
+  alt_u32                    len;     /* Bytes to send */
+  altera_avalon_uart_tx_done done;    /* Completion callback, or NULL */
+  void*                      context; /* For the callback */
+  altera_avalon_uart_tx*     next;    /* Used by the driver */
+};
+
 /*
  * The altera_avalon_uart_state structure is used to hold device specific data.
  * This includes the transmit and receive buffers.
@@ -172,6 +203,10 @@ typedef struct altera_avalon_uart_state_s
                                      * write buffer in multi-threaded mode */
   alt_u8           rx_buf[ALT_AVALON_UART_BUF_LEN]; /* The receive buffer */
   alt_u8           tx_buf[ALT_AVALON_UART_BUF_LEN]; /* The transmit buffer */
+  altera_avalon_uart_tx* tx_queue;  /* Descriptors waiting to be sent, the
+                                     * first one is being sent */
+  altera_avalon_uart_tx* tx_queue_tail;
+  alt_u32          tx_offset;       /* Bytes of tx_queue already sent */
 } altera_avalon_uart_state;
 
 /*
@@ -259,6 +294,9 @@ typedef struct altera_avalon_uart_state_s
 extern void altera_avalon_uart_init(altera_avalon_uart_state* sp,
                                     alt_u32 irq_controller_id, alt_u32 irq);
 
+extern int altera_avalon_uart_write_sg(altera_avalon_uart_state* sp,
+                                       altera_avalon_uart_tx* tx, int count);
+
 /*
  * The macro ALTERA_AVALON_UART_STATE_INIT is used by the auto-generated file
  * alt_sys_init.c to initialize an instance of the device driver state.
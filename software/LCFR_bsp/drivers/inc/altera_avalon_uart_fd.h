@@ -86,6 +86,7 @@ typedef struct altera_avalon_uart_dev_s
 
 extern int altera_avalon_uart_ioctl_fd (alt_fd* fd, int req, void* arg);
 extern int altera_avalon_uart_close_fd(alt_fd* fd);
+extern altera_avalon_uart_state* altera_avalon_uart_find_state(const char* name);
 
 #ifdef ALTERA_AVALON_UART_USE_IOCTL
 #define ALTERA_AVALON_UART_IOCTL_FD altera_avalon_uart_ioctl_fd
@@ -139,6 +139,19 @@ int alt_up_ps2_write_data_byte_with_ack(alt_up_ps2_dev *ps2, unsigned char byte)
  **/
 int alt_up_ps2_read_data_byte(alt_up_ps2_dev *ps2, unsigned char *byte);
 
+/**
+ * @brief Read every byte waiting in the PS/2 FIFO, up to \em len, without waiting.
+ *
+ * @param ps2 -- the PS/2 device structure.
+ * @param bytes -- memory location to store the bytes read.
+ * @param len -- the most bytes to read.
+ *
+ * @return the number of bytes read, 0 if the FIFO was empty.
+ *
+ * @note Stops as soon as RAVAIL shows the FIFO is empty, so it is cheap enough for an interrupt handler.
+ **/
+int alt_up_ps2_read_data_bytes(alt_up_ps2_dev *ps2, unsigned char *bytes, int len);
+
 /**
  * @brief Read a byte from the PS/2 port.
  *
@@ -76,6 +76,27 @@ altera_avalon_jtag_uart_ioctl(altera_avalon_jtag_uart_state* sp, int req,
     }
     break;
 
+  case TIOCSOVERFLOW:
+    /* Set what a write does when the transmit buffer is full */
+    {
+      int policy = *((int *)arg);
+      if (policy >= ALTERA_AVALON_JTAG_UART_BLOCK &&
+          policy <= ALTERA_AVALON_JTAG_UART_COALESCE)
+      {
+        sp->tx_policy = policy;
+        rc = 0;
+      }
+      else
+        rc = -EINVAL;
+    }
+    break;
+
+  case TIOCGTXSTATS:
+    /* Get the transmit drop and stall counters */
+    memcpy(arg, &sp->stats, sizeof(sp->stats));
+    rc = 0;
+    break;
+
   default:
     break;
   }
@@ -80,6 +80,129 @@ int altera_avalon_jtag_uart_write(altera_avalon_jtag_uart_state* sp,
 /* ------------------------- FAST DRIVER --------------------- */
 /* ----------------------------------------------------------- */
 
+/*
+ * Free space in the transmit buffer. The interrupt routine only ever adds
+ * to it, so it stays valid until the caller next copies in.
+ */
+static unsigned int
+altera_avalon_jtag_uart_tx_space(altera_avalon_jtag_uart_state* sp)
+{
+  return (sp->tx_out + ALTERA_AVALON_JTAG_UART_BUF_LEN - 1 - sp->tx_in) %
+         ALTERA_AVALON_JTAG_UART_BUF_LEN;
+}
+
+/*
+ * Copy count bytes into the transmit buffer, which must have room for them.
+ */
+static void
+altera_avalon_jtag_uart_tx_copy(altera_avalon_jtag_uart_state* sp,
+  const char * ptr, unsigned int count)
+{
+  unsigned int in = sp->tx_in;
+  unsigned int n  = ALTERA_AVALON_JTAG_UART_BUF_LEN - in;
+
+  if (n > count)
+    n = count;
+
+  memcpy(sp->tx_buf + in, ptr, n);
+  memcpy(sp->tx_buf, ptr + n, count - n);
+
+  sp->tx_in = (in + count) % ALTERA_AVALON_JTAG_UART_BUF_LEN;
+}
+
+/*
+ * Build the line COALESCE sends in place of dropped bytes, returning its
+ * length. Done by hand so that the driver doesn't pull in printf.
+ */
+static unsigned int
+altera_avalon_jtag_uart_notice(char * buf, alt_u32 dropped)
+{
+  static const char text[] = " bytes dropped]\n";
+  char digits[10];
+  unsigned int n = 0, len = 0;
+
+  do
+  {
+    digits[n++] = '0' + dropped % 10;
+    dropped /= 10;
+  }
+  while (dropped > 0);
+
+  buf[len++] = '\n';
+  buf[len++] = '[';
+  while (n > 0)
+    buf[len++] = digits[--n];
+  memcpy(buf + len, text, sizeof(text) - 1);
+
+  return len + sizeof(text) - 1;
+}
+
+/*
+ * Write under one of the non-blocking overflow policies. Never waits.
+ */
+static void
+altera_avalon_jtag_uart_write_policy(altera_avalon_jtag_uart_state* sp,
+  const char * ptr, unsigned int count)
+{
+  unsigned int space = altera_avalon_jtag_uart_tx_space(sp);
+  unsigned int dropped = 0;
+  unsigned int len;
+  char notice[32];
+  alt_irq_context context;
+
+  if (sp->tx_policy == ALTERA_AVALON_JTAG_UART_DROP_OLDEST)
+  {
+    if (count > ALTERA_AVALON_JTAG_UART_BUF_LEN - 1)
+    {
+      dropped = count - (ALTERA_AVALON_JTAG_UART_BUF_LEN - 1);
+      ptr    += dropped;
+      count  -= dropped;
+    }
+
+    if (count > space)
+    {
+      /* tx_out belongs to the interrupt routine, so move it with it held off */
+      context = alt_irq_disable_all();
+      space = altera_avalon_jtag_uart_tx_space(sp);
+      if (count > space)
+      {
+        sp->tx_out = (sp->tx_out + count - space) % ALTERA_AVALON_JTAG_UART_BUF_LEN;
+        dropped += count - space;
+      }
+      alt_irq_enable_all(context);
+    }
+  }
+  else
+  {
+    if (sp->tx_coalesced > 0)
+    {
+      len = altera_avalon_jtag_uart_notice(notice, sp->tx_coalesced);
+      if (len <= space)
+      {
+        altera_avalon_jtag_uart_tx_copy(sp, notice, len);
+        space -= len;
+        sp->tx_coalesced = 0;
+      }
+    }
+
+    if (count > space)
+    {
+      dropped = (count > ALTERA_AVALON_JTAG_UART_BUF_LEN - 1) ? count - space : count;
+      count  -= dropped;
+    }
+  }
+
+  altera_avalon_jtag_uart_tx_copy(sp, ptr, count);
+
+  if (dropped > 0)
+  {
+    sp->stats.dropped += dropped;
+    sp->stats.overflows++;
+    if (sp->tx_policy == ALTERA_AVALON_JTAG_UART_COALESCE)
+      sp->tx_coalesced += dropped;
+  }
+}
+
 int 
 altera_avalon_jtag_uart_write(altera_avalon_jtag_uart_state* sp, 
   const char * ptr, int count, int flags)
@@ -88,6 +211,8 @@ altera_avalon_jtag_uart_write(altera_avalon_jtag_uart_state* sp,
   unsigned int in, out=0;
   unsigned int n;
   alt_irq_context context;
+  alt_u32 stall_start = 0;
+  int stalled = 0;
 
   const char * start = ptr;
 
@@ -97,6 +222,19 @@ altera_avalon_jtag_uart_write(altera_avalon_jtag_uart_state* sp,
    */
   ALT_SEM_PEND (sp->write_lock, 0);
 
+  if (sp->tx_policy != ALTERA_AVALON_JTAG_UART_BLOCK)
+  {
+    altera_avalon_jtag_uart_write_policy(sp, ptr, count);
+
+    context = alt_irq_disable_all();
+    sp->irq_enable |= ALTERA_AVALON_JTAG_UART_CONTROL_WE_MSK;
+    IOWR_ALTERA_AVALON_JTAG_UART_CONTROL(sp->base, sp->irq_enable);
+    alt_irq_enable_all(context);
+
+    ALT_SEM_POST (sp->write_lock);
+    return count;
+  }
+
   do
   {
     /* Copy as much as we can into the transmit buffer */
@@ -148,6 +286,13 @@ altera_avalon_jtag_uart_write(altera_avalon_jtag_uart_state* sp,
       if (flags & O_NONBLOCK)
         break;
 
+      if (!stalled)
+      {
+        stalled = 1;
+        stall_start = alt_nticks();
+        sp->stats.stalls++;
+      }
+
 #ifdef __ucosii__
       /* OS Present: Pend on a flag if the OS is running, otherwise spin */
       if(OSRunning == OS_TRUE) {
@@ -190,6 +335,9 @@ altera_avalon_jtag_uart_write(altera_avalon_jtag_uart_state* sp,
   }
   while (count > 0);
 
+  if (stalled)
+    sp->stats.stall_ticks += alt_nticks() - stall_start;
+
   /*
    * Now that access to the circular buffer is complete, release the write
    * semaphore so that other threads can access the buffer.
@@ -207,6 +355,8 @@ altera_avalon_jtag_uart_write(altera_avalon_jtag_uart_state* sp,
      * Just throw away characters without reporting error. 
      */
     sp->tx_out = sp->tx_in = 0;
+    sp->stats.dropped += count;
+    sp->stats.overflows++;
     return ptr - start + count;
   }
 #endif
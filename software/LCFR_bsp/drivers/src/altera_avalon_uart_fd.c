@@ -31,6 +31,7 @@
 #include "alt_types.h"
 #include "sys/alt_dev.h"
 #include "altera_avalon_uart.h"
+#include "priv/alt_file.h"
 
 extern int altera_avalon_uart_read(altera_avalon_uart_state* sp,
   char* buffer, int space, int flags);
@@ -97,4 +98,19 @@ altera_avalon_uart_close_fd(alt_fd* fd)
     return altera_avalon_uart_close(&dev->state, fd->fd_flags);
 }
 
+/*
+ * altera_avalon_uart_find_state() returns the driver state of the UART
+ * registered as "name", e.g. to pass to altera_avalon_uart_write_sg(), or
+ * NULL if there is no such device.
+ */
+
+altera_avalon_uart_state*
+altera_avalon_uart_find_state(const char* name)
+{
+    altera_avalon_uart_dev* dev = 
+      (altera_avalon_uart_dev*) alt_find_dev(name, &alt_dev_list);
+
+    return (dev != NULL) ? &dev->state : NULL;
+}
+
 #endif /* fast driver */
@@ -200,15 +200,19 @@ altera_avalon_uart_rxirq(altera_avalon_uart_state* sp, alt_u32 status)
 /*
  * altera_avalon_uart_txirq() is called by altera_avalon_uart_irq() to 
  * process a transmit interrupt. It transfers data from the transmit 
- * buffer to the device, and sets the apropriate flags to indicate that 
- * there is data ready to be processed.
+ * buffer and the queued scatter/gather descriptors to the device, for as
+ * long as the device is ready and up to ALTERA_AVALON_UART_TX_BURST bytes,
+ * and sets the apropriate flags to indicate that there is data ready to be
+ * processed.
  */
 static void 
 altera_avalon_uart_txirq(altera_avalon_uart_state* sp, alt_u32 status)
 {
+  int burst = ALTERA_AVALON_UART_TX_BURST;
+
   /* Transfer data if there is some ready to be transfered */
 
-  if (sp->tx_start != sp->tx_end)
+  if ((sp->tx_start != sp->tx_end) || (sp->tx_queue != NULL))
   {
     /* 
      * If the device is using flow control (i.e. RTS/CTS), then the
@@ -218,26 +222,64 @@ altera_avalon_uart_txirq(altera_avalon_uart_state* sp, alt_u32 status)
     if (!(sp->flags & ALT_AVALON_UART_FC) ||
       (status & ALTERA_AVALON_UART_STATUS_CTS_MSK))
     { 
-
-      /*
-       * In a multi-threaded environment, set the write event flag to indicate
-       * that there is space in the circular buffer. This is only done if the
-       * buffer was previously empty.
-       */
-
-      if (sp->tx_start == ((sp->tx_end + 1) & ALT_AVALON_UART_BUF_MSK))
-      { 
-        ALT_FLAG_POST (sp->events, 
-                       ALT_UART_WRITE_RDY,
-                       OS_FLAG_SET);
+      while (burst-- && (status & ALTERA_AVALON_UART_STATUS_TRDY_MSK))
+      {
+        /*
+         * Take from the circular buffer unless a descriptor is part way
+         * through, so descriptors go out whole.
+         */
+
+        if ((sp->tx_offset == 0) && (sp->tx_start != sp->tx_end))
+        {
+          /*
+           * In a multi-threaded environment, set the write event flag to
+           * indicate that there is space in the circular buffer. This is
+           * only done if the buffer was previously full.
+           */
+
+          if (sp->tx_start == ((sp->tx_end + 1) & ALT_AVALON_UART_BUF_MSK))
+          { 
+            ALT_FLAG_POST (sp->events, 
+                           ALT_UART_WRITE_RDY,
+                           OS_FLAG_SET);
+          }
+
+          /* Write the data to the device */
+
+          IOWR_ALTERA_AVALON_UART_TXDATA(sp->base, sp->tx_buf[sp->tx_start]);
+
+          sp->tx_start = (sp->tx_start + 1) & ALT_AVALON_UART_BUF_MSK;
+        }
+        else if (sp->tx_queue != NULL)
+        {
+          altera_avalon_uart_tx* tx = sp->tx_queue;
+
+          if (sp->tx_offset < tx->len)
+          {
+            IOWR_ALTERA_AVALON_UART_TXDATA(sp->base, tx->ptr[sp->tx_offset++]);
+          }
+
+          /* The last byte is in the device, so the buffer is free again */
+
+          if (sp->tx_offset >= tx->len)
+          {
+            sp->tx_queue  = tx->next;
+            sp->tx_offset = 0;
+
+            if (tx->done != NULL)
+            {
+              tx->done (tx);
+            }
+          }
+        }
+        else
+        {
+          break;
+        }
+
+        status = IORD_ALTERA_AVALON_UART_STATUS(sp->base);
       }
 
-      /* Write the data to the device */
-
-      IOWR_ALTERA_AVALON_UART_TXDATA(sp->base, sp->tx_buf[sp->tx_start]);
-
-      sp->tx_start = (++sp->tx_start) & ALT_AVALON_UART_BUF_MSK;
-
       /*
        * In case the tranmit interrupt had previously been disabled by 
        * detecting a low value on CTS, it is reenabled here.
@@ -269,11 +311,11 @@ altera_avalon_uart_txirq(altera_avalon_uart_state* sp, alt_u32 status)
   }
 
   /*
-   * If the circular buffer is empty, disable the interrupt. This will be
-   * re-enabled when new data is placed in the buffer.
+   * If the circular buffer and the descriptor queue are empty, disable the
+   * interrupt. This will be re-enabled when new data is queued.
    */
 
-  if (sp->tx_start == sp->tx_end)
+  if ((sp->tx_start == sp->tx_end) && (sp->tx_queue == NULL))
   {
     sp->ctrl &= ~(ALTERA_AVALON_UART_CONTROL_TRDY_MSK |
                     ALTERA_AVALON_UART_CONTROL_DCTS_MSK);
@@ -300,7 +342,7 @@ int altera_avalon_uart_close(altera_avalon_uart_state* sp, int flags)
   /* 
    * Wait for all transmit data to be emptied by the UART ISR.
    */
-  while (sp->tx_start != sp->tx_end) {
+  while ((sp->tx_start != sp->tx_end) || (sp->tx_queue != NULL)) {
     if (flags & O_NONBLOCK) {
       return -EWOULDBLOCK; 
     }
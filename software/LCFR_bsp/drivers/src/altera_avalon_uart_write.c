@@ -229,4 +229,63 @@ altera_avalon_uart_write(altera_avalon_uart_state* sp, const char* ptr, int len,
   return (len - count);
 }
 
+/*
+ * altera_avalon_uart_write_sg() queues "count" transmit descriptors for
+ * sending, in order, after anything already queued. Unlike write(), the
+ * data is not copied: the transmit interrupt reads it straight from each
+ * descriptor's buffer, as many bytes per interrupt as the device takes,
+ * and calls the descriptor's "done" callback once its last byte is in the
+ * device. This function never blocks and takes constant time per
+ * descriptor, so it can be called from a task or an interrupt handler.
+ *
+ * The descriptors belong to the driver until their callbacks have run.
+ * Bytes passed to write() may be sent between two descriptors, but never
+ * inside one.
+ *
+ * The return value is the number of descriptors queued.
+ */
+
+int
+altera_avalon_uart_write_sg(altera_avalon_uart_state* sp,
+  altera_avalon_uart_tx* tx, int count)
+{
+  alt_irq_context context;
+  int             i;
+
+  if (count <= 0)
+  {
+    return 0;
+  }
+
+  /* Link the descriptors before taking them to the queue */
+
+  for (i = 0; i < count - 1; i++)
+  {
+    tx[i].next = &tx[i + 1];
+  }
+  tx[count - 1].next = NULL;
+
+  context = alt_irq_disable_all ();
+
+  if (sp->tx_queue == NULL)
+  {
+    sp->tx_queue  = tx;
+    sp->tx_offset = 0;
+  }
+  else
+  {
+    sp->tx_queue_tail->next = tx;
+  }
+  sp->tx_queue_tail = &tx[count - 1];
+
+  /* Ensure that interrupts are enabled, so that the queue can drain */
+
+  sp->ctrl |= ALTERA_AVALON_UART_CONTROL_TRDY_MSK |
+                 ALTERA_AVALON_UART_CONTROL_DCTS_MSK;
+  IOWR_ALTERA_AVALON_UART_CONTROL(sp->base, sp->ctrl);
+  alt_irq_enable_all (context);
+
+  return count;
+}
+
 #endif /* fast driver */
@@ -206,6 +206,24 @@ int alt_up_ps2_read_data_byte(alt_up_ps2_dev *ps2, unsigned char *byte)
 	return -1;
 }
 
+int alt_up_ps2_read_data_bytes(alt_up_ps2_dev *ps2, unsigned char *bytes, int len)
+{
+	unsigned int data_reg = 0;
+	int count = 0;
+	while (count < len)
+	{
+		data_reg = IORD_ALT_UP_PS2_PORT_DATA_REG(ps2->base);
+		if (!read_data_valid(data_reg))
+			break;
+		bytes[count++] = read_data_byte(data_reg);
+		// RAVAIL counts the byte just read, so 1 means the FIFO is now empty.
+		// Stopping early is harmless: the read interrupt stays raised while bytes remain.
+		if (read_num_bytes_available(data_reg) <= 1)
+			break;
+	}
+	return count;
+}
+
 void alt_up_ps2_clear_fifo(alt_up_ps2_dev *ps2)
 {
 	// The DATA byte of the data register will be automatically cleared after a read
@@ -37,6 +37,8 @@
 
 #define ABS(x)	((x >= 0) ? (x) : (-(x)))
 
+static void helper_fill_span(unsigned int addr, unsigned int count, unsigned int color, int mode);
+
 alt_up_pixel_buffer_dma_dev* alt_up_pixel_buffer_dma_open_dev(const char* name) {
   // find the device from the device list 
   // (see altera_hal/HAL/inc/priv/alt_file.h 
@@ -107,11 +109,66 @@ int alt_up_pixel_buffer_dma_check_swap_buffers_status(alt_up_pixel_buffer_dma_de
 	return (IORD_32DIRECT(pixel_buffer->base, 12) & 0x1);
 }
 
+static void helper_fill_span(unsigned int addr, unsigned int count, unsigned int color, int mode)
+/* This is a helper function that fills count pixels starting at byte address addr. Pixels are packed into 32-bit
+ * writes (four 8-bit or two 16-bit pixels per word), four words per loop iteration, and 8 or 16-bit writes are only
+ * used for the pixels before the first and after the last word boundary. Mode is 0, 1 or 2 as in helper_plot_pixel. */
+{
+	register unsigned int word, end;
+
+	if (mode == 0) {
+		color = color & 0xFF;
+		while ((count > 0) && (addr & 3)) {
+			IOWR_8DIRECT(addr, 0, color);
+			addr++;
+			count--;
+		}
+		word = color * 0x01010101;
+		end = addr + (count & ~3);
+	} else if (mode == 1) {
+		color = color & 0xFFFF;
+		if ((count > 0) && (addr & 2)) {
+			IOWR_16DIRECT(addr, 0, color);
+			addr += 2;
+			count--;
+		}
+		word = color | (color << 16);
+		end = addr + ((count & ~1) << 1);
+	} else {
+		word = color;
+		end = addr + (count << 2);
+	}
+
+	while (end - addr >= 16) {
+		IOWR_32DIRECT(addr, 0, word);
+		IOWR_32DIRECT(addr, 4, word);
+		IOWR_32DIRECT(addr, 8, word);
+		IOWR_32DIRECT(addr, 12, word);
+		addr += 16;
+	}
+	while (addr != end) {
+		IOWR_32DIRECT(addr, 0, word);
+		addr += 4;
+	}
+
+	/* Pixels after the last word boundary. */
+	if (mode == 0) {
+		for (count = count & 3; count > 0; count--) {
+			IOWR_8DIRECT(addr, 0, color);
+			addr++;
+		}
+	} else if ((mode == 1) && (count & 1)) {
+		IOWR_16DIRECT(addr, 0, color);
+	}
+}
+
 void alt_up_pixel_buffer_dma_clear_screen(alt_up_pixel_buffer_dma_dev *pixel_buffer, int backbuffer)
 /* This function clears the screen by setting each pixel to a black color. */
 {
 	register unsigned int addr;
 	register unsigned int limit_x, limit_y;
+	register int mode =	(pixel_buffer->color_mode == ALT_UP_8BIT_COLOR_MODE) ? 0 :
+						(pixel_buffer->color_mode == ALT_UP_16BIT_COLOR_MODE) ? 1 : 2;
 	
 	/* Set up the address to start clearing from and the screen boundaries. */
 	if (backbuffer == 1)
@@ -119,37 +176,23 @@ void alt_up_pixel_buffer_dma_clear_screen(alt_up_pixel_buffer_dma_dev *pixel_buf
 	else
 		addr = pixel_buffer->buffer_start_address;
 	limit_x = pixel_buffer->x_resolution;
-	/* In 16 and 32-bit color modes we use twice or four times more memory for the display buffer.*/
-	if (pixel_buffer->color_mode == ALT_UP_16BIT_COLOR_MODE) {
-		limit_x = limit_x << 1;
-	} else {
-		limit_x = limit_x << 2;
-	}	
 	limit_y = pixel_buffer->y_resolution;
 
 	if (pixel_buffer->addressing_mode == ALT_UP_PIXEL_BUFFER_XY_ADDRESS_MODE) {
-		/* Clear the screen when the VGA is set up in an XY addressing mode. */
-		register unsigned int x,y;
+		/* Clear the screen when the VGA is set up in an XY addressing mode. Each row is a span, the rest of the row's
+		 * address range is not displayed. */
+		register unsigned int y;
 		register unsigned int offset_y;
 		offset_y = pixel_buffer->y_coord_offset;
 
 		for (y = 0; y < limit_y; y++)
 		{
-			for (x = 0; x < limit_x; x = x + 4)
-			{
-				IOWR_32DIRECT(addr, x, 0);
-			}
+			helper_fill_span(addr, limit_x, 0, mode);
 			addr = addr + (1 << offset_y);
 		}
 	} else {
-		/* Clear the screen when the VGA is set up in a linear addressing mode. */
-		register int x;
-		limit_y = limit_x*limit_y;	
-
-		for (x = 0; x < limit_y; x = x + 4)
-		{
-			IOWR_32DIRECT(addr, x, 0);
-		}
+		/* Clear the screen when the VGA is set up in a linear addressing mode. The whole buffer is one span. */
+		helper_fill_span(addr, limit_x * limit_y, 0, mode);
 	}
 }
 
@@ -165,6 +208,9 @@ void alt_up_pixel_buffer_dma_draw_box(alt_up_pixel_buffer_dma_dev *pixel_buffer,
 	register unsigned int t_y = y0;
 	register unsigned int b_y = y1;
 	register unsigned int local_color = color;
+	register int mode =	(pixel_buffer->color_mode == ALT_UP_8BIT_COLOR_MODE) ? 0 :
+						(pixel_buffer->color_mode == ALT_UP_16BIT_COLOR_MODE) ? 1 : 2;
+	register unsigned int line_size, y;
 	
 	/* Check coordinates */
 	if (l_x > r_x)
@@ -208,86 +254,18 @@ void alt_up_pixel_buffer_dma_draw_box(alt_up_pixel_buffer_dma_dev *pixel_buffer,
 	else
 		addr = pixel_buffer->buffer_start_address;
 
-	/* Draw the box using one of the addressing modes. */
-	if (pixel_buffer->addressing_mode == ALT_UP_PIXEL_BUFFER_XY_ADDRESS_MODE) {
-		/* Draw a box of a given color on the screen using the XY addressing mode. */
-		register unsigned int x,y;
-		register unsigned int offset_y;
-		offset_y = pixel_buffer->y_coord_offset;
-		addr = addr + (t_y << offset_y);
-		
-		/* This portion of the code is purposefully replicated. This is because having a text for
-		 * the mode would unnecessarily slow down the drawing of a box. */
-		if (pixel_buffer->color_mode == ALT_UP_8BIT_COLOR_MODE) {
-			for (y = t_y; y <= b_y; y++)
-			{
-				for (x = l_x; x <= r_x; x++)
-				{
-					IOWR_8DIRECT(addr, x, local_color);
-				}
-				addr = addr + (1 << offset_y);
-			}
-		} else if (pixel_buffer->color_mode == ALT_UP_16BIT_COLOR_MODE) {
-			for (y = t_y; y <= b_y; y++)
-			{
-				for (x = l_x; x <= r_x; x++)
-				{
-					IOWR_16DIRECT(addr, x << 1, local_color);
-				}
-				addr = addr + (1 << offset_y);
-			}
-		}
-		else
-		{
-			for (y = t_y; y <= b_y; y++)
-			{
-				for (x = l_x; x <= r_x; x++)
-				{
-					IOWR_32DIRECT(addr, x << 2, local_color);
-				}
-				addr = addr + (1 << offset_y);
-			}
-		}
-	} else {
-		/* Draw a box of a given color on the screen using the linear addressing mode. */
-		register unsigned int x,y;
-		/* This portion of the code is purposefully replicated. This is because having a text for
-		 * the mode would unnecessarily slow down the drawing of a box. */
-		if (pixel_buffer->color_mode == ALT_UP_8BIT_COLOR_MODE) {
-			addr = addr + t_y * limit_x;
-			for (y = t_y; y <= b_y; y++)
-			{
-				for (x = l_x; x <= r_x; x++)
-				{
-					IOWR_8DIRECT(addr, x, local_color);
-				}
-				addr = addr + limit_x;
-			}
-		} else if (pixel_buffer->color_mode == ALT_UP_16BIT_COLOR_MODE) {
-			limit_x = limit_x << 1;
-			addr = addr + t_y * limit_x;
-			for (y = t_y; y <= b_y; y++)
-			{
-				for (x = l_x; x <= r_x; x++)
-				{
-					IOWR_16DIRECT(addr, x << 1, local_color);
-				}
-				addr = addr + limit_x;
-			}
-		}
-		else
-		{
-			limit_x = limit_x << 2;
-			addr = addr + t_y * limit_x;
-			for (y = t_y; y <= b_y; y++)
-			{
-				for (x = l_x; x <= r_x; x++)
-				{
-					IOWR_32DIRECT(addr, x << 2, local_color);
-				}
-				addr = addr + limit_x;
-			}
-		}
+	/* Bytes from one row to the next in either addressing mode. */
+	if (pixel_buffer->addressing_mode == ALT_UP_PIXEL_BUFFER_XY_ADDRESS_MODE)
+		line_size = 1 << pixel_buffer->y_coord_offset;
+	else
+		line_size = limit_x << mode;
+
+	/* Draw the box one row span at a time. */
+	addr = addr + t_y * line_size + (l_x << mode);
+	for (y = t_y; y <= b_y; y++)
+	{
+		helper_fill_span(addr, r_x - l_x + 1, local_color, mode);
+		addr = addr + line_size;
 	}
 }
 
@@ -302,6 +280,8 @@ void alt_up_pixel_buffer_dma_draw_hline(alt_up_pixel_buffer_dma_dev *pixel_buffe
 	register unsigned int r_x = x1;
 	register unsigned int line_y = y;
 	register unsigned int local_color = color;
+	register int mode =	(pixel_buffer->color_mode == ALT_UP_8BIT_COLOR_MODE) ? 0 :
+						(pixel_buffer->color_mode == ALT_UP_16BIT_COLOR_MODE) ? 1 : 2;
 	
 	/* Check coordinates */
 	if (l_x > r_x)
@@ -331,64 +311,12 @@ void alt_up_pixel_buffer_dma_draw_hline(alt_up_pixel_buffer_dma_dev *pixel_buffe
 	else
 		addr = pixel_buffer->buffer_start_address;
 
-	/* Draw a horizontal line using one of the addressing modes. */
-	if (pixel_buffer->addressing_mode == ALT_UP_PIXEL_BUFFER_XY_ADDRESS_MODE) {
-		/* Draw a horizontal line of a given color on the screen using the XY addressing mode. */
-		register unsigned int x;
-		register unsigned int offset_y;
-		offset_y = pixel_buffer->y_coord_offset;
-		addr = addr + (line_y << offset_y);
-		
-		/* This portion of the code is purposefully replicated. This is because having a text for
-		 * the mode would unnecessarily slow down the drawing of a horizontal line. */
-		if (pixel_buffer->color_mode == ALT_UP_8BIT_COLOR_MODE) {
-			for (x = l_x; x <= r_x; x++)
-			{
-				IOWR_8DIRECT(addr, x, local_color);
-			}
-		} else if (pixel_buffer->color_mode == ALT_UP_16BIT_COLOR_MODE) {
-			for (x = l_x; x <= r_x; x++)
-			{
-				IOWR_16DIRECT(addr, x << 1, local_color);
-			}
-		}
-		else
-		{
-			for (x = l_x; x <= r_x; x++)
-			{
-				IOWR_32DIRECT(addr, x << 2, local_color);
-			}
-		}
-	} else {
-		/* Draw a horizontal line of a given color on the screen using the linear addressing mode. */
-		register unsigned int x;
-		/* This portion of the code is purposefully replicated. This is because having a text for
-		 * the mode would unnecessarily slow down the drawing of a box. */
-		if (pixel_buffer->color_mode == ALT_UP_8BIT_COLOR_MODE) {
-			addr = addr + line_y * limit_x;
-			for (x = l_x; x <= r_x; x++)
-			{
-				IOWR_8DIRECT(addr, x, local_color);
-			}
-		} else if (pixel_buffer->color_mode == ALT_UP_16BIT_COLOR_MODE) {
-			limit_x = limit_x << 1;
-			addr = addr + line_y * limit_x;
-			for (x = l_x; x <= r_x; x++)
-			{
-				IOWR_16DIRECT(addr, x << 1, local_color);
-			}
-		}
-		else
-		{
-			limit_x = limit_x << 2;
-			addr = addr + line_y * limit_x;
-			for (x = l_x; x <= r_x; x++)
-			{
-				IOWR_32DIRECT(addr, x << 2, local_color);
-			}
-			addr = addr + limit_x;
-		}
-	}
+	/* Draw a horizontal line as one span using one of the addressing modes. */
+	if (pixel_buffer->addressing_mode == ALT_UP_PIXEL_BUFFER_XY_ADDRESS_MODE)
+		addr = addr + (line_y << pixel_buffer->y_coord_offset);
+	else
+		addr = addr + ((line_y * limit_x) << mode);
+	helper_fill_span(addr + (l_x << mode), r_x - l_x + 1, local_color, mode);
 }
 
 
@@ -520,19 +448,32 @@ void helper_plot_pixel(register unsigned int buffer_start, register int line_siz
 
 void alt_up_pixel_buffer_dma_draw_line(alt_up_pixel_buffer_dma_dev *pixel_buffer, int x0, int y0, int x1, int y1, int color, int backbuffer)
 /* This function draws a line between points (x0, y0) and (x1, y1). The function does not check if it draws a pixel within screen boundaries.
- * users should ensure that the line is drawn within the screen boundaries. */
+ * users should ensure that the line is drawn within the screen boundaries. Horizontal and vertical lines are drawn with the
+ * hline and vline functions, which do clip. */
 {
 	register int x_0 = x0;
 	register int y_0 = y0;
 	register int x_1 = x1;
 	register int y_1 = y1;
 	register char steep = (ABS(y_1 - y_0) > ABS(x_1 - x_0)) ? 1 : 0;
-	register int deltax, deltay, error, ystep, x, y;
+	register int deltax, deltay, error, x;
 	register int color_mode =	(pixel_buffer->color_mode == ALT_UP_8BIT_COLOR_MODE) ? 0 :
 								(pixel_buffer->color_mode == ALT_UP_16BIT_COLOR_MODE) ? 1 : 2;
 	register int line_color = color;
 	register unsigned int buffer_start;
-	register int line_size = (pixel_buffer->addressing_mode == ALT_UP_PIXEL_BUFFER_XY_ADDRESS_MODE) ? (1 << (pixel_buffer->y_coord_offset-color_mode)) : pixel_buffer->x_resolution;
+	register int line_size = (pixel_buffer->addressing_mode == ALT_UP_PIXEL_BUFFER_XY_ADDRESS_MODE) ? (1 << pixel_buffer->y_coord_offset) : (pixel_buffer->x_resolution << color_mode);
+	register int major_step, minor_step;
+	register unsigned int addr;
+
+	/* Axis-aligned lines need no error term. */
+	if (y_0 == y_1) {
+		alt_up_pixel_buffer_dma_draw_hline(pixel_buffer, x_0, x_1, y_0, color, backbuffer);
+		return;
+	}
+	if (x_0 == x_1) {
+		alt_up_pixel_buffer_dma_draw_vline(pixel_buffer, x_0, y_0, y_1, color, backbuffer);
+		return;
+	}
 
 	if (backbuffer == 1)
 		buffer_start = pixel_buffer->back_buffer_start_address;
@@ -561,39 +502,76 @@ void alt_up_pixel_buffer_dma_draw_line(alt_up_pixel_buffer_dma_dev *pixel_buffer
 		y_1 = error;
 	}
 
-	/* Setup local variables */
+	/* Setup local variables. The address of the first pixel is computed once, then moved by major_step for every
+	 * pixel and by minor_step when the error term overflows. */
 	deltax = x_1 - x_0;
 	deltay = ABS(y_1 - y_0);
 	error = -(deltax / 2); 
-	y = y_0;
-	if (y_0 < y_1)
-		ystep = 1;
-	else
-		ystep = -1;
+	if (steep == 1) {
+		addr = buffer_start + x_0 * line_size + (y_0 << color_mode);
+		major_step = line_size;
+		minor_step = 1 << color_mode;
+	} else {
+		addr = buffer_start + y_0 * line_size + (x_0 << color_mode);
+		major_step = 1 << color_mode;
+		minor_step = line_size;
+	}
+	if (y_0 > y_1)
+		minor_step = -minor_step;
 
 	/* Draw a line - either go along the x axis (steep = 0) or along the y axis (steep = 1). The code is replicated to
-	 * compile well on low optimization levels. */
+	 * compile well on low optimization levels. A shallow line is a series of horizontal runs, each drawn as one span. */
 	if (steep == 1)
 	{
-		for (x=x_0; x <= x_1; x++) {
-			helper_plot_pixel(buffer_start, line_size, y, x, line_color, color_mode);
-			error = error + deltay;
-			if (error > 0) {
-				y = y + ystep;
-				error = error - deltax;
+		if (color_mode == 0) {
+			for (x = x_0; x <= x_1; x++) {
+				IOWR_8DIRECT(addr, 0, line_color);
+				addr = addr + major_step;
+				error = error + deltay;
+				if (error > 0) {
+					addr = addr + minor_step;
+					error = error - deltax;
+				}
+			}
+		} else if (color_mode == 1) {
+			for (x = x_0; x <= x_1; x++) {
+				IOWR_16DIRECT(addr, 0, line_color);
+				addr = addr + major_step;
+				error = error + deltay;
+				if (error > 0) {
+					addr = addr + minor_step;
+					error = error - deltax;
+				}
+			}
+		} else {
+			for (x = x_0; x <= x_1; x++) {
+				IOWR_32DIRECT(addr, 0, line_color);
+				addr = addr + major_step;
+				error = error + deltay;
+				if (error > 0) {
+					addr = addr + minor_step;
+					error = error - deltax;
+				}
 			}
 		}
 	}
 	else
 	{
-		for (x=x_0; x <= x_1; x++) {
-			helper_plot_pixel(buffer_start, line_size, x, y, line_color, color_mode);
+		register unsigned int run_start = addr;
+		register int run = 0;
+
+		for (x = x_0; x <= x_1; x++) {
+			run++;
 			error = error + deltay;
 			if (error > 0) {
-				y = y + ystep;
+				helper_fill_span(run_start, run, line_color, color_mode);
+				run_start = run_start + ((run << color_mode) + minor_step);
+				run = 0;
 				error = error - deltax;
 			}
 		}
+		if (run > 0)
+			helper_fill_span(run_start, run, line_color, color_mode);
 	}
 }
 
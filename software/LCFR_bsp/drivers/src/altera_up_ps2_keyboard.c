@@ -7,13 +7,137 @@
 // Table of scan code, make code and their corresponding values 
 // These data are useful for developing more features for the keyboard 
 //
-char *key_table[SCAN_CODE_NUM] = { "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M", "N", "O", "P", "Q", "R", "S", "T", "U", "V", "W", "X", "Y", "Z", "0", "1", "2", "3", "4", "5", "6", "7", "8", "9", "`", "-", "=", "\\", "BKSP", "SPACE", "TAB", "CAPS", "L SHFT", "L CTRL", "L GUI", "L ALT", "R SHFT", "R CTRL", "R GUI", "R ALT", "APPS", "ENTER", "ESC", "F1", "F2", "F3", "F4", "F5", "F6", "F7", "F8", "F9", "F10", "F11", "F12", "SCROLL", "[", "INSERT", "HOME", "PG UP", "DELETE", "END", "PG DN", "U ARROW", "L ARROW", "D ARROW", "R ARROW", "NUM", "KP /", "KP *", "KP -", "KP +", "KP ENTER", "KP .", "KP 0", "KP 1", "KP 2", "KP 3", "KP 4", "KP 5", "KP 6", "KP 7", "KP 8", "KP 9", "]", ";", "'", ",", ".", "/" };
+// One KEY(index, name, ascii, single byte make code, multi byte make code)
+// per key, 0 for no make code. The arrays below and the direct-mapped
+// lookup tables are all expanded from this list at compile time.
+#define KEYBOARD_KEYS(KEY) \
+	KEY(  0, "A",        'A',   0x1C, 0x00) \
+	KEY(  1, "B",        'B',   0x32, 0x00) \
+	KEY(  2, "C",        'C',   0x21, 0x00) \
+	KEY(  3, "D",        'D',   0x23, 0x00) \
+	KEY(  4, "E",        'E',   0x24, 0x00) \
+	KEY(  5, "F",        'F',   0x2B, 0x00) \
+	KEY(  6, "G",        'G',   0x34, 0x00) \
+	KEY(  7, "H",        'H',   0x33, 0x00) \
+	KEY(  8, "I",        'I',   0x43, 0x00) \
+	KEY(  9, "J",        'J',   0x3B, 0x00) \
+	KEY( 10, "K",        'K',   0x42, 0x00) \
+	KEY( 11, "L",        'L',   0x4B, 0x00) \
+	KEY( 12, "M",        'M',   0x3A, 0x00) \
+	KEY( 13, "N",        'N',   0x31, 0x00) \
+	KEY( 14, "O",        'O',   0x44, 0x00) \
+	KEY( 15, "P",        'P',   0x4D, 0x00) \
+	KEY( 16, "Q",        'Q',   0x15, 0x00) \
+	KEY( 17, "R",        'R',   0x2D, 0x00) \
+	KEY( 18, "S",        'S',   0x1B, 0x00) \
+	KEY( 19, "T",        'T',   0x2C, 0x00) \
+	KEY( 20, "U",        'U',   0x3C, 0x00) \
+	KEY( 21, "V",        'V',   0x2A, 0x00) \
+	KEY( 22, "W",        'W',   0x1D, 0x00) \
+	KEY( 23, "X",        'X',   0x22, 0x00) \
+	KEY( 24, "Y",        'Y',   0x35, 0x00) \
+	KEY( 25, "Z",        'Z',   0x1A, 0x00) \
+	KEY( 26, "0",        '0',   0x45, 0x00) \
+	KEY( 27, "1",        '1',   0x16, 0x00) \
+	KEY( 28, "2",        '2',   0x1E, 0x00) \
+	KEY( 29, "3",        '3',   0x26, 0x00) \
+	KEY( 30, "4",        '4',   0x25, 0x00) \
+	KEY( 31, "5",        '5',   0x2E, 0x00) \
+	KEY( 32, "6",        '6',   0x36, 0x00) \
+	KEY( 33, "7",        '7',   0x3D, 0x00) \
+	KEY( 34, "8",        '8',   0x3E, 0x00) \
+	KEY( 35, "9",        '9',   0x46, 0x00) \
+	KEY( 36, "`",        '`',   0x0E, 0x00) \
+	KEY( 37, "-",        '-',   0x4E, 0x00) \
+	KEY( 38, "=",        '=',   0x55, 0x00) \
+	KEY( 39, "\\",       0,     0x5D, 0x00) \
+	KEY( 40, "BKSP",     0x08,  0x66, 0x00) \
+	KEY( 41, "SPACE",    0,     0x29, 0x00) \
+	KEY( 42, "TAB",      0x09,  0x0D, 0x00) \
+	KEY( 43, "CAPS",     0,     0x58, 0x00) \
+	KEY( 44, "L SHFT",   0,     0x12, 0x00) \
+	KEY( 45, "L CTRL",   0,     0x14, 0x00) \
+	KEY( 46, "L GUI",    0,     0x00, 0x1F) \
+	KEY( 47, "L ALT",    0,     0x11, 0x00) \
+	KEY( 48, "R SHFT",   0,     0x59, 0x00) \
+	KEY( 49, "R CTRL",   0,     0x00, 0x14) \
+	KEY( 50, "R GUI",    0,     0x00, 0x27) \
+	KEY( 51, "R ALT",    0,     0x00, 0x11) \
+	KEY( 52, "APPS",     0,     0x00, 0x2F) \
+	KEY( 53, "ENTER",    0x0A,  0x5A, 0x00) \
+	KEY( 54, "ESC",      0x1B,  0x76, 0x00) \
+	KEY( 55, "F1",       0,     0x05, 0x00) \
+	KEY( 56, "F2",       0,     0x06, 0x00) \
+	KEY( 57, "F3",       0,     0x04, 0x00) \
+	KEY( 58, "F4",       0,     0x0C, 0x00) \
+	KEY( 59, "F5",       0,     0x03, 0x00) \
+	KEY( 60, "F6",       0,     0x0B, 0x00) \
+	KEY( 61, "F7",       0,     0x83, 0x00) \
+	KEY( 62, "F8",       0,     0x0A, 0x00) \
+	KEY( 63, "F9",       0,     0x01, 0x00) \
+	KEY( 64, "F10",      0,     0x09, 0x00) \
+	KEY( 65, "F11",      0,     0x78, 0x00) \
+	KEY( 66, "F12",      0,     0x07, 0x00) \
+	KEY( 67, "SCROLL",   0,     0x7E, 0x00) \
+	KEY( 68, "[",        '[',   0x54, 0x00) \
+	KEY( 69, "INSERT",   0,     0x00, 0x70) \
+	KEY( 70, "HOME",     0,     0x00, 0x6C) \
+	KEY( 71, "PG UP",    0,     0x00, 0x7D) \
+	KEY( 72, "DELETE",   0x7F,  0x00, 0x71) \
+	KEY( 73, "END",      0,     0x00, 0x69) \
+	KEY( 74, "PG DN",    0,     0x00, 0x7A) \
+	KEY( 75, "U ARROW",  0,     0x00, 0x75) \
+	KEY( 76, "L ARROW",  0,     0x00, 0x6B) \
+	KEY( 77, "D ARROW",  0,     0x00, 0x72) \
+	KEY( 78, "R ARROW",  0,     0x00, 0x74) \
+	KEY( 79, "NUM",      0,     0x77, 0x00) \
+	KEY( 80, "KP /",     '/',   0x00, 0x4A) \
+	KEY( 81, "KP *",     '*',   0x7C, 0x00) \
+	KEY( 82, "KP -",     '-',   0x7B, 0x00) \
+	KEY( 83, "KP +",     '+',   0x79, 0x00) \
+	KEY( 84, "KP ENTER", 0x0A,  0x00, 0x5A) \
+	KEY( 85, "KP .",     '.',   0x71, 0x00) \
+	KEY( 86, "KP 0",     '0',   0x70, 0x00) \
+	KEY( 87, "KP 1",     '1',   0x69, 0x00) \
+	KEY( 88, "KP 2",     '2',   0x72, 0x00) \
+	KEY( 89, "KP 3",     '3',   0x7A, 0x00) \
+	KEY( 90, "KP 4",     '4',   0x6B, 0x00) \
+	KEY( 91, "KP 5",     '5',   0x73, 0x00) \
+	KEY( 92, "KP 6",     '6',   0x74, 0x00) \
+	KEY( 93, "KP 7",     '7',   0x6C, 0x00) \
+	KEY( 94, "KP 8",     '8',   0x75, 0x00) \
+	KEY( 95, "KP 9",     '9',   0x7D, 0x00) \
+	KEY( 96, "]",        ']',   0x5B, 0x00) \
+	KEY( 97, ";",        ';',   0x4C, 0x00) \
+	KEY( 98, "'",        '\'',  0x52, 0x00) \
+	KEY( 99, ",",        ',',   0x41, 0x00) \
+	KEY(100, ".",        '.',   0x49, 0x00) \
+	KEY(101, "/",        '/',   0x4A, 0x00)
 
-char ascii_codes[SCAN_CODE_NUM] = { 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '`', '-', '=', 0, 0x08, 0, 0x09, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x0A, 0x1B, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '[', 0, 0, 0, 0x7F, 0, 0, 0, 0, 0, 0, 0, '/', '*', '-', '+', 0x0A, '.', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', ']', ';', '\'', ',', '.', '/' };
+#define KEY_NAME(index, name, ascii, single, multi) name,
+#define KEY_ASCII(index, name, ascii, single, multi) ascii,
+#define KEY_SINGLE(index, name, ascii, single, multi) single,
+#define KEY_MULTI(index, name, ascii, single, multi) multi,
 
-alt_u8 single_byte_make_code[SCAN_CODE_NUM] = { 0x1C, 0x32, 0x21, 0x23, 0x24, 0x2B, 0x34, 0x33, 0x43, 0x3B, 0x42, 0x4B, 0x3A, 0x31, 0x44, 0x4D, 0x15, 0x2D, 0x1B, 0x2C, 0x3C, 0x2A, 0x1D, 0x22, 0x35, 0x1A, 0x45, 0x16, 0x1E, 0x26, 0x25, 0x2E, 0x36, 0x3D, 0x3E, 0x46, 0x0E, 0x4E, 0x55, 0x5D, 0x66, 0x29, 0x0D, 0x58, 0x12, 0x14, 0, 0x11, 0x59, 0, 0, 0, 0, 0x5A, 0x76, 0x05, 0x06, 0x04, 0x0C, 0x03, 0x0B, 0x83, 0x0A, 0x01, 0x09, 0x78, 0x07, 0x7E, 0x54, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x77, 0, 0x7C, 0x7B, 0x79, 0, 0x71, 0x70, 0x69, 0x72, 0x7A, 0x6B, 0x73, 0x74, 0x6C, 0x75, 0x7D, 0x5B, 0x4C, 0x52, 0x41, 0x49, 0x4A };
+char *key_table[SCAN_CODE_NUM] = { KEYBOARD_KEYS(KEY_NAME) };
+
+char ascii_codes[SCAN_CODE_NUM] = { KEYBOARD_KEYS(KEY_ASCII) };
+
+alt_u8 single_byte_make_code[SCAN_CODE_NUM] = { KEYBOARD_KEYS(KEY_SINGLE) };
+
+alt_u8 multi_byte_make_code[SCAN_CODE_NUM] = { KEYBOARD_KEYS(KEY_MULTI) };
+
+// Make code to table index, one entry per code so a lookup is a single
+// load. Entries hold index + 1, 0 for a code that is no key's. Keys
+// without a make code of that kind go to a spare slot past the 256 codes,
+// so no entry is initialised twice.
+#define KEY_SINGLE_INDEX(index, name, ascii, single, multi) [(single) ? (single) : 256 + (index)] = (index) + 1,
+#define KEY_MULTI_INDEX(index, name, ascii, single, multi) [(multi) ? (multi) : 256 + (index)] = (index) + 1,
+
+static const alt_u8 single_byte_make_code_index[256 + SCAN_CODE_NUM] = { KEYBOARD_KEYS(KEY_SINGLE_INDEX) };
+
+static const alt_u8 multi_byte_make_code_index[256 + SCAN_CODE_NUM] = { KEYBOARD_KEYS(KEY_MULTI_INDEX) };
 
-alt_u8 multi_byte_make_code[SCAN_CODE_NUM] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x1F, 0, 0, 0x14, 0x27, 0x11, 0x2F, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x70, 0x6C, 0x7D, 0x71, 0x69, 0x7A, 0x75, 0x6B, 0x72, 0x74, 0, 0x4A, 0, 0, 0, 0x5A, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 ////////////////////////////////////////////////////////////////////
 
 // States for the Keyboard Decode FSM 
@@ -29,25 +153,13 @@ typedef enum
 //helper function for get_next_state
 unsigned get_multi_byte_make_code_index(alt_u8 code)
 {
-	unsigned i;
-	for (i = 0; i < SCAN_CODE_NUM; i++ )
-	{
-		if ( multi_byte_make_code[i] == code )
-			return i;
-	}
-	return SCAN_CODE_NUM;
+	return multi_byte_make_code_index[code] ? multi_byte_make_code_index[code] - 1u : SCAN_CODE_NUM;
 }
 
 //helper function for get_next_state
 unsigned get_single_byte_make_code_index(alt_u8 code)
 {
-	unsigned i;
-	for (i = 0; i < SCAN_CODE_NUM; i++ )
-	{
-		if ( single_byte_make_code[i] == code )
-			return i;
-	}
-	return SCAN_CODE_NUM;
+	return single_byte_make_code_index[code] ? single_byte_make_code_index[code] - 1u : SCAN_CODE_NUM;
 }
 
 //helper function for decode_scancode
@@ -191,21 +303,21 @@ void translate_make_code(KB_CODE_TYPE decode_mode, alt_u8 makecode, char *str)
 	switch (decode_mode)
 	{
 		case KB_ASCII_MAKE_CODE:
-			idx = get_single_byte_make_code_index(makecode);
-			strcpy(str, key_table[idx]);
-			break;
 		case KB_BINARY_MAKE_CODE:
 			idx = get_single_byte_make_code_index(makecode);
-			strcpy(str, key_table[idx]);
 			break;
 		case KB_LONG_BINARY_MAKE_CODE:
 			idx = get_multi_byte_make_code_index(makecode);
-			strcpy(str, key_table[idx]);
 			break;
 		default:
-			str = "";
+			idx = SCAN_CODE_NUM;
 			break;
 	}
+	// a code that is no key's gives an empty string
+	if ( idx != SCAN_CODE_NUM )
+		strcpy(str, key_table[idx]);
+	else
+		str[0] = '\0';
 }
 
 
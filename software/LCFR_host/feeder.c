@@ -0,0 +1,63 @@
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <string.h>
+
+#include "relay.h"
+#include "feeder.h"
+
+/*============*/
+/* Functions. */
+/*============*/
+// xorshift32, so every feeder is reproducible from its seed alone
+unsigned int feeder_rand(unsigned int *seed) {
+	unsigned int x = *seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*seed = x;
+	return x;
+}
+
+// Uniform in [0, 1)
+static double feeder_uniform(unsigned int *seed) {
+	return (feeder_rand(seed) >> 8) / 16777216.0;
+}
+
+void feeder_init(Feeder *feeder, unsigned int seed) {
+	memset(feeder, 0, sizeof(Feeder));
+	feeder->seed = seed ? seed : 0x9e3779b9;
+
+	feeder->nominal = 49.8 + 0.4 * feeder_uniform(&feeder->seed);
+	feeder->noise = 0.02 * feeder_uniform(&feeder->seed);
+	feeder->event_time = 2.0 + 8.0 * feeder_uniform(&feeder->seed);
+	feeder->event_depth = 3.0 * feeder_uniform(&feeder->seed);
+	feeder->event_ramp = 0.05 + 2.0 * feeder_uniform(&feeder->seed);
+	feeder->event_hold = 5.0 * feeder_uniform(&feeder->seed);
+}
+
+// Noise-free frequency in Hz at the given time in seconds
+double feeder_frequency(const Feeder *feeder, double time) {
+	double t = time - feeder->event_time;
+
+	if (t < 0) {
+		return feeder->nominal;
+	} else if (t < feeder->event_ramp) {
+		return feeder->nominal - feeder->event_depth * t / feeder->event_ramp;
+	} else if (t < feeder->event_ramp + feeder->event_hold) {
+		return feeder->nominal - feeder->event_depth;
+	} else if (t < 2 * feeder->event_ramp + feeder->event_hold) {
+		return feeder->nominal - feeder->event_depth * (2 * feeder->event_ramp + feeder->event_hold - t) / feeder->event_ramp;
+	}
+	return feeder->nominal;
+}
+
+// Returns the next frequency analyser sample count and advances time by one cycle
+unsigned int feeder_next(Feeder *feeder) {
+	double freq = feeder_frequency(feeder, feeder->time);
+	freq += feeder->noise * (2.0 * feeder_uniform(&feeder->seed) - 1.0);
+
+	feeder->time += 1.0 / freq;
+	return (unsigned int) (SAMPLE_FREQ / freq + 0.5);
+}
@@ -0,0 +1,28 @@
+#ifndef FEEDER_H_
+#define FEEDER_H_
+
+/*=============*/
+/* Structures. */
+/*=============*/
+// A synthetic feeder: nominal frequency with measurement noise and one
+// disturbance (a sag of depth Hz over ramp seconds, held, then recovering).
+typedef struct {
+	unsigned int seed;
+	double nominal;
+	double noise;
+	double event_time;
+	double event_depth;
+	double event_ramp;
+	double event_hold;
+	double time;
+} Feeder;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+void feeder_init(Feeder *feeder, unsigned int seed);
+double feeder_frequency(const Feeder *feeder, double time);
+unsigned int feeder_next(Feeder *feeder);
+unsigned int feeder_rand(unsigned int *seed);
+
+#endif /* FEEDER_H_ */
@@ -0,0 +1,190 @@
+/*
+ * Fleet simulator. Runs N independent relays, each fed by its own synthetic
+ * feeder, spread across all cores, and reports throughput and shed statistics.
+ *
+ * Build: gcc -O2 -I../LCFR -o fleet_sim fleet_sim.c sched.c feeder.c ../LCFR/relay.c -lpthread -lm
+ * Usage: fleet_sim [-n relays] [-s seconds] [-t threads] [-o per_relay.csv]
+ */
+
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "relay.h"
+#include "feeder.h"
+#include "sched.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define DECIDE_PERIOD 20 // Milliseconds between relay_step calls, as prvDecideTask
+
+/*=============*/
+/* Structures. */
+/*=============*/
+typedef struct {
+	unsigned int samples;
+	unsigned int shed_count;
+	int first_shed_ms;			// -1 if the relay never shed
+	int min_drop_delay;
+	int max_drop_delay;
+	double min_freq;
+} RelayResult;
+
+typedef struct {
+	double seconds;
+	RelayResult *results;
+} Fleet;
+
+/*============*/
+/* Functions. */
+/*============*/
+static double wall_seconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Job for one relay, called from the scheduler
+static void fleet_run_relay(void *context, unsigned int job) {
+	Fleet *fleet = (Fleet *) context;
+	RelayResult *result = &fleet->results[job];
+	Relay relay;
+	Feeder feeder;
+	unsigned int next_decide = DECIDE_PERIOD;
+	unsigned int end = (unsigned int) (fleet->seconds * 1000);
+
+	relay_init(&relay);
+	feeder_init(&feeder, job * 2654435761u + 1);
+	memset(result, 0, sizeof(RelayResult));
+	result->first_shed_ms = -1;
+	result->min_freq = 1e9;
+
+	// Start settled at nominal rather than replaying the power-on roc spike
+	relay_set_frequency(&relay, feeder.nominal);
+
+	while (next_decide <= end) {
+		unsigned int count = feeder_next(&feeder);
+		unsigned int now = (unsigned int) (feeder.time * 1000);
+
+		// Decision cycles that fall before this sample see the previous one
+		while (next_decide < now && next_decide <= end) {
+			relay_step(&relay, 0xff, next_decide);
+			if (relay.shed_count > 0 && result->first_shed_ms < 0) {
+				result->first_shed_ms = next_decide;
+			}
+			next_decide += DECIDE_PERIOD;
+		}
+
+		relay_measure(&relay, count, now);
+		result->samples++;
+		if (relay_signal_freq(&relay) < result->min_freq) {
+			result->min_freq = relay_signal_freq(&relay);
+		}
+	}
+
+	result->shed_count = relay.shed_count;
+	result->min_drop_delay = relay.min_drop_delay;
+	result->max_drop_delay = relay.max_drop_delay;
+}
+
+int main(int argc, char *argv[]) {
+	unsigned int num_relays = 1000, num_threads = 0, i;
+	const char *csv_path = NULL;
+	Fleet fleet;
+	int opt;
+
+	fleet.seconds = 20.0;
+	while ((opt = getopt(argc, argv, "n:s:t:o:")) != -1) {
+		switch (opt) {
+			case 'n':
+				num_relays = (unsigned int) strtoul(optarg, NULL, 10);
+				break;
+			case 's':
+				fleet.seconds = atof(optarg);
+				break;
+			case 't':
+				num_threads = (unsigned int) strtoul(optarg, NULL, 10);
+				break;
+			case 'o':
+				csv_path = optarg;
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-n relays] [-s seconds] [-t threads] [-o per_relay.csv]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (num_relays == 0) {
+		return 0;
+	}
+	if (num_threads == 0) {
+		num_threads = sched_num_cores();
+	}
+
+	fleet.results = calloc(num_relays, sizeof(RelayResult));
+	if (fleet.results == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	double start = wall_seconds();
+	sched_run(num_relays, num_threads, fleet_run_relay, &fleet);
+	double elapsed = wall_seconds() - start;
+
+	// Aggregate
+	unsigned long long samples = 0, sheds = 0;
+	unsigned int relays_shed = 0;
+	double first_shed_sum = 0, worst_freq = 1e9;
+	int max_drop = 0;
+	for (i = 0; i < num_relays; i++) {
+		RelayResult *r = &fleet.results[i];
+		samples += r->samples;
+		sheds += r->shed_count;
+		if (r->first_shed_ms >= 0) {
+			relays_shed++;
+			first_shed_sum += r->first_shed_ms;
+		}
+		if (r->max_drop_delay > max_drop) {
+			max_drop = r->max_drop_delay;
+		}
+		if (r->min_freq < worst_freq) {
+			worst_freq = r->min_freq;
+		}
+	}
+
+	printf("Relays:             %u on %u threads\n", num_relays, num_threads);
+	printf("Simulated time:     %.1f s per relay\n", fleet.seconds);
+	printf("Wall time:          %.3f s\n", elapsed);
+	printf("Throughput:         %.0f samples/s\n", samples / elapsed);
+	printf("Relays that shed:   %u (%.1f%%)\n", relays_shed, 100.0 * relays_shed / num_relays);
+	printf("Loads shed:         %llu (%.2f per relay)\n", sheds, (double) sheds / num_relays);
+	if (relays_shed > 0) {
+		printf("Mean first shed:    %.0f ms\n", first_shed_sum / relays_shed);
+	}
+	printf("Max drop delay:     %d ms\n", max_drop);
+	printf("Lowest frequency:   %.3f Hz\n", worst_freq);
+
+	if (csv_path != NULL) {
+		FILE *csv = fopen(csv_path, "w");
+		if (csv == NULL) {
+			perror(csv_path);
+			return 1;
+		}
+		fprintf(csv, "relay,samples,shed_count,first_shed_ms,min_drop_delay,max_drop_delay,min_freq\n");
+		for (i = 0; i < num_relays; i++) {
+			RelayResult *r = &fleet.results[i];
+			fprintf(csv, "%u,%u,%u,%d,%d,%d,%.4f\n", i, r->samples, r->shed_count, r->first_shed_ms,
+					r->min_drop_delay, r->max_drop_delay, r->min_freq);
+		}
+		fclose(csv);
+	}
+
+	free(fleet.results);
+	return 0;
+}
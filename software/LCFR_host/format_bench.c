@@ -0,0 +1,219 @@
+/*
+ * Status text formatter benchmark (../LCFR/format.c). Checks format_int and
+ * format_fixed against snprintf for every field prvLEDOutTask formats, over
+ * random values and the edges of each range, then times both per call for
+ * the same fields and for the whole status update (15 fields). Times are in
+ * time stamp counter cycles on x86 and nanoseconds elsewhere. The host C
+ * library's printf has a hardware FPU behind it; newlib's on the Nios II
+ * emulates every double operation in software, so the gap on the board is
+ * wider than the one measured here.
+ *
+ * Build: gcc -O2 -I../LCFR -o format_bench format_bench.c ../LCFR/format.c
+ * Usage: format_bench [-n calls] [-c checks]
+ */
+
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "format.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define NUM_VALUES 1024		// Values cycled through while timing, a power of two
+
+/*=============*/
+/* Structures. */
+/*=============*/
+// One status field: the snprintf it replaces, and the fixed point equivalent
+typedef struct {
+	const char *name;
+	int size;				// Buffer size in DisplayStatus
+	int decimals;			// 0 for %d
+	const char *format;		// snprintf format of value / 10^decimals
+	const char *suffix;
+	int min, max;			// Fixed point range checked and timed
+} Field;
+
+/*===================*/
+/* Global Variables. */
+/*===================*/
+// The %f fields keep the first four characters of six decimals, so in mHz
+// they are cut to the same text
+static const Field fields[] = {
+	{ "freq", 5, 3, "%f", "", 0, 60000 },
+	{ "dfreq", 5, 3, "%f", "", -100000, 100000 },
+	{ "uptime", 10, 0, "%d s", " s", 0, 100000000 },
+	{ "min_freq", 12, 1, "%.1f Hz  ", " Hz  ", 0, 600 },
+	{ "max_roc", 12, 1, "%.1f Hz/s  ", " Hz/s  ", 0, 1000 },
+	{ "min_drop", 8, 0, "%d ms  ", " ms  ", 0, 10000 },
+	{ "max_drop", 8, 0, "%d ms  ", " ms  ", 0, 10000 },
+	{ "average_drop", 12, 2, "%.2f ms  ", " ms  ", 0, 1000000 },
+};
+#define NUM_FIELDS (sizeof(fields) / sizeof(fields[0]))
+
+// Calls per field in one status update: ten %f, then one of each other field
+static const int field_calls[NUM_FIELDS] = { 5, 5, 1, 1, 1, 1, 1, 1 };
+
+static const int powers_of_ten[] = { 1, 10, 100, 1000 };
+static int values[NUM_FIELDS][NUM_VALUES];
+static double doubles[NUM_FIELDS][NUM_VALUES];
+volatile int sink;
+
+/*============*/
+/* Functions. */
+/*============*/
+static unsigned long long now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+static int random_value(const Field *field) {
+	return field->min + (int) ((unsigned int) rand() % (unsigned int) (field->max - field->min + 1));
+}
+
+static int libc_format(const Field *field, char *buf, int value, double scaled) {
+	if (field->decimals == 0) {
+		return snprintf(buf, field->size, field->format, value);
+	}
+	return snprintf(buf, field->size, field->format, scaled);
+}
+
+static int fixed_format(const Field *field, char *buf, int value) {
+	if (field->decimals == 0) {
+		return format_int(buf, field->size, value, field->suffix);
+	}
+	return format_fixed(buf, field->size, value, field->decimals, field->suffix);
+}
+
+static int check_value(const Field *field, int value) {
+	char expected[16], got[16];
+	double scaled = (double) value / powers_of_ten[field->decimals];
+
+	memset(expected, 'x', sizeof(expected));
+	memset(got, 'x', sizeof(got));
+	libc_format(field, expected, value, scaled);
+	fixed_format(field, got, value);
+	if (memcmp(expected, got, sizeof(got)) != 0) {
+		fprintf(stderr, "%s %d: snprintf \"%s\", format \"%s\"\n", field->name, value, expected, got);
+		return -1;
+	}
+	return 0;
+}
+
+static int check(int checks) {
+	static const int edges[] = { 0, 1, -1, 9, -9, 10, -10, 99, 100, 999, 1000, 1001, 9999, 10000, -10000,
+			99999, 100000, -100000, 2147483647, -2147483647 - 1 };
+	char buf[16];
+	int f, i;
+
+	for (f = 0; f < (int) NUM_FIELDS; f++) {
+		for (i = 0; i < (int) (sizeof(edges) / sizeof(edges[0])); i++) {
+			if (check_value(&fields[f], edges[i]) != 0) {
+				return -1;
+			}
+		}
+		for (i = 0; i < checks; i++) {
+			if (check_value(&fields[f], random_value(&fields[f])) != 0) {
+				return -1;
+			}
+		}
+	}
+
+	// Tiny buffers are cut and terminated as snprintf does
+	for (i = 0; i <= 3; i++) {
+		memset(buf, 'x', sizeof(buf));
+		if ((format_fixed(buf, i, -1234, 3, " Hz") != ((i == 0) ? 0 : i - 1)) || ((i > 0) && (buf[i - 1] != '\0'))
+				|| (buf[i] != 'x')) {
+			fprintf(stderr, "Cutting to %d bytes failed\n", i);
+			return -1;
+		}
+	}
+
+	// Rounding to fixed point
+	if ((format_scaled(49.9995, 3) != 50000) || (format_scaled(-0.0005, 3) != -1) || (format_scaled(48.46, 1) != 485)
+			|| (format_scaled(1e12, 3) != 2147483647) || (format_scaled(-1e12, 3) != -2147483647)) {
+		fprintf(stderr, "format_scaled rounds wrongly\n");
+		return -1;
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	int calls = 1000000, checks = 1000000, opt, f, i;
+	unsigned long long start, libc_total = 0, fixed_total = 0;
+	char buf[16];
+
+	while ((opt = getopt(argc, argv, "n:c:")) != -1) {
+		switch (opt) {
+			case 'n':
+				calls = atoi(optarg);
+				break;
+			case 'c':
+				checks = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-n calls] [-c checks]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	srand(1);
+	if (check(checks) != 0) {
+		return 1;
+	}
+	printf("Checked %d values per field against snprintf\n", checks);
+
+	for (f = 0; f < (int) NUM_FIELDS; f++) {
+		for (i = 0; i < NUM_VALUES; i++) {
+			values[f][i] = random_value(&fields[f]);
+			doubles[f][i] = (double) values[f][i] / powers_of_ten[fields[f].decimals];
+		}
+	}
+
+	printf("%-14s %12s %12s %8s   (%s per call)\n", "Field", "snprintf", "format", "speedup",
+#if defined(__x86_64__) || defined(__i386__)
+			"cycles"
+#else
+			"ns"
+#endif
+	);
+	for (f = 0; f < (int) NUM_FIELDS; f++) {
+		const Field *field = &fields[f];
+		double libc, fixed;
+
+		start = now();
+		for (i = 0; i < calls; i++) {
+			int v = i & (NUM_VALUES - 1);
+			sink += libc_format(field, buf, values[f][v], doubles[f][v]);
+		}
+		libc = (double) (now() - start) / calls;
+
+		start = now();
+		for (i = 0; i < calls; i++) {
+			sink += fixed_format(field, buf, values[f][i & (NUM_VALUES - 1)]);
+		}
+		fixed = (double) (now() - start) / calls;
+
+		printf("%-14s %12.1f %12.1f %7.1fx\n", field->name, libc, fixed, libc / fixed);
+		libc_total += (unsigned long long) (libc * field_calls[f]);
+		fixed_total += (unsigned long long) (fixed * field_calls[f]);
+	}
+	printf("%-14s %12llu %12llu %7.1fx\n", "status update", libc_total, fixed_total, (double) libc_total / fixed_total);
+	return 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * History store benchmark (../LCFR/history.c). Pushes days of feeder
+ * samples at the firmware's rate, with a disturbance every ten minutes,
+ * then times history_query() for one screen width of columns over spans
+ * from a second to a week. Query results are checked against a brute force
+ * pass over every sample: exact while the span is still held at full
+ * resolution, and never narrower than the samples once coarser levels are
+ * used.
+ *
+ * Build: gcc -O2 -I../LCFR -o history_bench history_bench.c feeder.c ../LCFR/history.c ../LCFR/relay.c -lm
+ * Usage: history_bench [-d days] [-r repeats]
+ */
+
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "relay.h"
+#include "history.h"
+#include "feeder.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define SAMPLE_RATE 50			// Samples per second, as the frequency analyser
+#define WIDTH 539				// Columns in the VGA frequency plot
+#define EVENT_PERIOD 600.0		// Seconds between feeder disturbances
+
+/*===================*/
+/* Global Variables. */
+/*===================*/
+static History history;
+static HistoryBin columns[WIDTH];
+static const unsigned int spans[] = { 1, 10, 60, 600, 3600, 6 * 3600, 24 * 3600, 7 * 24 * 3600 };
+static const char *span_names[] = { "1 s", "10 s", "1 min", "10 min", "1 h", "6 h", "1 day", "1 week" };
+
+/*============*/
+/* Functions. */
+/*============*/
+static double wall_seconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Compare each column with the samples it covers
+static int check(const unsigned short *samples, unsigned int first, unsigned int last, int exact) {
+	unsigned long long span = last - first;
+	int c;
+
+	for (c = 0; c < WIDTH; c++) {
+		unsigned int s = first + (unsigned int) (span * c / WIDTH);
+		unsigned int e = first + (unsigned int) (span * (c + 1) / WIDTH);
+		unsigned int min = 0xFFFF, max = 0, i;
+		unsigned long long sum = 0;
+
+		for (i = s; i < e; i++) {
+			min = (samples[i] < min) ? samples[i] : min;
+			max = (samples[i] > max) ? samples[i] : max;
+			sum += samples[i];
+		}
+		if (e == s) {
+			if (!HISTORY_EMPTY(&columns[c])) {
+				fprintf(stderr, "Column %d of [%u,%u) should be empty\n", c, first, last);
+				return -1;
+			}
+			continue;
+		}
+		if (exact ? ((columns[c].min != min) || (columns[c].max != max) || (abs((int) columns[c].mean - (int) (sum / (e - s))) > HISTORY_LEVELS))
+				: ((columns[c].min > min) || (columns[c].max < max))) {
+			fprintf(stderr, "Column %d of [%u,%u): got %u..%u mean %u, samples %u..%u mean %llu\n", c, first, last,
+					columns[c].min, columns[c].max, columns[c].mean, min, max, sum / (e - s));
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	double days = 8, next_event = EVENT_PERIOD / 2;
+	int repeats = 1000, opt, r;
+	unsigned int count, seed = 1, i;
+	unsigned short *samples;
+	Feeder feeder;
+
+	while ((opt = getopt(argc, argv, "d:r:")) != -1) {
+		switch (opt) {
+			case 'd':
+				days = atof(optarg);
+				break;
+			case 'r':
+				repeats = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-d days] [-r repeats]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	count = (unsigned int) (days * 24 * 3600 * SAMPLE_RATE);
+	samples = malloc(count * sizeof(unsigned short));
+	if (samples == NULL) {
+		fprintf(stderr, "Out of memory for %u samples\n", count);
+		return 1;
+	}
+
+	// Precompute the feeder so only history_push is timed
+	feeder_init(&feeder, seed);
+	feeder.event_time = next_event;
+	for (i = 0; i < count; i++) {
+		if (feeder.time >= next_event + EVENT_PERIOD / 2) {
+			double time = feeder.time;
+			feeder_init(&feeder, ++seed);
+			feeder.time = time;
+			feeder.event_time = time + EVENT_PERIOD / 2;
+			next_event = feeder.event_time;
+		}
+		unsigned int cycle = feeder_next(&feeder); // In mHz as relay_measure rounds it
+		unsigned int mhz = (cycle > 0) ? (SAMPLE_FREQ * 1000 + cycle / 2) / cycle : 0;
+		samples[i] = (mhz > 65535) ? 65535 : (unsigned short) mhz;
+	}
+
+	history_init(&history);
+	double start = wall_seconds();
+	for (i = 0; i < count; i++) {
+		history_push(&history, samples[i]);
+	}
+	double elapsed = wall_seconds() - start;
+	printf("Pushed %u samples (%.1f days) in %.3f s, %.1f ns per sample, %.1f MB store\n", count, days, elapsed,
+			elapsed / count * 1e9, sizeof(history) / 1048576.0);
+
+	printf("%-8s %12s %10s\n", "Span", "us/query", "columns");
+	for (i = 0; i < sizeof(spans) / sizeof(spans[0]); i++) {
+		unsigned int span = spans[i] * SAMPLE_RATE;
+		unsigned int first = count - span;
+		int filled = 0;
+
+		if (span > count) {
+			break;
+		}
+		start = wall_seconds();
+		for (r = 0; r < repeats; r++) {
+			filled = history_query(&history, first, first + span, columns, WIDTH);
+		}
+		elapsed = wall_seconds() - start;
+		printf("%-8s %12.2f %10d\n", span_names[i], elapsed / repeats * 1e6, filled);
+
+		if (check(samples, first, count, span <= HISTORY_CAPACITY) != 0) {
+			return 1;
+		}
+	}
+	free(samples);
+	return 0;
+}
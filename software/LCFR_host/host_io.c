@@ -0,0 +1,156 @@
+/*
+ * Host side of inc/io.h and the HAL device list, so BSP drivers run
+ * unchanged against memory and register models.
+ */
+
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "io.h"
+#include "priv/alt_file.h"
+#include "sys/alt_irq.h"
+#include "host_io.h"
+
+/*===================*/
+/* Global Variables. */
+/*===================*/
+static HostIoRegion regions[HOST_IO_MAX_REGIONS];
+static int num_regions = 0;
+static HostIoRegion *last_region = NULL;	// Drivers mostly hit the same region many times in a row
+
+alt_llist alt_dev_list = ALT_LLIST_ENTRY;
+
+static alt_isr_func irq_handlers[HOST_IO_MAX_IRQS];
+static void *irq_contexts[HOST_IO_MAX_IRQS];
+
+/*============*/
+/* Functions. */
+/*============*/
+static HostIoRegion *host_io_map(const char *name, unsigned int base, unsigned int span) {
+	HostIoRegion *region;
+
+	if (num_regions == HOST_IO_MAX_REGIONS) {
+		fprintf(stderr, "host_io: too many regions mapping %s\n", name);
+		abort();
+	}
+	region = &regions[num_regions++];
+	memset(region, 0, sizeof(*region));
+	region->name = name;
+	region->base = base;
+	region->span = span;
+	return region;
+}
+
+HostIoRegion *host_io_map_memory(const char *name, unsigned int base, unsigned int span, unsigned char *memory) {
+	HostIoRegion *region = host_io_map(name, base, span);
+	region->memory = memory;
+	return region;
+}
+
+HostIoRegion *host_io_map_registers(const char *name, unsigned int base, unsigned int span, HostIoHandler handler, void *context) {
+	HostIoRegion *region = host_io_map(name, base, span);
+	region->handler = handler;
+	region->context = context;
+	return region;
+}
+
+void host_io_clear_counters(void) {
+	int i;
+	for (i = 0; i < num_regions; i++) {
+		regions[i].reads = 0;
+		regions[i].writes = 0;
+		regions[i].bytes_written = 0;
+	}
+}
+
+static HostIoRegion *host_io_find(unsigned int address, int bytes) {
+	HostIoRegion *region = last_region;
+	int i;
+
+	if ((region != NULL) && (address - region->base < region->span) && (address - region->base + bytes <= region->span)) {
+		return region;
+	}
+	for (i = 0; i < num_regions; i++) {
+		region = &regions[i];
+		if ((address - region->base < region->span) && (address - region->base + bytes <= region->span)) {
+			last_region = region;
+			return region;
+		}
+	}
+	fprintf(stderr, "host_io: %d byte access to unmapped address 0x%08x\n", bytes, address);
+	abort();
+}
+
+unsigned int host_io_read(unsigned int address, int bytes) {
+	HostIoRegion *region = host_io_find(address, bytes);
+	unsigned int offset = address - region->base;
+	unsigned int data = 0;
+
+	region->reads++;
+	if (region->memory == NULL) {
+		return region->handler(region->context, offset, 0, bytes, 0);
+	}
+	memcpy(&data, region->memory + offset, bytes); // Nios II and the host are both little endian
+	return data;
+}
+
+void host_io_write(unsigned int address, unsigned int data, int bytes) {
+	HostIoRegion *region = host_io_find(address, bytes);
+	unsigned int offset = address - region->base;
+
+	region->writes++;
+	region->bytes_written += bytes;
+	if (region->memory == NULL) {
+		region->handler(region->context, offset, data, bytes, 1);
+		return;
+	}
+	memcpy(region->memory + offset, &data, bytes);
+}
+
+// HAL device list, just enough for the drivers' open_dev functions
+int alt_dev_reg(alt_dev* dev) {
+	alt_llist *entry = &alt_dev_list;
+	while (entry->next != NULL) {
+		entry = entry->next;
+	}
+	entry->next = &dev->llist;
+	dev->llist.previous = entry;
+	dev->llist.next = NULL;
+	return 0;
+}
+
+alt_dev* alt_find_dev(const char* name, alt_llist* list) {
+	alt_llist *entry;
+	for (entry = list->next; entry != NULL; entry = entry->next) {
+		alt_dev *dev = (alt_dev *) entry; // llist is the first member
+		if (strcmp(dev->name, name) == 0) {
+			return dev;
+		}
+	}
+	return NULL;
+}
+
+// Interrupts, for drivers that register a handler. Weak, so a program
+// running the FreeRTOS host port (rtos/port.c) delivers them through it.
+ALT_WEAK int alt_irq_register(alt_u32 id, void* context, alt_isr_func handler) {
+	if (id >= HOST_IO_MAX_IRQS) {
+		return -1;
+	}
+	irq_handlers[id] = handler;
+	irq_contexts[id] = context;
+	return 0;
+}
+
+// Run the handler for interrupt id, as the board would when a device raises it. Returns -1 if none is registered.
+int host_io_irq(unsigned int id) {
+	if ((id >= HOST_IO_MAX_IRQS) || (irq_handlers[id] == NULL)) {
+		return -1;
+	}
+	irq_handlers[id](irq_contexts[id], id);
+	return 0;
+}
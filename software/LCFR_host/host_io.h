@@ -0,0 +1,40 @@
+#ifndef HOST_IO_H_
+#define HOST_IO_H_
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+// Nios II device addresses as seen by BSP drivers built against inc/io.h.
+// Each region is either plain memory (SRAM, character buffer) or a register
+// model called on every access. Accesses outside every region abort, as a
+// bus error would hang the board.
+#define HOST_IO_MAX_REGIONS 16
+#define HOST_IO_MAX_IRQS 32
+
+/*=============*/
+/* Structures. */
+/*=============*/
+// Register model: returns the read value, the return value of writes is ignored
+typedef unsigned int (*HostIoHandler)(void *context, unsigned int offset, unsigned int data, int bytes, int write);
+
+typedef struct {
+	const char *name;
+	unsigned int base;
+	unsigned int span;
+	unsigned char *memory;		// NULL for a register model
+	HostIoHandler handler;
+	void *context;
+	unsigned long long reads;
+	unsigned long long writes;
+	unsigned long long bytes_written;
+} HostIoRegion;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+HostIoRegion *host_io_map_memory(const char *name, unsigned int base, unsigned int span, unsigned char *memory);
+HostIoRegion *host_io_map_registers(const char *name, unsigned int base, unsigned int span, HostIoHandler handler, void *context);
+void host_io_clear_counters(void);
+int host_io_irq(unsigned int id);
+
+#endif /* HOST_IO_H_ */
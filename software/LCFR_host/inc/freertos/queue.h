@@ -0,0 +1,12 @@
+#ifndef __HOST_FREERTOS_QUEUE_H__
+#define __HOST_FREERTOS_QUEUE_H__
+
+/*
+ * The firmware includes "freertos/queue.h", which the Nios II tools find in
+ * ../LCFR/FreeRTOS on a case-insensitive file system. Forwards to the
+ * kernel header found on the include path.
+ */
+
+#include <queue.h>
+
+#endif /* __HOST_FREERTOS_QUEUE_H__ */
@@ -0,0 +1,12 @@
+#ifndef __HOST_FREERTOS_SEMPHR_H__
+#define __HOST_FREERTOS_SEMPHR_H__
+
+/*
+ * The firmware includes "freertos/semphr.h", which the Nios II tools find in
+ * ../LCFR/FreeRTOS on a case-insensitive file system. Forwards to the
+ * kernel header found on the include path.
+ */
+
+#include <semphr.h>
+
+#endif /* __HOST_FREERTOS_SEMPHR_H__ */
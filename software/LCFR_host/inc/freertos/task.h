@@ -0,0 +1,12 @@
+#ifndef __HOST_FREERTOS_TASK_H__
+#define __HOST_FREERTOS_TASK_H__
+
+/*
+ * The firmware includes "freertos/task.h", which the Nios II tools find in
+ * ../LCFR/FreeRTOS on a case-insensitive file system. Forwards to the
+ * kernel header found on the include path.
+ */
+
+#include <task.h>
+
+#endif /* __HOST_FREERTOS_TASK_H__ */
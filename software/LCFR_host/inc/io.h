@@ -0,0 +1,28 @@
+#ifndef __IO_H__
+#define __IO_H__
+
+/*
+ * Host stand-in for the HAL io.h. Device accesses go through host_io.c,
+ * which maps Nios II addresses onto host memory and register models and
+ * counts every access.
+ */
+
+#include "alt_types.h"
+
+unsigned int host_io_read(unsigned int address, int bytes);
+void host_io_write(unsigned int address, unsigned int data, int bytes);
+
+#define __IO_CALC_ADDRESS_NATIVE(base, reg)	((unsigned int) (unsigned long) (base) + (reg) * 4)
+
+#define IORD(base, reg)						host_io_read(__IO_CALC_ADDRESS_NATIVE(base, reg), 4)
+#define IOWR(base, reg, data)				host_io_write(__IO_CALC_ADDRESS_NATIVE(base, reg), (data), 4)
+
+#define IORD_32DIRECT(base, offset)			host_io_read((base) + (offset), 4)
+#define IORD_16DIRECT(base, offset)			host_io_read((base) + (offset), 2)
+#define IORD_8DIRECT(base, offset)			host_io_read((base) + (offset), 1)
+
+#define IOWR_32DIRECT(base, offset, data)	host_io_write((base) + (offset), (data), 4)
+#define IOWR_16DIRECT(base, offset, data)	host_io_write((base) + (offset), (data), 2)
+#define IOWR_8DIRECT(base, offset, data)	host_io_write((base) + (offset), (data), 1)
+
+#endif /* __IO_H__ */
@@ -0,0 +1,14 @@
+#ifndef __ALT_FLAG_H__
+#define __ALT_FLAG_H__
+
+/*
+ * Host stand-in for the HAL os/alt_flag.h. As on the board, the driver
+ * event flags do nothing, so blocking writes poll.
+ */
+
+#define ALT_FLAG_GRP(group)
+#define ALT_FLAG_CREATE(group, flags) 0
+#define ALT_FLAG_PEND(group, flags, wait_type, timeout) ((void) 0)
+#define ALT_FLAG_POST(group, flags, opt) ((void) 0)
+
+#endif /* __ALT_FLAG_H__ */
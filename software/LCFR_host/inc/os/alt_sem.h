@@ -0,0 +1,14 @@
+#ifndef __ALT_SEM_H__
+#define __ALT_SEM_H__
+
+/*
+ * Host stand-in for the HAL os/alt_sem.h. As on the board, where the BSP
+ * has no OS wrappers for FreeRTOS, the driver semaphores do nothing.
+ */
+
+#define ALT_SEM(sem)
+#define ALT_SEM_CREATE(sem, value) 0
+#define ALT_SEM_PEND(sem, timeout) ((void) 0)
+#define ALT_SEM_POST(sem) ((void) 0)
+
+#endif /* __ALT_SEM_H__ */
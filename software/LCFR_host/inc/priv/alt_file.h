@@ -0,0 +1,15 @@
+#ifndef __ALT_FILE_H__
+#define __ALT_FILE_H__
+
+/*
+ * Host stand-in for the HAL priv/alt_file.h: only the device list lookup
+ * the drivers' open_dev functions use.
+ */
+
+#include "sys/alt_dev.h"
+
+extern alt_llist alt_dev_list;
+
+alt_dev* alt_find_dev(const char* name, alt_llist* list);
+
+#endif /* __ALT_FILE_H__ */
@@ -0,0 +1,12 @@
+#ifndef __ALT_ERRNO_H__
+#define __ALT_ERRNO_H__
+
+/*
+ * Host stand-in for the HAL sys/alt_errno.h.
+ */
+
+#include <errno.h>
+
+#define ALT_ERRNO errno
+
+#endif /* __ALT_ERRNO_H__ */
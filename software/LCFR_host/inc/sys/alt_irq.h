@@ -0,0 +1,26 @@
+#ifndef __ALT_IRQ_H__
+#define __ALT_IRQ_H__
+
+/*
+ * Host stand-in for the HAL sys/alt_irq.h. Interrupts are never
+ * asynchronous on the host: a model raises one by calling host_io_irq(),
+ * which runs the handler registered for it there and then, so disabling
+ * interrupts has nothing to do.
+ */
+
+#include "alt_types.h"
+
+typedef int alt_irq_context;
+typedef void (*alt_isr_func) (void* isr_context, alt_u32 id);
+
+int alt_irq_register(alt_u32 id, void* context, alt_isr_func handler);
+
+static ALT_INLINE alt_irq_context alt_irq_disable_all(void) {
+	return 0;
+}
+
+static ALT_INLINE void alt_irq_enable_all(alt_irq_context context) {
+	(void) context;
+}
+
+#endif /* __ALT_IRQ_H__ */
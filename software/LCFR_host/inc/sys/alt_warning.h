@@ -0,0 +1,10 @@
+#ifndef __ALT_WARNING_H__
+#define __ALT_WARNING_H__
+
+/*
+ * Host stand-in for the HAL sys/alt_warning.h.
+ */
+
+#define ALT_LINK_ERROR(msg) _Static_assert(0, msg)
+
+#endif /* __ALT_WARNING_H__ */
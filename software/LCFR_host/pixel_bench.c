@@ -0,0 +1,251 @@
+/*
+ * Pixel buffer driver benchmark on the host backend (vga_host.c). For each
+ * colour depth, times the fills prvVGAOutTask issues every frame (a 539x200
+ * box and a full clear_screen) and reports pixels per microsecond of host
+ * time and bus writes per pixel, which is what the board pays for. Then
+ * times draw_line on short graph segments like display.c draws and on long
+ * lines, in lines per second and writes per line. Each fill and line is
+ * first checked pixel for pixel against single pixel draws.
+ *
+ * Build: gcc -O2 -Iinc -I../LCFR_bsp -I../LCFR_bsp/drivers/inc -o pixel_bench pixel_bench.c vga_host.c host_io.c \
+ *            ../LCFR_bsp/drivers/src/altera_up_avalon_video_pixel_buffer_dma.c \
+ *            ../LCFR_bsp/drivers/src/altera_up_avalon_video_character_buffer_with_dma.c
+ * Usage: pixel_bench [-r repeats] [-l]
+ *        Each repeat draws the box and screen once and 1000 graph segments
+ *        -l uses linear addressing instead of XY (the board uses XY)
+ */
+
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "system.h"
+#include "vga_host.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define TEST_COLOR 0x2A5A9A5B	// Some bits set in every channel of every depth
+#define NUM_LINES 1000
+#define ABS(x) (((x) >= 0) ? (x) : -(x))
+
+/*=============*/
+/* Structures. */
+/*=============*/
+typedef struct {
+	int x0, y0, x1, y1;
+} Line;
+
+/*===================*/
+/* Global Variables. */
+/*===================*/
+static const char *depth_names[] = { "", "8-bit", "16-bit", "24-bit", "30-bit" };
+static unsigned char expected[VGA_HOST_HEIGHT][VGA_HOST_WIDTH][3];
+static Line segments[NUM_LINES], long_lines[NUM_LINES];
+
+/*============*/
+/* Functions. */
+/*============*/
+static double wall_seconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int same_pixel(unsigned int x, unsigned int y, const unsigned char rgb[3]) {
+	unsigned char got[3];
+	vga_host_pixel(x, y, got);
+	return memcmp(got, rgb, 3) == 0;
+}
+
+// Box (x0,y0)-(x1,y1) must be TEST_COLOR inside and black outside
+static int check_box(alt_up_pixel_buffer_dma_dev *pixel_buf, int x0, int y0, int x1, int y1) {
+	static const unsigned char black[3] = { 0, 0, 0 };
+	unsigned char color[3];
+	int x, y;
+
+	alt_up_pixel_buffer_dma_clear_screen(pixel_buf, 0);
+	alt_up_pixel_buffer_dma_draw(pixel_buf, TEST_COLOR, 0, 0);
+	vga_host_pixel(0, 0, color);
+	alt_up_pixel_buffer_dma_clear_screen(pixel_buf, 0);
+
+	alt_up_pixel_buffer_dma_draw_box(pixel_buf, x0, y0, x1, y1, TEST_COLOR, 0);
+	for (y = 0; y < VGA_HOST_HEIGHT; y++) {
+		for (x = 0; x < VGA_HOST_WIDTH; x++) {
+			int inside = (x >= x0) && (x <= x1) && (y >= y0) && (y <= y1);
+			if (!same_pixel(x, y, inside ? color : black)) {
+				fprintf(stderr, "Box (%d,%d)-(%d,%d) wrong at (%d,%d)\n", x0, y0, x1, y1, x, y);
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+// The driver's Bresenham walk, one alt_up_pixel_buffer_dma_draw per pixel
+static void reference_line(alt_up_pixel_buffer_dma_dev *pixel_buf, int x0, int y0, int x1, int y1) {
+	int steep = ABS(y1 - y0) > ABS(x1 - x0), t, x, y, deltax, deltay, error, ystep;
+
+	if (steep) {
+		t = x0; x0 = y0; y0 = t;
+		t = x1; x1 = y1; y1 = t;
+	}
+	if (x0 > x1) {
+		t = x0; x0 = x1; x1 = t;
+		t = y0; y0 = y1; y1 = t;
+	}
+	deltax = x1 - x0;
+	deltay = ABS(y1 - y0);
+	error = -(deltax / 2);
+	ystep = (y0 < y1) ? 1 : -1;
+	for (x = x0, y = y0; x <= x1; x++) {
+		if (steep) {
+			alt_up_pixel_buffer_dma_draw(pixel_buf, TEST_COLOR, y, x);
+		} else {
+			alt_up_pixel_buffer_dma_draw(pixel_buf, TEST_COLOR, x, y);
+		}
+		error += deltay;
+		if (error > 0) {
+			y += ystep;
+			error -= deltax;
+		}
+	}
+}
+
+static int check_lines(alt_up_pixel_buffer_dma_dev *pixel_buf, const Line *lines, int count) {
+	int i, x, y;
+
+	alt_up_pixel_buffer_dma_clear_screen(pixel_buf, 0);
+	for (i = 0; i < count; i++) {
+		reference_line(pixel_buf, lines[i].x0, lines[i].y0, lines[i].x1, lines[i].y1);
+	}
+	for (y = 0; y < VGA_HOST_HEIGHT; y++) {
+		for (x = 0; x < VGA_HOST_WIDTH; x++) {
+			vga_host_pixel(x, y, expected[y][x]);
+		}
+	}
+
+	alt_up_pixel_buffer_dma_clear_screen(pixel_buf, 0);
+	for (i = 0; i < count; i++) {
+		alt_up_pixel_buffer_dma_draw_line(pixel_buf, lines[i].x0, lines[i].y0, lines[i].x1, lines[i].y1, TEST_COLOR, 0);
+	}
+	for (y = 0; y < VGA_HOST_HEIGHT; y++) {
+		for (x = 0; x < VGA_HOST_WIDTH; x++) {
+			if (!same_pixel(x, y, expected[y][x])) {
+				fprintf(stderr, "Lines differ at (%d,%d)\n", x, y);
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+// Graph segments are about 5 pixels across and up to a division high,
+// long lines go anywhere on screen. Both include every octant.
+static void make_lines(void) {
+	int i;
+
+	srand(1);
+	for (i = 0; i < NUM_LINES; i++) {
+		segments[i].x0 = 101 + rand() % 530;
+		segments[i].x1 = segments[i].x0 + 5 + (i & 1);
+		segments[i].y0 = 50 + rand() % 100;
+		segments[i].y1 = segments[i].y0 + (rand() % 101) - 50;
+		if (i % 4 == 2) {
+			segments[i].y1 = segments[i].y0; // Steady frequency
+		}
+		long_lines[i].x0 = rand() % VGA_HOST_WIDTH;
+		long_lines[i].y0 = rand() % VGA_HOST_HEIGHT;
+		long_lines[i].x1 = rand() % VGA_HOST_WIDTH;
+		long_lines[i].y1 = rand() % VGA_HOST_HEIGHT;
+	}
+}
+
+static void report_lines(const char *name, alt_up_pixel_buffer_dma_dev *pixel_buf, const Line *lines, int repeats) {
+	VgaCounters counters;
+	double start, seconds;
+	int i, r;
+
+	vga_host_clear_counters();
+	start = wall_seconds();
+	for (r = 0; r < repeats; r++) {
+		for (i = 0; i < NUM_LINES; i++) {
+			alt_up_pixel_buffer_dma_draw_line(pixel_buf, lines[i].x0, lines[i].y0, lines[i].x1, lines[i].y1, TEST_COLOR, 0);
+		}
+	}
+	seconds = wall_seconds() - start;
+	vga_host_counters(&counters);
+	printf("  %-14s %8.0f lines/s    %7.1f writes/line\n", name, (double) repeats * NUM_LINES / seconds,
+			(double) counters.pixel_writes / repeats / NUM_LINES);
+}
+
+static void report(const char *name, unsigned long long pixels, double seconds) {
+	VgaCounters counters;
+	vga_host_counters(&counters);
+	printf("  %-14s %8.1f pixels/us  %5.3f writes/pixel  %6.2f bytes/write\n", name, pixels / seconds / 1e6,
+			(double) counters.pixel_writes / pixels, (double) counters.pixel_bytes / counters.pixel_writes);
+}
+
+int main(int argc, char *argv[]) {
+	int repeats = 200, addressing_mode = ALT_UP_PIXEL_BUFFER_XY_ADDRESS_MODE;
+	int opt, color_mode, i;
+
+	make_lines();
+	while ((opt = getopt(argc, argv, "r:l")) != -1) {
+		switch (opt) {
+			case 'r':
+				repeats = atoi(optarg);
+				break;
+			case 'l':
+				addressing_mode = ALT_UP_PIXEL_BUFFER_CONSECUTIVE_ADDRESS_MODE;
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-r repeats] [-l]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	for (color_mode = ALT_UP_8BIT_COLOR_MODE; color_mode <= ALT_UP_30BIT_COLOR_MODE; color_mode++) {
+		vga_host_init(color_mode, addressing_mode);
+		alt_up_pixel_buffer_dma_dev *pixel_buf = alt_up_pixel_buffer_dma_open_dev(VIDEO_PIXEL_BUFFER_DMA_NAME);
+		double start;
+
+		// Every alignment of both ends, and the clipped edge of the screen
+		for (i = 0; i < 4; i++) {
+			if ((check_box(pixel_buf, 100 + i, 7, 103 + 3 * i, 9) != 0) ||
+					(check_box(pixel_buf, 101 + i, 0, VGA_HOST_WIDTH + 5, VGA_HOST_HEIGHT - 1) != 0)) {
+				return 1;
+			}
+		}
+		if ((check_lines(pixel_buf, segments, NUM_LINES) != 0) || (check_lines(pixel_buf, long_lines, 100) != 0)) {
+			return 1;
+		}
+		printf("%s colour, %s addressing\n", depth_names[color_mode],
+				(addressing_mode == ALT_UP_PIXEL_BUFFER_XY_ADDRESS_MODE) ? "XY" : "linear");
+
+		// The graph boxes prvVGAOutTask clears every frame
+		vga_host_clear_counters();
+		start = wall_seconds();
+		for (i = 0; i < repeats; i++) {
+			alt_up_pixel_buffer_dma_draw_box(pixel_buf, 101, 0, 639, 199, 0, 0);
+		}
+		report("draw_box", (unsigned long long) repeats * 539 * 200, wall_seconds() - start);
+
+		vga_host_clear_counters();
+		start = wall_seconds();
+		for (i = 0; i < repeats; i++) {
+			alt_up_pixel_buffer_dma_clear_screen(pixel_buf, 0);
+		}
+		report("clear_screen", (unsigned long long) repeats * VGA_HOST_WIDTH * VGA_HOST_HEIGHT, wall_seconds() - start);
+
+		report_lines("graph segments", pixel_buf, segments, repeats);
+		report_lines("long lines", pixel_buf, long_lines, repeats / 10 + 1);
+	}
+	return 0;
+}
@@ -0,0 +1,94 @@
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <string.h>
+
+#include "plant.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define PLANT_STEP 0.001 // Integration step in seconds
+
+/*============*/
+/* Functions. */
+/*============*/
+void plant_init(Plant *plant) {
+	int i;
+	memset(plant, 0, sizeof(Plant));
+
+	plant->nominal = 50.0;
+	plant->inertia = 4.0;
+	plant->damping = 1.0;
+	plant->droop = 0.05;
+	plant->governor_lag = 0.5;
+	plant->reserve = 0.05;
+	plant->trip_time = 2.0;
+	plant->trip_size = 0.25;
+	for (i = 0; i < RELAY_NUM_LOADS; i++) {
+		plant->load_power[i] = 1.0 / RELAY_NUM_LOADS;
+	}
+
+	plant->mechanical = 1.0;
+}
+
+double plant_frequency(const Plant *plant) {
+	return plant->nominal * (1.0 + plant->deviation);
+}
+
+// Integrate one step of dt seconds with the given connected load
+static void plant_integrate(Plant *plant, double load, double dt) {
+	double lost = plant->tripped ? plant->trip_size : 0.0;
+	double setpoint = 1.0 - lost;
+	double capacity = 1.0 + plant->reserve - lost;
+
+	// Governor with droop, limited by the remaining units' capacity
+	double target = setpoint - plant->deviation / plant->droop;
+	if (target > capacity) {
+		target = capacity;
+	} else if (target < 0) {
+		target = 0;
+	}
+	plant->mechanical += (target - plant->mechanical) * dt / plant->governor_lag;
+
+	// Swing equation
+	double electrical = load + plant->damping * plant->deviation;
+	plant->deviation += (plant->mechanical - electrical) * dt / (2.0 * plant->inertia);
+	plant->time += dt;
+}
+
+// Advance the plant by one cycle with the given loads connected and return the frequency analyser sample count
+unsigned int plant_next(Plant *plant, const int loads[RELAY_NUM_LOADS]) {
+	double load = 0, remaining, freq;
+	int i;
+
+	for (i = 0; i < RELAY_NUM_LOADS; i++) {
+		if (loads[i] == 1) {
+			load += plant->load_power[i];
+		}
+	}
+
+	freq = plant_frequency(plant);
+	if (freq < 1.0) {
+		freq = 1.0; // A collapsed grid still gets sampled
+	}
+
+	remaining = 1.0 / freq;
+	while (remaining > 0) {
+		double dt = (remaining < PLANT_STEP) ? remaining : PLANT_STEP;
+
+		if (!plant->tripped && plant->time + dt >= plant->trip_time) {
+			plant->tripped = 1;
+			plant->mechanical -= plant->trip_size;
+		}
+		plant_integrate(plant, load, dt);
+		remaining -= dt;
+	}
+
+	freq = plant_frequency(plant);
+	if (freq < 1.0) {
+		freq = 1.0;
+	}
+	return (unsigned int) (SAMPLE_FREQ / freq + 0.5);
+}
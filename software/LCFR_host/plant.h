@@ -0,0 +1,38 @@
+#ifndef PLANT_H_
+#define PLANT_H_
+
+#include "relay.h"
+
+/*=============*/
+/* Structures. */
+/*=============*/
+// Single-area swing equation model of the grid the relay sits on, in per unit
+// of the total load. A generator trip removes trip_size of generation at
+// trip_time; the governor of the remaining units picks up what it can.
+typedef struct {
+	// Parameters
+	double nominal;				// Hz
+	double inertia;				// H, seconds
+	double damping;				// D, load change per unit frequency change
+	double droop;				// R, governor droop per unit
+	double governor_lag;		// Tg, seconds
+	double reserve;				// Spinning reserve above the pre-trip generation
+	double trip_time;			// Seconds
+	double trip_size;
+	double load_power[RELAY_NUM_LOADS];
+
+	// State
+	double time;
+	double deviation;			// Per unit frequency deviation
+	double mechanical;			// Per unit generation
+	int tripped;
+} Plant;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+void plant_init(Plant *plant);
+double plant_frequency(const Plant *plant);
+unsigned int plant_next(Plant *plant, const int loads[RELAY_NUM_LOADS]);
+
+#endif /* PLANT_H_ */
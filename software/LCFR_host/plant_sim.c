@@ -0,0 +1,170 @@
+/*
+ * Closed-loop plant simulator. Couples the relay to a swing equation grid
+ * model so shedding changes the frequency it measures, then reports nadir,
+ * time to recover and overshoot with the relay active and with it bypassed.
+ *
+ * Build: gcc -O2 -I../LCFR -o plant_sim plant_sim.c plant.c ../LCFR/relay.c -lm
+ * Usage: plant_sim [-s seconds] [-g trip_size] [-H inertia] [-r reserve] [-f recover_freq] [-o trace.csv]
+ */
+
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "relay.h"
+#include "plant.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define DECIDE_PERIOD 20 // Milliseconds between relay_step calls, as prvDecideTask
+
+/*=============*/
+/* Structures. */
+/*=============*/
+typedef struct {
+	double nadir;
+	double peak;				// Highest frequency after the trip
+	double recover_time;		// Seconds from the trip until the frequency last rose through recover_freq, -1 if it never settled
+	unsigned int shed_count;
+	int loads_connected;
+	unsigned long samples;
+} Outcome;
+
+/*============*/
+/* Functions. */
+/*============*/
+static double wall_seconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Run one scenario. With bypass set the relay is held in maintenance so it never sheds
+static Outcome run(const Plant *scenario, double seconds, double recover_freq, int bypass, FILE *trace) {
+	Outcome outcome = { 1e9, 0, -1, 0, 0, 0 };
+	Plant plant = *scenario;
+	Relay relay;
+	unsigned int next_decide = DECIDE_PERIOD;
+	unsigned int end = (unsigned int) (seconds * 1000);
+	int i, below = 0;
+
+	relay_init(&relay);
+	relay_set_frequency(&relay, plant.nominal);
+	relay_set_maintenance(&relay, bypass);
+
+	while (next_decide <= end) {
+		unsigned int count = plant_next(&plant, relay.loads);
+		unsigned int now = (unsigned int) (plant.time * 1000);
+		double freq = plant_frequency(&plant);
+
+		while (next_decide < now && next_decide <= end) {
+			relay_step(&relay, 0xff, next_decide);
+			next_decide += DECIDE_PERIOD;
+		}
+		relay_measure(&relay, count, now);
+		outcome.samples++;
+
+		if (plant.tripped) {
+			if (freq < outcome.nadir) {
+				outcome.nadir = freq;
+			}
+			if (freq > outcome.peak) {
+				outcome.peak = freq;
+			}
+			if (freq < recover_freq) {
+				below = 1;
+				outcome.recover_time = -1;
+			} else if (below) {
+				below = 0;
+				outcome.recover_time = plant.time - plant.trip_time;
+			}
+		}
+
+		if (trace != NULL) {
+			int bitmap = 0;
+			for (i = 0; i < RELAY_NUM_LOADS; i++) {
+				bitmap = (bitmap << 1) | relay.loads[i];
+			}
+			fprintf(trace, "%.4f,%.4f,%.4f,%d,%d\n", plant.time, freq, relay_roc_freq(&relay), bitmap, bypass);
+		}
+	}
+
+	outcome.shed_count = relay.shed_count;
+	for (i = 0; i < RELAY_NUM_LOADS; i++) {
+		outcome.loads_connected += relay.loads[i];
+	}
+	return outcome;
+}
+
+static void report(const char *name, const Plant *plant, const Outcome *outcome) {
+	printf("%s\n", name);
+	printf("  Nadir:            %.3f Hz\n", outcome->nadir);
+	printf("  Overshoot:        %.3f Hz\n", (outcome->peak > plant->nominal) ? outcome->peak - plant->nominal : 0.0);
+	if (outcome->recover_time >= 0) {
+		printf("  Time to recover:  %.3f s\n", outcome->recover_time);
+	} else {
+		printf("  Time to recover:  did not recover\n");
+	}
+	printf("  Loads shed:       %u (%d of %d connected at the end)\n", outcome->shed_count, outcome->loads_connected, RELAY_NUM_LOADS);
+}
+
+int main(int argc, char *argv[]) {
+	Plant plant;
+	double seconds = 30.0, recover_freq = 49.5;
+	FILE *trace = NULL;
+	int opt;
+
+	plant_init(&plant);
+	while ((opt = getopt(argc, argv, "s:g:H:r:f:o:")) != -1) {
+		switch (opt) {
+			case 's':
+				seconds = atof(optarg);
+				break;
+			case 'g':
+				plant.trip_size = atof(optarg);
+				break;
+			case 'H':
+				plant.inertia = atof(optarg);
+				break;
+			case 'r':
+				plant.reserve = atof(optarg);
+				break;
+			case 'f':
+				recover_freq = atof(optarg);
+				break;
+			case 'o':
+				trace = fopen(optarg, "w");
+				if (trace == NULL) {
+					perror(optarg);
+					return 1;
+				}
+				fprintf(trace, "time,freq,roc,loads,bypass\n");
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-s seconds] [-g trip_size] [-H inertia] [-r reserve] [-f recover_freq] [-o trace.csv]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	double start = wall_seconds();
+	Outcome with_relay = run(&plant, seconds, recover_freq, 0, trace);
+	Outcome without_relay = run(&plant, seconds, recover_freq, 1, trace);
+	double elapsed = wall_seconds() - start;
+
+	printf("Trip of %.2f pu at %.1f s, H = %.1f s, reserve %.2f pu, %.0f s simulated\n",
+			plant.trip_size, plant.trip_time, plant.inertia, plant.reserve, seconds);
+	report("Relay active", &plant, &with_relay);
+	report("Relay bypassed", &plant, &without_relay);
+	printf("Speed: %.0fx real time\n", 2 * seconds / elapsed);
+
+	if (trace != NULL) {
+		fclose(trace);
+	}
+	return 0;
+}
@@ -0,0 +1,349 @@
+/*
+ * PS/2 keyboard decode benchmark: runs the Altera UP keyboard driver
+ * (../LCFR_bsp/drivers/src/altera_up_ps2_keyboard.c) on a keystroke stream
+ * through a model of the PS/2 port's data register. The stream is either
+ * the keyboard bytes of an input capture (see replay.c) or synthetic
+ * typing: a make and a break code per key, E0 prefixed for extended keys.
+ *
+ * The driver finds a make code's key through direct-mapped tables; this
+ * first checks them against the linear search over the make code tables
+ * they replaced, for every code and for translate_make_code's text, then
+ * times both lookups over the stream's make codes, translate_make_code, and
+ * decode_scancode end to end per key. Times are in time stamp counter
+ * cycles on x86 and nanoseconds elsewhere.
+ *
+ * Build: gcc -O2 -Iinc -I../LCFR -I../LCFR_bsp -I../LCFR_bsp/drivers/inc -o ps2_bench ps2_bench.c host_io.c \
+ *            ../LCFR_bsp/drivers/src/altera_up_avalon_ps2.c ../LCFR_bsp/drivers/src/altera_up_ps2_keyboard.c
+ * Usage: ps2_bench [-i inputs.bin] [-k keys] [-n passes] [-S seed]
+ */
+
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "system.h"
+#include "altera_up_avalon_ps2.h"
+#include "altera_up_avalon_ps2_regs.h"
+#include "altera_up_ps2_keyboard.h"
+#include "input_log.h"
+#include "host_io.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define SCAN_CODE_NUM 102		// As altera_up_ps2_keyboard.c
+#define NO_KEY SCAN_CODE_NUM
+#define MAX_STREAM (1 << 22)
+
+/*=============*/
+/* Structures. */
+/*=============*/
+// The port's receive FIFO, holding the whole stream
+typedef struct {
+	const unsigned char *bytes;
+	int length;
+	int next;
+} Ps2Model;
+
+typedef struct {
+	alt_u8 code;
+	int extended;
+} MakeCode;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+// Not in altera_up_ps2_keyboard.h
+extern char *key_table[];
+extern alt_u8 single_byte_make_code[];
+extern alt_u8 multi_byte_make_code[];
+extern unsigned get_single_byte_make_code_index(alt_u8 code);
+extern unsigned get_multi_byte_make_code_index(alt_u8 code);
+
+/*===================*/
+/* Global Variables. */
+/*===================*/
+static Ps2Model model;
+static alt_up_ps2_dev ps2 = { .dev = { .llist = ALT_LLIST_ENTRY, .name = PS2_NAME }, .base = PS2_BASE, .irq_id = PS2_IRQ, .timeout = 0, .device_type = PS2_KEYBOARD };
+static HostIoRegion *ps2_region;
+static unsigned char stream[MAX_STREAM];
+static MakeCode makes[MAX_STREAM / 2];
+static int num_makes;
+volatile unsigned sink;
+
+/*============*/
+/* Functions. */
+/*============*/
+static unsigned long long now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+// Reading the data register pops a byte, RAVAIL counting it
+static unsigned int ps2_registers(void *context, unsigned int offset, unsigned int data, int bytes, int write) {
+	Ps2Model *port = (Ps2Model *) context;
+	unsigned int available;
+
+	(void) data;
+	(void) bytes;
+
+	if (write || (offset != ALT_UP_PS2_PORT_DATA_REG * 4) || (port->next == port->length)) {
+		return 0;
+	}
+	available = port->length - port->next;
+	return port->bytes[port->next++] | ALT_UP_PS2_PORT_DATA_REG_RVALID_MSK
+			| ((available > 0xffff ? 0xffff : available) << ALT_UP_PS2_PORT_DATA_REG_RAVAIL_OFST);
+}
+
+// The lookups the tables replaced
+static unsigned linear_single_index(alt_u8 code) {
+	unsigned i;
+	for (i = 0; i < SCAN_CODE_NUM; i++) {
+		if (single_byte_make_code[i] == code) {
+			return i;
+		}
+	}
+	return NO_KEY;
+}
+
+static unsigned linear_multi_index(alt_u8 code) {
+	unsigned i;
+	for (i = 0; i < SCAN_CODE_NUM; i++) {
+		if (multi_byte_make_code[i] == code) {
+			return i;
+		}
+	}
+	return NO_KEY;
+}
+
+static void linear_translate(KB_CODE_TYPE mode, alt_u8 code, char *str) {
+	unsigned idx = NO_KEY;
+	if ((mode == KB_ASCII_MAKE_CODE) || (mode == KB_BINARY_MAKE_CODE)) {
+		idx = linear_single_index(code);
+	} else if (mode == KB_LONG_BINARY_MAKE_CODE) {
+		idx = linear_multi_index(code);
+	}
+	strcpy(str, (idx == NO_KEY) ? "" : key_table[idx]);
+}
+
+// Code 0 is the keyboard's error code and no key's; the linear search
+// returned the first key without a make code of that kind for it
+static int check(void) {
+	static const KB_CODE_TYPE modes[] = { KB_ASCII_MAKE_CODE, KB_BINARY_MAKE_CODE, KB_LONG_BINARY_MAKE_CODE, KB_BREAK_CODE };
+	char expected[16], got[16];
+	int code;
+	unsigned int m;
+
+	for (code = 1; code < 256; code++) {
+		if ((get_single_byte_make_code_index(code) != linear_single_index(code))
+				|| (get_multi_byte_make_code_index(code) != linear_multi_index(code))) {
+			fprintf(stderr, "Code 0x%02x: table %u/%u, linear search %u/%u\n", code, get_single_byte_make_code_index(code),
+					get_multi_byte_make_code_index(code), linear_single_index(code), linear_multi_index(code));
+			return -1;
+		}
+		for (m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+			strcpy(got, "x");
+			linear_translate(modes[m], code, expected);
+			translate_make_code(modes[m], code, got);
+			if (strcmp(expected, got) != 0) {
+				fprintf(stderr, "Code 0x%02x mode %d: \"%s\", expected \"%s\"\n", code, modes[m], got, expected);
+				return -1;
+			}
+		}
+	}
+	if ((get_single_byte_make_code_index(0) != NO_KEY) || (get_multi_byte_make_code_index(0) != NO_KEY)) {
+		fprintf(stderr, "Code 0 found a key\n");
+		return -1;
+	}
+	return 0;
+}
+
+static int load_capture(const char *path) {
+	unsigned int header[4];
+	InputEvent input, *event = &input; // INPUT_TYPE needs a pointer named event
+	int length = 0;
+	FILE *file = fopen(path, "rb");
+
+	if (file == NULL) {
+		perror(path);
+		return -1;
+	}
+	if (fread(header, sizeof(header), 1, file) != 1 || header[0] != INPUT_LOG_MAGIC || header[2] > header[1]) {
+		fprintf(stderr, "%s: not an input capture\n", path);
+		fclose(file);
+		return -1;
+	}
+	while ((header[2]-- > 0) && (fread(&input, sizeof(input), 1, file) == 1) && (length < MAX_STREAM)) {
+		if (INPUT_TYPE(event) == INPUT_PS2) {
+			stream[length++] = INPUT_VALUE(event);
+		}
+	}
+	fclose(file);
+	if (length == 0) {
+		fprintf(stderr, "%s: no keyboard bytes\n", path);
+		return -1;
+	}
+	return length;
+}
+
+// Keys picked at random from the table, pressed and released in turn
+static int synthesize(int keys) {
+	int length = 0, i;
+
+	for (i = 0; (i < keys) && (length + 5 <= MAX_STREAM); i++) {
+		int key = rand() % SCAN_CODE_NUM;
+		if (single_byte_make_code[key] != 0) {
+			stream[length++] = single_byte_make_code[key];
+			stream[length++] = 0xF0;
+			stream[length++] = single_byte_make_code[key];
+		} else {
+			stream[length++] = 0xE0;
+			stream[length++] = multi_byte_make_code[key];
+			stream[length++] = 0xE0;
+			stream[length++] = 0xF0;
+			stream[length++] = multi_byte_make_code[key];
+		}
+	}
+	return length;
+}
+
+// One pass of decode_scancode over the stream, collecting the make codes.
+// Returns the codes decoded, makes and breaks.
+static int decode_pass(int collect) {
+	KB_CODE_TYPE mode;
+	alt_u8 code;
+	char ascii;
+	int decoded = 0;
+
+	model.next = 0;
+	while (decode_scancode(&ps2, &mode, &code, &ascii) == 0) {
+		if (collect && ((mode == KB_ASCII_MAKE_CODE) || (mode == KB_BINARY_MAKE_CODE) || (mode == KB_LONG_BINARY_MAKE_CODE))) {
+			makes[num_makes].code = code;
+			makes[num_makes].extended = (mode == KB_LONG_BINARY_MAKE_CODE);
+			num_makes++;
+		}
+		decoded++;
+	}
+	return decoded;
+}
+
+int main(int argc, char *argv[]) {
+	const char *capture = NULL;
+	int keys = 100000, passes = 100, opt, i, p, decoded;
+	unsigned int seed = 1;
+	unsigned long long start, elapsed;
+	double linear, table, linear_text, table_text, decode;
+	char text[16];
+
+	while ((opt = getopt(argc, argv, "i:k:n:S:")) != -1) {
+		switch (opt) {
+			case 'i':
+				capture = optarg;
+				break;
+			case 'k':
+				keys = atoi(optarg);
+				break;
+			case 'n':
+				passes = atoi(optarg);
+				break;
+			case 'S':
+				seed = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-i inputs.bin] [-k keys] [-n passes] [-S seed]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if (check() != 0) {
+		return 1;
+	}
+	printf("Checked make code lookups and key names for every code against the linear search\n");
+
+	srand(seed);
+	model.bytes = stream;
+	model.length = (capture != NULL) ? load_capture(capture) : synthesize(keys);
+	if (model.length <= 0) {
+		return 1;
+	}
+	ps2_region = host_io_map_registers("ps2", PS2_BASE, PS2_SPAN, ps2_registers, &model);
+
+	decoded = decode_pass(1);
+	if (num_makes == 0) {
+		fprintf(stderr, "No make codes in the stream\n");
+		return 1;
+	}
+	printf("%d bytes, %d codes, %d key presses%s\n", model.length, decoded, num_makes,
+			(model.next < model.length) ? " (stopped at an unfinished sequence)" : "");
+
+	start = now();
+	for (p = 0; p < passes; p++) {
+		for (i = 0; i < num_makes; i++) {
+			sink += makes[i].extended ? linear_multi_index(makes[i].code) : linear_single_index(makes[i].code);
+		}
+	}
+	linear = (double) (now() - start) / ((double) passes * num_makes);
+
+	start = now();
+	for (p = 0; p < passes; p++) {
+		for (i = 0; i < num_makes; i++) {
+			sink += makes[i].extended ? get_multi_byte_make_code_index(makes[i].code)
+					: get_single_byte_make_code_index(makes[i].code);
+		}
+	}
+	table = (double) (now() - start) / ((double) passes * num_makes);
+
+	start = now();
+	for (p = 0; p < passes; p++) {
+		for (i = 0; i < num_makes; i++) {
+			linear_translate(makes[i].extended ? KB_LONG_BINARY_MAKE_CODE : KB_BINARY_MAKE_CODE, makes[i].code, text);
+			sink += text[0];
+		}
+	}
+	linear_text = (double) (now() - start) / ((double) passes * num_makes);
+
+	start = now();
+	for (p = 0; p < passes; p++) {
+		for (i = 0; i < num_makes; i++) {
+			translate_make_code(makes[i].extended ? KB_LONG_BINARY_MAKE_CODE : KB_BINARY_MAKE_CODE, makes[i].code, text);
+			sink += text[0];
+		}
+	}
+	table_text = (double) (now() - start) / ((double) passes * num_makes);
+
+	host_io_clear_counters();
+	elapsed = 0;
+	for (p = 0; p < passes; p++) {
+		start = now();
+		decode_pass(0);
+		elapsed += now() - start;
+	}
+	decode = (double) elapsed / ((double) passes * num_makes);
+
+	printf("%-22s %12s %12s %8s   (%s per key press)\n", "", "linear", "table", "speedup",
+#if defined(__x86_64__) || defined(__i386__)
+			"cycles"
+#else
+			"ns"
+#endif
+	);
+	printf("%-22s %12.1f %12.1f %7.1fx\n", "make code index", linear, table, linear / table);
+	printf("%-22s %12.1f %12.1f %7.1fx\n", "translate_make_code", linear_text, table_text, linear_text / table_text);
+	printf("%-22s %25.1f   (%.1f register reads)\n", "decode_scancode", decode,
+			(double) ps2_region->reads / ((double) passes * num_makes));
+	return 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * Input replayer. Feeds a capture of every relay input (see input_log.h)
+ * back through the relay and keypad logic on a virtual clock and prints the
+ * resulting shed timeline, so a decision logic change can be checked for a
+ * bit-identical timeline against the previous build.
+ *
+ * Build: gcc -O2 -I../LCFR -o replay replay.c trace.c ../LCFR/relay.c ../LCFR/keypad.c ../LCFR/format.c -lm
+ * Usage: replay [-c expected_timeline.txt] [-o timeline.txt] inputs.bin
+ *        replay -g trace.lcft inputs.bin      make a capture from a frequency trace,
+ *                                             with a decision cycle every 20 ms
+ */
+
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "relay.h"
+#include "keypad.h"
+#include "input_log.h"
+#include "trace.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define DECIDE_PERIOD 20 // Milliseconds between relay_step calls, as prvDecideTask
+
+/*============*/
+/* Functions. */
+/*============*/
+static double wall_seconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Only the used part of the capture is read, the dump is mostly empty capacity
+static InputEvent *load_capture(const char *path, unsigned int *count) {
+	unsigned int header[4];
+	InputEvent *events;
+	FILE *file = fopen(path, "rb");
+
+	if (file == NULL) {
+		perror(path);
+		return NULL;
+	}
+	if (fread(header, sizeof(header), 1, file) != 1 || header[0] != INPUT_LOG_MAGIC || header[2] > header[1]) {
+		fprintf(stderr, "%s: not an input capture\n", path);
+		fclose(file);
+		return NULL;
+	}
+	if (header[3] > 0) {
+		fprintf(stderr, "%s: warning, %u events were dropped after the log filled\n", path, header[3]);
+	}
+
+	*count = header[2];
+	events = malloc((*count + 1) * sizeof(InputEvent));
+	if (events == NULL || fread(events, sizeof(InputEvent), *count, file) != *count) {
+		fprintf(stderr, "%s: truncated capture\n", path);
+		fclose(file);
+		free(events);
+		return NULL;
+	}
+	fclose(file);
+	return events;
+}
+
+static int write_event(FILE *file, unsigned int type, unsigned int value, unsigned int time) {
+	InputEvent event;
+	event.time = time;
+	event.event = (type << 24) | (value & 0xffffff);
+	return fwrite(&event, sizeof(event), 1, file) == 1 ? 0 : -1;
+}
+
+// Turn a frequency trace into a capture, interleaving decision cycles as the firmware would
+static int generate(const char *trace_path, const char *out_path) {
+	uint32_t counts[TRACE_BLOCK_SAMPLES];
+	uint64_t times[TRACE_BLOCK_SAMPLES];
+	unsigned int header[4] = { INPUT_LOG_MAGIC, INPUT_LOG_CAPACITY, 0, 0 };
+	unsigned int block, next_decide = DECIDE_PERIOD;
+	TraceReader reader;
+	FILE *out;
+	int i, n;
+
+	if (trace_reader_open(&reader, trace_path) != 0) {
+		fprintf(stderr, "%s: not a readable trace\n", trace_path);
+		return 1;
+	}
+	out = fopen(out_path, "wb");
+	if (out == NULL) {
+		perror(out_path);
+		return 1;
+	}
+	fwrite(header, sizeof(header), 1, out);
+
+	for (block = 0; block < reader.header->num_blocks; block++) {
+		n = trace_read_block(&reader, block, counts, times);
+		if (n < 0) {
+			fprintf(stderr, "%s: block %u is corrupt\n", trace_path, block);
+			return 1;
+		}
+		for (i = 0; i < n; i++) {
+			unsigned int now = (unsigned int) (times[i] - reader.index[0].first_time);
+			while (next_decide < now) {
+				write_event(out, INPUT_DECIDE, 0xff, next_decide);
+				next_decide += DECIDE_PERIOD;
+				header[2]++;
+			}
+			write_event(out, INPUT_FREQ, counts[i], now);
+			header[2]++;
+		}
+	}
+
+	header[1] = (header[2] > INPUT_LOG_CAPACITY) ? header[2] : INPUT_LOG_CAPACITY;
+	fseek(out, 0, SEEK_SET);
+	fwrite(header, sizeof(header), 1, out);
+	fclose(out);
+	trace_reader_close(&reader);
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	const char *expected_path = NULL, *out_path = NULL, *trace_path = NULL;
+	FILE *out = stdout, *expected = NULL;
+	InputEvent *events;
+	unsigned int count, i;
+	Relay relay;
+	Keypad keypad;
+	int opt, mismatch = 0;
+	unsigned long lines = 0;
+
+	while ((opt = getopt(argc, argv, "c:o:g:")) != -1) {
+		switch (opt) {
+			case 'c':
+				expected_path = optarg;
+				break;
+			case 'o':
+				out_path = optarg;
+				break;
+			case 'g':
+				trace_path = optarg;
+				break;
+			default:
+				optind = argc + 1;
+				break;
+		}
+	}
+	if (optind != argc - 1) {
+		fprintf(stderr, "Usage: %s [-c expected_timeline.txt] [-o timeline.txt] inputs.bin\n"
+				"       %s -g trace.lcft inputs.bin\n", argv[0], argv[0]);
+		return 1;
+	}
+	if (trace_path != NULL) {
+		return generate(trace_path, argv[optind]);
+	}
+
+	events = load_capture(argv[optind], &count);
+	if (events == NULL) {
+		return 1;
+	}
+	if (out_path != NULL && (out = fopen(out_path, "w")) == NULL) {
+		perror(out_path);
+		return 1;
+	}
+	if (expected_path != NULL && (expected = fopen(expected_path, "r")) == NULL) {
+		perror(expected_path);
+		return 1;
+	}
+
+	// Same power-on state as main()
+	relay_init(&relay);
+	keypad_init(&keypad);
+
+	double start = wall_seconds();
+	int last_bitmap = -1, last_maintenance = -1;
+	for (i = 0; i < count && !mismatch; i++) {
+		const InputEvent *event = &events[i];
+		unsigned int value = INPUT_VALUE(event);
+		char line[96];
+		int bitmap = 0, k;
+
+		switch (INPUT_TYPE(event)) {
+			case INPUT_FREQ:
+				relay_measure(&relay, value, event->time);
+				break;
+			case INPUT_DECIDE:
+				relay_step(&relay, value, event->time);
+				break;
+			case INPUT_BUTTON:
+				relay_set_maintenance(&relay, !relay.maintenance);
+				break;
+			case INPUT_PS2:
+				keypad_byte(&keypad, &relay, (unsigned char) value);
+				break;
+			default:
+				fprintf(stderr, "Unknown event type %u at %u\n", INPUT_TYPE(event), i);
+				return 1;
+		}
+
+		for (k = 0; k < RELAY_NUM_LOADS; k++) {
+			bitmap = (bitmap << 1) | relay.loads[k];
+		}
+		if (bitmap == last_bitmap && relay.maintenance == last_maintenance) {
+			continue;
+		}
+		last_bitmap = bitmap;
+		last_maintenance = relay.maintenance;
+
+		snprintf(line, sizeof(line), "%u,%02x,%d\n", event->time, bitmap, relay.maintenance);
+		fputs(line, out);
+		lines++;
+
+		if (expected != NULL) {
+			char want[96];
+			if (fgets(want, sizeof(want), expected) == NULL || strcmp(want, line) != 0) {
+				fprintf(stderr, "Timeline differs at line %lu: expected %s", lines, feof(expected) ? "end of file\n" : want);
+				fprintf(stderr, "                              got      %s", line);
+				mismatch = 1;
+			}
+		}
+	}
+	double elapsed = wall_seconds() - start;
+
+	if (expected != NULL && !mismatch) {
+		char want[96];
+		if (fgets(want, sizeof(want), expected) != NULL) {
+			fprintf(stderr, "Timeline ends early, expected %s", want);
+			mismatch = 1;
+		}
+	}
+
+	if (count > 0) {
+		double span = (events[count - 1].time - events[0].time) / 1000.0;
+		fprintf(stderr, "%u events, %.1f s of capture replayed in %.3f s (%.0fx), %lu timeline entries, %u loads shed\n",
+				count, span, elapsed, span / elapsed, lines, relay.shed_count);
+	}
+	if (expected != NULL) {
+		fprintf(stderr, mismatch ? "MISMATCH\n" : "Timeline identical\n");
+		fclose(expected);
+	}
+	if (out != stdout) {
+		fclose(out);
+	}
+	free(events);
+	return mismatch;
+}
@@ -0,0 +1,55 @@
+/*
+ * FreeRTOS configuration for the host port in this directory. Matches
+ * ../../LCFR/FreeRTOS/FreeRTOSConfig.h apart from what the host needs:
+ * bigger stacks, no stack checking (each task runs on its own malloc'd
+ * stack) and tickless idle, which the virtual clock uses to skip ahead.
+ *
+ * The kernel headers include "FreeRTOSConfig.h" and "portmacro.h" from
+ * their own directory first, so host builds force these two in with
+ * -include; the shared include guards then hide the firmware versions.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#define configUSE_PREEMPTION			1
+#define configUSE_IDLE_HOOK				1	// Drives the virtual clock, see port.c
+#define configUSE_TICK_HOOK				0
+#define configUSE_TICKLESS_IDLE			1
+#define	configUSE_TIMERS				1
+#define configTIMER_TASK_PRIORITY		3
+#define configTIMER_QUEUE_LENGTH		10
+#define	configTIMER_TASK_STACK_DEPTH	2048
+#define configTICK_RATE_HZ				( ( TickType_t ) 1000 )
+#define configCPU_CLOCK_HZ				( ( unsigned long ) 100000000 )
+#define configMAX_PRIORITIES			( ( unsigned portBASE_TYPE ) 12 )
+#define configMINIMAL_STACK_SIZE		( 4096 )
+#define configTOTAL_HEAP_SIZE			( ( size_t ) 512000 )
+#define configMAX_TASK_NAME_LEN			( 8 )
+#define configUSE_TRACE_FACILITY		0
+#define configUSE_16_BIT_TICKS			0
+#define configIDLE_SHOULD_YIELD			0
+#define configUSE_MUTEXES				1
+#define configUSE_RECURSIVE_MUTEXES		1
+#define configUSE_COUNTING_SEMAPHORES	1
+#define configCHECK_FOR_STACK_OVERFLOW	0
+#define configQUEUE_REGISTRY_SIZE		0
+
+/* Co-routine definitions. */
+#define configUSE_CO_ROUTINES 			0
+#define configMAX_CO_ROUTINE_PRIORITIES ( 2 )
+
+#define INCLUDE_vTaskPrioritySet			0
+#define INCLUDE_uxTaskPriorityGet			0
+#define INCLUDE_vTaskDelete					1
+#define INCLUDE_vTaskCleanUpResources		1
+#define INCLUDE_vTaskSuspend				1	// Required by tickless idle
+#define INCLUDE_vTaskDelayUntil				0
+#define INCLUDE_vTaskDelay					1
+#define INCLUDE_uxTaskGetStackHighWaterMark	0
+#define INCLUDE_pcTaskGetTaskName			1	// Names go into the schedule hash
+
+#define configKERNEL_INTERRUPT_PRIORITY			0x01
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY	0x03
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,359 @@
+/*-----------------------------------------------------------
+ * Implementation of functions defined in portable.h for the host port.
+ * See portmacro.h for how the virtual clock works.
+ *----------------------------------------------------------*/
+
+/* Standard Includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define portTASK_STACK_BYTES	( 256 * 1024 )
+#define portMAX_PENDING_IRQS	256
+
+typedef struct {
+	ucontext_t context;
+	TaskFunction_t code;
+	void *parameters;
+	unsigned char stack[ portTASK_STACK_BYTES ];
+} PortTask;
+
+typedef struct {
+	uint64_t time;
+	uint64_t sequence;
+	unsigned int id;
+} PendingIRQ;
+
+typedef struct {
+	void (*handler)( void *, unsigned int );
+	void *context;
+} IRQHandler;
+
+/* The first member of the TCB is pxTopOfStack, which holds the PortTask. */
+extern void * volatile pxCurrentTCB;
+
+static ucontext_t xMainContext;
+static IRQHandler xHandlers[ portMAX_IRQ ];
+static PendingIRQ xPending[ portMAX_PENDING_IRQS ];	// Binary heap on ( time, sequence )
+static unsigned int uxPendingCount = 0;
+static uint64_t ullSequence = 0;
+static uint64_t ullNow = 0;
+static uint64_t ullEnd = UINT64_MAX;
+static uint64_t ullTickCount = 0;
+static int xYieldFromISR = 0;
+static PortStats xStats;
+
+/*-----------------------------------------------------------*/
+
+static PortTask *prvCurrentTask( void )
+{
+	return ( PortTask * ) **( StackType_t ** ) pxCurrentTCB;
+}
+/*-----------------------------------------------------------*/
+
+static void prvHash( uint64_t ullValue, const char *pcName )
+{
+uint64_t ullHash = xStats.schedule_hash;
+int i;
+
+	for( i = 0; i < 8; i++ )
+	{
+		ullHash = ( ullHash ^ ( ( ullValue >> ( i * 8 ) ) & 0xff ) ) * 0x100000001b3ULL;
+	}
+	while( ( pcName != NULL ) && ( *pcName != '\0' ) )
+	{
+		ullHash = ( ullHash ^ ( unsigned char ) *pcName++ ) * 0x100000001b3ULL;
+	}
+	xStats.schedule_hash = ullHash;
+}
+/*-----------------------------------------------------------*/
+
+static void prvHashSwitch( void )
+{
+	prvHash( ullNow, pcTaskGetTaskName( NULL ) );
+	xStats.context_switches++;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTaskEntry( void )
+{
+PortTask *pxTask = prvCurrentTask();
+
+	pxTask->code( pxTask->parameters );
+
+	/* Tasks must not return. */
+	fprintf( stderr, "[free_rtos] Task %s returned\n", pcTaskGetTaskName( NULL ) );
+	abort();
+}
+/*-----------------------------------------------------------*/
+
+StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters )
+{
+PortTask *pxTask = malloc( sizeof( PortTask ) );	// Not freed if the task is deleted, the simulations never do
+
+	if( pxTask == NULL )
+	{
+		fprintf( stderr, "[free_rtos] Out of memory for a task stack\n" );
+		abort();
+	}
+	pxTask->code = pxCode;
+	pxTask->parameters = pvParameters;
+	getcontext( &pxTask->context );
+	pxTask->context.uc_stack.ss_sp = pxTask->stack;
+	pxTask->context.uc_stack.ss_size = sizeof( pxTask->stack );
+	pxTask->context.uc_link = NULL;
+	makecontext( &pxTask->context, prvTaskEntry, 0 );
+
+	*pxTopOfStack = ( StackType_t ) pxTask;
+	return pxTopOfStack;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortStartScheduler( void )
+{
+	memset( &xStats, 0, sizeof( xStats ) );
+	xStats.schedule_hash = 0xcbf29ce484222325ULL;
+	prvHashSwitch();
+
+	/* Start the first task, vPortEndScheduler() comes back here. */
+	swapcontext( &xMainContext, &prvCurrentTask()->context );
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+	setcontext( &xMainContext );
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+PortTask *pxFrom = prvCurrentTask(), *pxTo;
+
+	vTaskSwitchContext();
+	pxTo = prvCurrentTask();
+	if( pxTo != pxFrom )
+	{
+		prvHashSwitch();
+		swapcontext( &pxFrom->context, &pxTo->context );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortYieldFromISR( void )
+{
+	/* Switch once the handler returns, as the Nios II port does on interrupt exit. */
+	xYieldFromISR = 1;
+}
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+void *pvReturn;
+
+	vTaskSuspendAll();
+	pvReturn = malloc( xWantedSize );
+	( void ) xTaskResumeAll();
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+	vTaskSuspendAll();
+	free( pv );
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+int alt_irq_register( unsigned int id, void *context, void (*handler)( void *, unsigned int ) )
+{
+	if( id >= portMAX_IRQ )
+	{
+		return -1;
+	}
+	xHandlers[ id ].handler = handler;
+	xHandlers[ id ].context = context;
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static int prvEarlier( const PendingIRQ *pxA, const PendingIRQ *pxB )
+{
+	return ( pxA->time < pxB->time ) || ( ( pxA->time == pxB->time ) && ( pxA->sequence < pxB->sequence ) );
+}
+/*-----------------------------------------------------------*/
+
+int xPortRaiseIRQ( unsigned int id, uint64_t ullTimeUs )
+{
+unsigned int uxChild, uxParent;
+PendingIRQ xNew;
+
+	if( ( id >= portMAX_IRQ ) || ( uxPendingCount == portMAX_PENDING_IRQS ) )
+	{
+		return -1;
+	}
+
+	/* An interrupt cannot be raised in the past. */
+	xNew.time = ( ullTimeUs < ullNow ) ? ullNow : ullTimeUs;
+	xNew.sequence = ullSequence++;
+	xNew.id = id;
+
+	for( uxChild = uxPendingCount++; uxChild > 0; uxChild = uxParent )
+	{
+		uxParent = ( uxChild - 1 ) / 2;
+		if( !prvEarlier( &xNew, &xPending[ uxParent ] ) )
+		{
+			break;
+		}
+		xPending[ uxChild ] = xPending[ uxParent ];
+	}
+	xPending[ uxChild ] = xNew;
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static PendingIRQ prvPopIRQ( void )
+{
+PendingIRQ xFirst = xPending[ 0 ], xLast = xPending[ --uxPendingCount ];
+unsigned int uxParent = 0, uxChild;
+
+	for( ;; )
+	{
+		uxChild = uxParent * 2 + 1;
+		if( uxChild >= uxPendingCount )
+		{
+			break;
+		}
+		if( ( uxChild + 1 < uxPendingCount ) && prvEarlier( &xPending[ uxChild + 1 ], &xPending[ uxChild ] ) )
+		{
+			uxChild++;
+		}
+		if( !prvEarlier( &xPending[ uxChild ], &xLast ) )
+		{
+			break;
+		}
+		xPending[ uxParent ] = xPending[ uxChild ];
+		uxParent = uxChild;
+	}
+	xPending[ uxParent ] = xLast;
+	return xFirst;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSetEndTime( uint64_t ullTimeUs )
+{
+	ullEnd = ullTimeUs;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullPortVirtualTime( void )
+{
+	return ullNow;
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetStats( PortStats *pxStats )
+{
+	*pxStats = xStats;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSysTickHandler( void * context, unsigned int id )
+{
+	( void ) context;
+	( void ) id;
+
+	/* Increment the kernel tick. */
+	if( xTaskIncrementTick() != pdFALSE )
+	{
+		vPortYield();
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Runs from the idle task, so every other task is blocked. Advances the
+ * clock to the next tick or interrupt, whichever is first, and delivers it.
+ */
+void vApplicationIdleHook( void )
+{
+uint64_t ullNextTick = ( ullTickCount + 1 ) * portTICK_US;
+
+	if( ( uxPendingCount > 0 ) && ( xPending[ 0 ].time <= ullNextTick ) )
+	{
+		PendingIRQ xIRQ = prvPopIRQ();
+		if( xIRQ.time > ullEnd )
+		{
+			vTaskEndScheduler();
+		}
+		ullNow = xIRQ.time;
+		xStats.interrupts++;
+		prvHash( ullNow ^ ( ( uint64_t ) xIRQ.id << 56 ), NULL );
+		if( xHandlers[ xIRQ.id ].handler != NULL )
+		{
+			xHandlers[ xIRQ.id ].handler( xHandlers[ xIRQ.id ].context, xIRQ.id );
+		}
+		if( xYieldFromISR )
+		{
+			xYieldFromISR = 0;
+			vPortYield();
+		}
+	}
+	else
+	{
+		if( ullNextTick > ullEnd )
+		{
+			vTaskEndScheduler();
+		}
+		ullNow = ullNextTick;
+		ullTickCount++;
+		xStats.ticks++;
+		vPortSysTickHandler( NULL, 0 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Called from the idle task with the scheduler suspended when no task is
+ * due for xExpectedIdleTime ticks. Jump over the ticks that would wake
+ * nothing, stopping short of the next interrupt and the end time, and
+ * leave the final tick to the idle hook as a real tick interrupt would.
+ */
+void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+{
+uint64_t ullJump = xExpectedIdleTime - 1;
+uint64_t ullLimit = ullEnd;
+
+	/* An interrupt may have readied a task that has not run yet. */
+	if( eTaskConfirmSleepModeStatus() == eAbortSleep )
+	{
+		return;
+	}
+	if( ( uxPendingCount > 0 ) && ( xPending[ 0 ].time < ullLimit ) )
+	{
+		ullLimit = xPending[ 0 ].time;
+	}
+	if( ullLimit / portTICK_US <= ullTickCount )
+	{
+		return;
+	}
+	if( ullLimit / portTICK_US - ullTickCount < ullJump )
+	{
+		ullJump = ullLimit / portTICK_US - ullTickCount;
+	}
+
+	vTaskStepTick( ( TickType_t ) ullJump );
+	ullTickCount += ullJump;
+	xStats.ticks_skipped += ullJump;
+	if( ullNow < ullTickCount * portTICK_US )
+	{
+		ullNow = ullTickCount * portTICK_US;
+	}
+}
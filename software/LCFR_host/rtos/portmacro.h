@@ -0,0 +1,100 @@
+/*
+ * Host port of FreeRTOS with a deterministic virtual clock. Tasks are
+ * ucontexts switched on a single thread. Time only moves while the idle
+ * task runs: each pass of the idle hook delivers the next event, either
+ * the 1 ms tick (vPortSysTickHandler, as on the Nios II) or an interrupt
+ * raised with vPortRaiseIRQ(), and tickless idle jumps over ticks that
+ * would wake nothing. Task code therefore takes no virtual time, and a run
+ * gives the same interleaving every time. A task that never blocks stops
+ * the clock.
+ */
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Type definitions. */
+#define portCHAR		char
+#define portFLOAT		float
+#define portDOUBLE		double
+#define portLONG		long
+#define portSHORT		short
+#define portSTACK_TYPE	uintptr_t
+#define portBASE_TYPE	long
+#define portPOINTER_SIZE_TYPE uintptr_t
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+typedef uint32_t TickType_t;
+#define portMAX_DELAY ( TickType_t ) 0xffffffffUL
+#define portTICK_TYPE_IS_ATOMIC 1
+
+/* Architecture specifics. */
+#define portSTACK_GROWTH				( -1 )
+#define portTICK_PERIOD_MS				( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT				4	// The 8 byte mask in portable.h is unsigned int and would truncate 64-bit pointers
+#define portNOP()
+#define portCRITICAL_NESTING_IN_TCB		1
+
+extern void vTaskSwitchContext( void );
+extern void vPortYield( void );
+extern void vPortYieldFromISR( void );
+#define portYIELD()									vPortYield()
+#define portEND_SWITCHING_ISR( xSwitchRequired ) 	if( xSwitchRequired ) 	vPortYieldFromISR()
+#define portYIELD_FROM_ISR( xSwitchRequired )		portEND_SWITCHING_ISR( xSwitchRequired )
+
+/* Interrupts are only delivered from the idle task, so there is nothing to mask. */
+extern void vTaskEnterCritical( void );
+extern void vTaskExitCritical( void );
+#define portDISABLE_INTERRUPTS()
+#define portENABLE_INTERRUPTS()
+#define portENTER_CRITICAL()        vTaskEnterCritical()
+#define portEXIT_CRITICAL()         vTaskExitCritical()
+
+extern void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
+#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime )	vPortSuppressTicksAndSleep( xExpectedIdleTime )
+
+/* Task function macros as described on the FreeRTOS.org WEB site. */
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void *pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters ) void vFunction( void *pvParameters )
+
+/*-----------------------------------------------------------
+ * Virtual clock.
+ *-----------------------------------------------------------*/
+#define portTICK_US		( 1000ULL )
+#define portMAX_IRQ		32
+
+typedef struct {
+	uint64_t ticks;				// Ticks delivered through vPortSysTickHandler
+	uint64_t ticks_skipped;		// Ticks jumped over by tickless idle
+	uint64_t interrupts;
+	uint64_t context_switches;
+	uint64_t schedule_hash;		// FNV-1a of every switch and interrupt: virtual time and task name or IRQ
+} PortStats;
+
+/* Same shape as the HAL call, so ISRs register the way they do on the board. */
+int alt_irq_register( unsigned int id, void *context, void (*handler)( void *, unsigned int ) );
+
+/* Raise interrupt id at an absolute virtual time in microseconds. Equal times
+are delivered in the order raised, and ahead of a tick due at the same time. */
+int xPortRaiseIRQ( unsigned int id, uint64_t ullTimeUs );
+
+/* vTaskStartScheduler() returns once the virtual clock reaches this time. */
+void vPortSetEndTime( uint64_t ullTimeUs );
+uint64_t ullPortVirtualTime( void );
+void vPortGetStats( PortStats *pxStats );
+
+void vPortSysTickHandler( void * context, unsigned int id );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_H */
@@ -0,0 +1,298 @@
+/*
+ * Runs the firmware's relay tasks on the real FreeRTOS kernel under the host
+ * port in rtos/, on a virtual clock. The frequency analyser ISR and the
+ * decision, keyboard and console log tasks are ../LCFR/relay_tasks.c, built
+ * unchanged against register models of the analyser and the slide switches;
+ * the interrupt is raised at each cycle end of a synthetic feeder. The LED,
+ * VGA, telemetry and console tasks drive devices the host does not have, so
+ * they are stand-ins that keep their firmware periods, priorities and use of
+ * the mutex and queue. Hours of operation run in seconds, and the same seed
+ * always gives the same task interleaving, so the schedule hash can be
+ * compared between builds. Reports the latency from the sample that made the
+ * relay unstable to the decision cycle that shed, in virtual microseconds.
+ *
+ * Build: gcc -O2 -Iinc -I../LCFR -I../LCFR/FreeRTOS -I../LCFR_bsp -I../LCFR_bsp/drivers/inc \
+ *            -include rtos/FreeRTOSConfig.h -include rtos/portmacro.h -Wl,--wrap=relay_step \
+ *            -o rtos_sim rtos_sim.c feeder.c host_io.c rtos/port.c ../LCFR/relay_tasks.c ../LCFR/relay.c \
+ *            ../LCFR/keypad.c ../LCFR/format.c ../LCFR/debounce.c ../LCFR/input_log.c ../LCFR/message_log.c \
+ *            ../LCFR/FreeRTOS/tasks.c ../LCFR/FreeRTOS/queue.c ../LCFR/FreeRTOS/list.c ../LCFR/FreeRTOS/timers.c -lm
+ * Usage: rtos_sim [-s seconds] [-S seed] [-l latency.csv] [-m messages.txt]
+ */
+
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+// Devices
+#include "system.h"
+#include "host_io.h"
+
+// RTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "timers.h"
+#include "semphr.h"
+
+#include "relay_tasks.h"
+#include "feeder.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define mainREG_TEST_PRIORITY ( tskIDLE_PRIORITY + 1)
+#define mainREG_IDLE_PRIORITY ( tskIDLE_PRIORITY )	// The firmware's log and console priority
+#define EVENT_PERIOD 60.0 // Seconds between feeder disturbances
+#define SWITCHES_ON 0xff	// Every load enabled
+
+/*=============*/
+/* Structures. */
+/*=============*/
+typedef struct {
+	unsigned long count;
+	uint64_t min;
+	uint64_t max;
+	uint64_t total;
+} Latency;
+
+/*===================*/
+/* Global Variables. */
+/*===================*/
+Feeder feeder;
+unsigned int feeder_seed;
+double next_event = EVENT_PERIOD;
+unsigned int analyser_count;	// What IORD(FREQUENCY_ANALYSER_BASE, 0) returns
+uint64_t onset_time;			// Virtual time of the sample that started the drop delay
+Latency latency = { 0, UINT64_MAX, 0, 0 };
+unsigned long samples_drawn = 0, leds_updated = 0, telemetry_samples = 0, system_uptime = 0;
+FILE *latency_file = NULL;
+
+/*==========*/
+/* Handles. */
+/*==========*/
+TimerHandle_t system_up_timer;
+
+/*================*/
+/* Device models. */
+/*=================*/
+static unsigned int analyser_registers(void *context, unsigned int offset, unsigned int data, int bytes, int write) {
+	(void) context;
+	(void) offset;
+	(void) data;
+	(void) bytes;
+	(void) write;
+	return analyser_count;
+}
+
+static unsigned int switch_registers(void *context, unsigned int offset, unsigned int data, int bytes, int write) {
+	(void) context;
+	(void) data;
+	(void) bytes;
+	(void) write;
+	return (offset == 0) ? SWITCHES_ON : 0;
+}
+
+/*=======*/
+/* ISRs. */
+/*=======*/
+static void raise_next_cycle(void) {
+	if (feeder.time >= next_event) {
+		double time = feeder.time;
+		feeder_init(&feeder, ++feeder_seed);
+		feeder.event_time += time;
+		feeder.time = time;
+		next_event = time + EVENT_PERIOD;
+	}
+	analyser_count = feeder_next(&feeder);
+	xPortRaiseIRQ(FREQUENCY_ANALYSER_IRQ, (uint64_t) (feeder.time * 1e6));
+}
+
+// The firmware's ISR, timing the onset and raising the next cycle around it
+static void analyser_interrupt(void *context, unsigned int id) {
+	int was_timing = relay.drop_delay_flag;
+
+	freq_relay(context, id);
+	if (!was_timing && relay.drop_delay_flag) {
+		onset_time = ullPortVirtualTime();
+	}
+	raise_next_cycle();
+}
+
+// Linked in place of relay_step (-Wl,--wrap=relay_step), so the latency is
+// taken from the firmware's decision task as it sheds
+int __real_relay_step(Relay *relay, unsigned int switch_value, unsigned int now);
+
+int __wrap_relay_step(Relay *relay, unsigned int switch_value, unsigned int now) {
+	int drop_delay = __real_relay_step(relay, switch_value, now);
+
+	if (drop_delay >= 0) { // A first shed, even when it came within the tick
+		uint64_t delay = ullPortVirtualTime() - onset_time;
+		latency.count++;
+		latency.total += delay;
+		if (delay < latency.min) {
+			latency.min = delay;
+		}
+		if (delay > latency.max) {
+			latency.max = delay;
+		}
+		if (latency_file != NULL) {
+			fprintf(latency_file, "%llu,%llu,%d\n", (unsigned long long) onset_time, (unsigned long long) delay, drop_delay);
+		}
+	}
+	return drop_delay;
+}
+
+/*============*/
+/* Callbacks. */
+/*============*/
+static void vTimerSystemUptimeCallback(TimerHandle_t t_timer) {
+	(void) t_timer;
+	system_uptime++;
+}
+
+/*========*/
+/* Tasks. */
+/*========*/
+// Stands in for the LED task, which only reads the relay
+static void prvLEDOutTask(void *pvParameters) {
+	(void) pvParameters;
+	while (1) {
+		xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
+		leds_updated++;
+		xSemaphoreGive(shared_resource_mutex);
+		vTaskDelay(10);
+	}
+}
+
+// Stands in for the VGA task, which drains the frequency queue every frame
+static void prvVGAOutTask(void *pvParameters) {
+	int mhz;
+	(void) pvParameters;
+	while (1) {
+		while (xQueueReceive(Q_freq_data, &mhz, 0) == pdTRUE) {
+			samples_drawn++;
+		}
+		vTaskDelay(20);
+	}
+}
+
+// Stands in for the telemetry task, which samples the relay every TELEMETRY_PERIOD
+static void prvTelemetryTask(void *pvParameters) {
+	(void) pvParameters;
+	while (1) {
+		vTaskDelay(20);
+		xSemaphoreTake(shared_resource_mutex, portMAX_DELAY);
+		telemetry_samples++;
+		xSemaphoreGive(shared_resource_mutex);
+	}
+}
+
+// Stands in for the console task, which polls for input that never comes here
+static void prvConsoleTask(void *pvParameters) {
+	(void) pvParameters;
+	while (1) {
+		vTaskDelay(20);
+	}
+}
+
+/*================*/
+/* Main function. */
+/*================*/
+static double wall_seconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+	double seconds = 3600.0;
+	const char *messages_path = "/dev/null";
+	PortStats stats;
+	FILE *report;
+	int opt;
+
+	feeder_seed = 1;
+	while ((opt = getopt(argc, argv, "s:S:l:m:")) != -1) {
+		switch (opt) {
+			case 's':
+				seconds = atof(optarg);
+				break;
+			case 'S':
+				feeder_seed = (unsigned int) atoi(optarg);
+				break;
+			case 'l':
+				latency_file = fopen(optarg, "w");
+				if (latency_file == NULL) {
+					perror(optarg);
+					return 1;
+				}
+				fprintf(latency_file, "onset_us,latency_us,drop_delay_ms\n");
+				break;
+			case 'm':
+				messages_path = optarg;
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-s seconds] [-S seed] [-l latency.csv] [-m messages.txt]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	// The log task prints the console messages on stdout, as on the board
+	report = fdopen(dup(fileno(stdout)), "w");
+	if ((report == NULL) || (freopen(messages_path, "w", stdout) == NULL)) {
+		perror(messages_path);
+		return 1;
+	}
+
+	host_io_map_registers("frequency analyser", FREQUENCY_ANALYSER_BASE, FREQUENCY_ANALYSER_SPAN, analyser_registers, NULL);
+	host_io_map_registers("slide switches", SLIDE_SWITCH_BASE, SLIDE_SWITCH_SPAN, switch_registers, NULL);
+
+	// Same state, queue, mutex, timer and tasks as the firmware's main()
+	relay_tasks_init();
+	feeder_init(&feeder, feeder_seed);
+	feeder.event_time = EVENT_PERIOD / 2;
+	relay_set_frequency(&relay, feeder.nominal);
+	alt_irq_register(FREQUENCY_ANALYSER_IRQ, NULL, analyser_interrupt);
+	raise_next_cycle();
+
+	system_up_timer = xTimerCreate("System Uptime Timer", 1000, pdTRUE, NULL, vTimerSystemUptimeCallback);
+	xTimerStart(system_up_timer, 0);
+	xTaskCreate(prvDecideTask, "Rreg1", configMINIMAL_STACK_SIZE, NULL, mainREG_TEST_PRIORITY, NULL);
+	xTaskCreate(prvLEDOutTask, "Rreg2", configMINIMAL_STACK_SIZE, NULL, mainREG_TEST_PRIORITY, NULL);
+	xTaskCreate(prvVGAOutTask, "Rreg3", configMINIMAL_STACK_SIZE, NULL, mainREG_TEST_PRIORITY, NULL);
+	xTaskCreate(prvLogTask, "Log", configMINIMAL_STACK_SIZE, NULL, mainREG_IDLE_PRIORITY, NULL);
+	xTaskCreate(prvTelemetryTask, "Telemetry", configMINIMAL_STACK_SIZE, NULL, mainREG_TEST_PRIORITY, NULL);
+	xTaskCreate(prvConsoleTask, "Console", configMINIMAL_STACK_SIZE, NULL, mainREG_IDLE_PRIORITY, NULL);
+	xTaskCreate(prvKeyboardTask, "Keyboard", configMINIMAL_STACK_SIZE, NULL, mainREG_TEST_PRIORITY, NULL);
+
+	vPortSetEndTime((uint64_t) (seconds * 1e6));
+	double start = wall_seconds();
+	vTaskStartScheduler();
+	double elapsed = wall_seconds() - start;
+	fflush(stdout);
+
+	vPortGetStats(&stats);
+	fprintf(report, "Simulated %.1f s in %.3f s (%.0fx real time)\n", seconds, elapsed, seconds / elapsed);
+	fprintf(report, "Ticks:            %llu delivered, %llu skipped by tickless idle\n",
+			(unsigned long long) stats.ticks, (unsigned long long) stats.ticks_skipped);
+	fprintf(report, "Interrupts:       %llu, %lu samples drawn, %lu LED updates, %lu telemetry samples, uptime %lu s\n",
+			(unsigned long long) stats.interrupts, samples_drawn, leds_updated, telemetry_samples, system_uptime);
+	fprintf(report, "Context switches: %llu\n", (unsigned long long) stats.context_switches);
+	fprintf(report, "Loads shed:       %u\n", relay.shed_count);
+	if (latency.count > 0) {
+		fprintf(report, "Shed latency:     min %.3f ms, mean %.3f ms, max %.3f ms over %lu first sheds\n",
+				latency.min / 1000.0, latency.total / 1000.0 / latency.count, latency.max / 1000.0, latency.count);
+	}
+	fprintf(report, "Schedule hash:    %016llx\n", (unsigned long long) stats.schedule_hash);
+	fclose(report);
+
+	if (latency_file != NULL) {
+		fclose(latency_file);
+	}
+	return 0;
+}
@@ -0,0 +1,140 @@
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "sched.h"
+
+/*=============*/
+/* Structures. */
+/*=============*/
+// Each worker owns a range of job numbers. The owner takes jobs from the
+// front, an idle worker steals the back half of someone else's range.
+typedef struct {
+	pthread_mutex_t lock;
+	unsigned int begin;
+	unsigned int end;
+} Range;
+
+typedef struct {
+	Range *ranges;
+	unsigned int num_threads;
+	sched_job_fn fn;
+	void *context;
+} Pool;
+
+typedef struct {
+	Pool *pool;
+	unsigned int id;
+} Worker;
+
+/*============*/
+/* Functions. */
+/*============*/
+unsigned int sched_num_cores(void) {
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	return (cores > 0) ? (unsigned int) cores : 1;
+}
+
+// Take the next job from our own range. Returns 0 if the range is empty
+static int sched_pop(Range *range, unsigned int *job) {
+	int found = 0;
+	pthread_mutex_lock(&range->lock);
+	if (range->begin < range->end) {
+		*job = range->begin++;
+		found = 1;
+	}
+	pthread_mutex_unlock(&range->lock);
+	return found;
+}
+
+// Move the back half of a victim's range into ours. Returns 0 if nothing was left anywhere
+static int sched_steal(Pool *pool, unsigned int thief) {
+	unsigned int i;
+	for (i = 1; i < pool->num_threads; i++) {
+		Range *victim = &pool->ranges[(thief + i) % pool->num_threads];
+		unsigned int begin = 0, end = 0;
+
+		pthread_mutex_lock(&victim->lock);
+		if (victim->begin < victim->end) {
+			unsigned int half = (victim->end - victim->begin + 1) / 2;
+			begin = victim->end - half;
+			end = victim->end;
+			victim->end = begin;
+		}
+		pthread_mutex_unlock(&victim->lock);
+
+		if (begin < end) {
+			Range *own = &pool->ranges[thief];
+			pthread_mutex_lock(&own->lock);
+			own->begin = begin;
+			own->end = end;
+			pthread_mutex_unlock(&own->lock);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void *sched_worker(void *arg) {
+	Worker *worker = (Worker *) arg;
+	Pool *pool = worker->pool;
+	unsigned int job;
+
+	do {
+		while (sched_pop(&pool->ranges[worker->id], &job)) {
+			pool->fn(pool->context, job);
+		}
+	} while (sched_steal(pool, worker->id));
+
+	return NULL;
+}
+
+// Runs fn for every job on num_threads threads (0 means one per core) and returns once all are done
+void sched_run(unsigned int num_jobs, unsigned int num_threads, sched_job_fn fn, void *context) {
+	Pool pool;
+	Worker *workers;
+	pthread_t *threads;
+	unsigned int i;
+
+	if (num_threads == 0) {
+		num_threads = sched_num_cores();
+	}
+	if (num_threads > num_jobs) {
+		num_threads = (num_jobs > 0) ? num_jobs : 1;
+	}
+
+	pool.ranges = calloc(num_threads, sizeof(Range));
+	pool.num_threads = num_threads;
+	pool.fn = fn;
+	pool.context = context;
+	workers = calloc(num_threads, sizeof(Worker));
+	threads = calloc(num_threads, sizeof(pthread_t));
+
+	// Deal out equal ranges up front, stealing evens out the rest
+	for (i = 0; i < num_threads; i++) {
+		pthread_mutex_init(&pool.ranges[i].lock, NULL);
+		pool.ranges[i].begin = (unsigned int) (((unsigned long long) num_jobs * i) / num_threads);
+		pool.ranges[i].end = (unsigned int) (((unsigned long long) num_jobs * (i + 1)) / num_threads);
+		workers[i].pool = &pool;
+		workers[i].id = i;
+	}
+
+	for (i = 1; i < num_threads; i++) {
+		pthread_create(&threads[i], NULL, sched_worker, &workers[i]);
+	}
+	sched_worker(&workers[0]);
+	for (i = 1; i < num_threads; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	for (i = 0; i < num_threads; i++) {
+		pthread_mutex_destroy(&pool.ranges[i].lock);
+	}
+	free(threads);
+	free(workers);
+	free(pool.ranges);
+}
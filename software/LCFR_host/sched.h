@@ -0,0 +1,13 @@
+#ifndef SCHED_H_
+#define SCHED_H_
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+// Called once for every job number in [0, num_jobs), from any worker thread
+typedef void (*sched_job_fn)(void *context, unsigned int job);
+
+unsigned int sched_num_cores(void);
+void sched_run(unsigned int num_jobs, unsigned int num_threads, sched_job_fn fn, void *context);
+
+#endif /* SCHED_H_ */
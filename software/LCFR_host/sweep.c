@@ -0,0 +1,440 @@
+/*
+ * Threshold sweep. Replays a corpus of frequency traces through every
+ * combination of relay parameters in parallel and prints the Pareto front of
+ * loads shed against the lowest frequency the relay let the feeder reach.
+ *
+ * Traces are binary .lcft recordings (see trace.h) or text files with one
+ * frequency analyser sample count per line ('#' starts a comment). Without
+ * trace files, -n synthetic feeders are used.
+ * Recorded traces are open loop, so shedding cannot change them; the
+ * frequency objective is therefore the lowest frequency seen before the
+ * relay first acted on each trace (the whole trace minimum if it never did).
+ * Each combination also reports how its trips held up: a trip (the first
+ * shed of a run of load management) is false if the frequency never fell
+ * below min_freq before the relay had reconnected every load, and early if
+ * it came before that crossing, by the lead time. With -m this measures the
+ * false trip rate and lead time that prediction adds.
+ *
+ * Build: gcc -O2 -I../LCFR -o sweep sweep.c sched.c feeder.c trace.c ../LCFR/relay.c -lpthread -lm
+ * Usage: sweep [-f min_freq] [-r max_roc] [-w window_ms] [-p horizon_s] [-m predict_mode]
+ *              [-n synthetic_traces] [-s seconds] [-t threads] [-a all.csv] [trace ...]
+ * Ranges are given as first:last:step, or a single value. -m is 0 (PREDICT_OFF,
+ * the firmware default), 1 (PREDICT_ARM) or 2 (PREDICT_SHED); -p only matters
+ * with prediction on.
+ */
+
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "relay.h"
+#include "feeder.h"
+#include "sched.h"
+#include "trace.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define DECIDE_PERIOD 20	// Milliseconds between relay_step calls, as prvDecideTask
+#define BATCH 64			// Parameter combinations replayed together per pass over a trace
+#define RESULT_HEADER "min_freq,max_roc,window_ms,horizon_s,sheds,reached,trips,false_trips,early_trips,mean_lead_ms\n"
+
+/*=============*/
+/* Structures. */
+/*=============*/
+typedef struct {
+	double first;
+	double last;
+	double step;
+	unsigned int count;
+} Range;
+
+typedef struct {
+	unsigned int *counts;		// Sample counts as read from the frequency analyser
+	unsigned int *times;		// Milliseconds at which each sample arrived
+	unsigned int length;
+} Trace;
+
+typedef struct {
+	double min_freq;
+	double max_roc;
+	unsigned int window;
+	double horizon;
+	unsigned long sheds;
+	double reached;				// Lowest frequency before the relay acted, worst over the corpus
+	unsigned long trips;		// First sheds of a run of load management
+	unsigned long false_trips;	// Trips with no crossing of min_freq before every load was back
+	unsigned long early_trips;	// Trips before the crossing
+	unsigned long long lead_ms;	// Total over the early trips
+} Result;
+
+typedef struct {
+	Range ranges[4];
+	int predict_mode;
+	unsigned int combinations;
+	Trace *traces;
+	unsigned int num_traces;
+	Result *results;
+} Sweep;
+
+/*============*/
+/* Functions. */
+/*============*/
+static double wall_seconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int parse_range(const char *text, Range *range) {
+	int n = sscanf(text, "%lf:%lf:%lf", &range->first, &range->last, &range->step);
+	if (n == 1) {
+		range->last = range->first;
+		range->step = 1;
+	} else if (n != 3 || range->step <= 0 || range->last < range->first) {
+		return -1;
+	}
+	range->count = (unsigned int) ((range->last - range->first) / range->step + 1e-9) + 1;
+	return 0;
+}
+
+static double range_value(const Range *range, unsigned int i) {
+	return range->first + range->step * i;
+}
+
+// Fill in arrival times from the sample counts, each count being one cycle in samples
+static void trace_timestamps(Trace *trace) {
+	double time = 0;
+	unsigned int i;
+	trace->times = malloc(trace->length * sizeof(unsigned int));
+	for (i = 0; i < trace->length; i++) {
+		time += (trace->counts[i] > 0) ? (1000.0 * trace->counts[i]) / SAMPLE_FREQ : 0;
+		trace->times[i] = (unsigned int) time;
+	}
+}
+
+// Binary traces carry their own arrival times, rebased to start at zero
+static int trace_load_binary(TraceReader *reader, Trace *trace) {
+	uint64_t *times;
+	unsigned int i;
+	long length;
+
+	trace->length = (unsigned int) reader->header->total_samples;
+	trace->counts = malloc(trace->length * sizeof(unsigned int) + 1);
+	trace->times = malloc(trace->length * sizeof(unsigned int) + 1);
+	times = malloc(trace->length * sizeof(uint64_t) + 1);
+	length = trace_read(reader, 0, trace->length, trace->counts, times);
+	for (i = 0; (long) i < length; i++) {
+		trace->times[i] = (unsigned int) (times[i] - times[0]);
+	}
+	free(times);
+	return (length == (long) trace->length) ? 0 : -1;
+}
+
+static int trace_load(const char *path, Trace *trace) {
+	TraceReader reader;
+	FILE *file;
+	char line[128];
+	unsigned int capacity = 4096;
+
+	if (trace_reader_open(&reader, path) == 0) {
+		int status = trace_load_binary(&reader, trace);
+		trace_reader_close(&reader);
+		if (status != 0) {
+			fprintf(stderr, "%s: corrupt trace\n", path);
+		}
+		return status;
+	}
+
+	file = fopen(path, "r");
+	if (file == NULL) {
+		perror(path);
+		return -1;
+	}
+	trace->length = 0;
+	trace->counts = malloc(capacity * sizeof(unsigned int));
+	while (fgets(line, sizeof(line), file) != NULL) {
+		char *end;
+		unsigned long count = strtoul(line, &end, 10);
+		if (end == line) {
+			continue; // Blank or comment
+		}
+		if (trace->length == capacity) {
+			capacity *= 2;
+			trace->counts = realloc(trace->counts, capacity * sizeof(unsigned int));
+		}
+		trace->counts[trace->length++] = (unsigned int) count;
+	}
+	fclose(file);
+	trace_timestamps(trace);
+	return 0;
+}
+
+static void trace_synthesise(unsigned int seed, double seconds, Trace *trace) {
+	Feeder feeder;
+	unsigned int capacity = (unsigned int) (seconds * 60) + 16;
+
+	feeder_init(&feeder, seed);
+	trace->length = 0;
+	trace->counts = malloc(capacity * sizeof(unsigned int));
+	while (feeder.time < seconds && trace->length < capacity) {
+		trace->counts[trace->length++] = feeder_next(&feeder);
+	}
+	trace_timestamps(trace);
+}
+
+static void combination(const Sweep *sweep, unsigned int index, Result *result) {
+	unsigned int i[4], k;
+	for (k = 0; k < 4; k++) {
+		i[k] = index % sweep->ranges[k].count;
+		index /= sweep->ranges[k].count;
+	}
+	result->min_freq = range_value(&sweep->ranges[0], i[0]);
+	result->max_roc = range_value(&sweep->ranges[1], i[1]);
+	result->window = (unsigned int) range_value(&sweep->ranges[2], i[2]);
+	result->horizon = range_value(&sweep->ranges[3], i[3]);
+	result->sheds = 0;
+	result->reached = 1e9;
+	result->trips = 0;
+	result->false_trips = 0;
+	result->early_trips = 0;
+	result->lead_ms = 0;
+}
+
+// Job for one batch of combinations. Every relay in the batch steps in lockstep over each trace,
+// so the trace is streamed through the cache once per batch rather than once per combination
+static void sweep_batch(void *context, unsigned int job) {
+	Sweep *sweep = (Sweep *) context;
+	unsigned int first = job * BATCH;
+	unsigned int size = (sweep->combinations - first < BATCH) ? sweep->combinations - first : BATCH;
+	Relay relays[BATCH];
+	double reached[BATCH];
+	int acted[BATCH];
+	int managing[BATCH];		// first_load_shed after the last decision
+	int below[BATCH];			// Latest measurement under min_freq
+	int pending[BATCH];			// A trip waiting for a crossing
+	unsigned int trip_time[BATCH];
+	unsigned int b, t, s;
+
+	for (b = 0; b < size; b++) {
+		combination(sweep, first + b, &sweep->results[first + b]);
+	}
+
+	for (t = 0; t < sweep->num_traces; t++) {
+		const Trace *trace = &sweep->traces[t];
+		unsigned int next_decide = DECIDE_PERIOD;
+
+		for (b = 0; b < size; b++) {
+			Result *result = &sweep->results[first + b];
+			relay_init(&relays[b]);
+			relays[b].desired_min_mhz = (int) (result->min_freq * 1000 + 0.5);
+			relays[b].desired_max_roc_mhz = (int) (result->max_roc * 1000 + 0.5);
+			relays[b].stability_window = result->window;
+			relays[b].predict_horizon_ms = (unsigned int) (result->horizon * 1000 + 0.5);
+			relays[b].predict_mode = sweep->predict_mode;
+			if (trace->length > 0 && trace->counts[0] > 0) {
+				relay_set_frequency(&relays[b], SAMPLE_FREQ / (double) trace->counts[0]);
+			}
+			reached[b] = 1e9;
+			acted[b] = 0;
+			managing[b] = 0;
+			below[b] = 0;
+			pending[b] = 0;
+		}
+
+		for (s = 0; s < trace->length; s++) {
+			unsigned int now = trace->times[s];
+			double freq = (trace->counts[s] > 0) ? SAMPLE_FREQ / (double) trace->counts[s] : 0;
+
+			while (next_decide < now) {
+				for (b = 0; b < size; b++) {
+					Result *result = &sweep->results[first + b];
+					relay_step(&relays[b], 0xff, next_decide);
+					if (relays[b].shed_count > 0) {
+						acted[b] = 1;
+					}
+					if (relays[b].first_load_shed && !managing[b]) {
+						result->trips++;
+						pending[b] = !below[b]; // Already under min_freq is a late, true trip
+						trip_time[b] = next_decide;
+					} else if (!relays[b].first_load_shed && managing[b] && pending[b]) {
+						result->false_trips++;
+						pending[b] = 0;
+					}
+					managing[b] = relays[b].first_load_shed;
+				}
+				next_decide += DECIDE_PERIOD;
+			}
+
+			for (b = 0; b < size; b++) {
+				relay_measure(&relays[b], trace->counts[s], now);
+				if (!acted[b] && freq > 0 && freq < reached[b]) {
+					reached[b] = freq;
+				}
+				below[b] = relays[b].signal_mhz < relays[b].desired_min_mhz;
+				if (below[b] && pending[b]) {
+					Result *result = &sweep->results[first + b];
+					result->early_trips++;
+					result->lead_ms += now - trip_time[b];
+					pending[b] = 0;
+				}
+			}
+		}
+
+		for (b = 0; b < size; b++) {
+			Result *result = &sweep->results[first + b];
+			result->sheds += relays[b].shed_count;
+			result->false_trips += pending[b]; // The trace ended before a crossing
+			if (reached[b] < result->reached) {
+				result->reached = reached[b];
+			}
+		}
+	}
+}
+
+static int compare_results(const void *a, const void *b) {
+	const Result *x = (const Result *) a, *y = (const Result *) b;
+	if (x->sheds != y->sheds) {
+		return (x->sheds < y->sheds) ? -1 : 1;
+	}
+	return (x->reached > y->reached) ? -1 : (x->reached < y->reached);
+}
+
+static void print_result(FILE *out, const Result *r) {
+	fprintf(out, "%.3f,%.3f,%u,%.3f,%lu,%.4f,%lu,%lu,%lu,%.1f\n", r->min_freq, r->max_roc, r->window, r->horizon, r->sheds,
+			r->reached, r->trips, r->false_trips, r->early_trips, (r->early_trips > 0) ? (double) r->lead_ms / r->early_trips : 0.0);
+}
+
+int main(int argc, char *argv[]) {
+	Sweep sweep;
+	unsigned int synthetic = 16, num_threads = 0, i, k;
+	double seconds = 20.0;
+	const char *all_path = NULL;
+	int opt;
+
+	memset(&sweep, 0, sizeof(Sweep));
+	parse_range("47.0:49.8:0.1", &sweep.ranges[0]);
+	parse_range("2:16:1", &sweep.ranges[1]);
+	parse_range("500", &sweep.ranges[2]);
+	parse_range("0.2", &sweep.ranges[3]);
+	sweep.predict_mode = PREDICT_OFF;
+
+	while ((opt = getopt(argc, argv, "f:r:w:p:m:n:s:t:a:")) != -1) {
+		int bad = 0;
+		switch (opt) {
+			case 'f':
+				bad = parse_range(optarg, &sweep.ranges[0]);
+				break;
+			case 'r':
+				bad = parse_range(optarg, &sweep.ranges[1]);
+				break;
+			case 'w':
+				bad = parse_range(optarg, &sweep.ranges[2]);
+				break;
+			case 'p':
+				bad = parse_range(optarg, &sweep.ranges[3]);
+				break;
+			case 'm':
+				sweep.predict_mode = atoi(optarg);
+				break;
+			case 'n':
+				synthetic = (unsigned int) strtoul(optarg, NULL, 10);
+				break;
+			case 's':
+				seconds = atof(optarg);
+				break;
+			case 't':
+				num_threads = (unsigned int) strtoul(optarg, NULL, 10);
+				break;
+			case 'a':
+				all_path = optarg;
+				break;
+			default:
+				bad = 1;
+				break;
+		}
+		if (bad) {
+			fprintf(stderr, "Usage: %s [-f min_freq] [-r max_roc] [-w window_ms] [-p horizon_s] [-m predict_mode]\n"
+					"       [-n synthetic_traces] [-s seconds] [-t threads] [-a all.csv] [trace ...]\n"
+					"Ranges are first:last:step or a single value\n", argv[0]);
+			return 1;
+		}
+	}
+
+	// Load the corpus
+	if (optind < argc) {
+		sweep.num_traces = argc - optind;
+		sweep.traces = calloc(sweep.num_traces, sizeof(Trace));
+		for (i = 0; i < sweep.num_traces; i++) {
+			if (trace_load(argv[optind + i], &sweep.traces[i]) != 0) {
+				return 1;
+			}
+		}
+	} else {
+		sweep.num_traces = synthetic;
+		sweep.traces = calloc(sweep.num_traces, sizeof(Trace));
+		for (i = 0; i < sweep.num_traces; i++) {
+			trace_synthesise(i * 2654435761u + 1, seconds, &sweep.traces[i]);
+		}
+	}
+
+	unsigned long long samples = 0;
+	for (i = 0; i < sweep.num_traces; i++) {
+		samples += sweep.traces[i].length;
+	}
+
+	sweep.combinations = 1;
+	for (k = 0; k < 4; k++) {
+		sweep.combinations *= sweep.ranges[k].count;
+	}
+	sweep.results = calloc(sweep.combinations, sizeof(Result));
+	if (sweep.results == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	double start = wall_seconds();
+	sched_run((sweep.combinations + BATCH - 1) / BATCH, num_threads, sweep_batch, &sweep);
+	double elapsed = wall_seconds() - start;
+
+	fprintf(stderr, "%u combinations x %u traces (%llu samples) in %.3f s, %.0f relay samples/s\n",
+			sweep.combinations, sweep.num_traces, samples, elapsed, samples * (double) sweep.combinations / elapsed);
+
+	if (all_path != NULL) {
+		FILE *all = fopen(all_path, "w");
+		if (all == NULL) {
+			perror(all_path);
+			return 1;
+		}
+		fprintf(all, RESULT_HEADER);
+		for (i = 0; i < sweep.combinations; i++) {
+			print_result(all, &sweep.results[i]);
+		}
+		fclose(all);
+	}
+
+	// Pareto front: fewest sheds for each improvement in the frequency reached
+	qsort(sweep.results, sweep.combinations, sizeof(Result), compare_results);
+	double best = -1;
+	printf(RESULT_HEADER);
+	for (i = 0; i < sweep.combinations; i++) {
+		if (sweep.results[i].reached > best) {
+			best = sweep.results[i].reached;
+			print_result(stdout, &sweep.results[i]);
+		}
+	}
+
+	for (i = 0; i < sweep.num_traces; i++) {
+		free(sweep.traces[i].counts);
+		free(sweep.traces[i].times);
+	}
+	free(sweep.traces);
+	free(sweep.results);
+	return 0;
+}
@@ -0,0 +1,236 @@
+/*
+ * Decodes the firmware's binary telemetry stream (../LCFR/telemetry.c), as
+ * captured from the UART or JTAG UART, into CSV: one row per sample on
+ * stdout and, with -s, one row per stats frame. Frames that fail their CRC
+ * are skipped and decoding resyncs at the next delimiter, so a capture may
+ * start mid-frame or have console text mixed in. A summary of frames, bad
+ * frames and sequence gaps goes to stderr.
+ *
+ * With -g it instead writes a stream the way the firmware would: a feeder
+ * drives a relay on a virtual clock and the relay is sampled every period
+ * ms, with a stats frame every second. -e flips one byte in every n so the
+ * decoder's resync can be exercised, e.g.
+ *   telemetry_decode -g 60 -p 1 -e 5000 | telemetry_decode > samples.csv
+ *
+ * Build: gcc -O2 -I../LCFR -o telemetry_decode telemetry_decode.c feeder.c ../LCFR/telemetry.c ../LCFR/relay.c -lm
+ * Usage: telemetry_decode [-s stats.csv] [capture]
+ *        telemetry_decode -g seconds [-p period_ms] [-e n] [-S seed]
+ */
+
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "relay.h"
+#include "telemetry.h"
+#include "feeder.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define STATS_PERIOD 1000 // Milliseconds between stats frames, as the firmware
+
+/*=============*/
+/* Structures. */
+/*=============*/
+typedef struct {
+	unsigned long long bytes;
+	unsigned long frames;
+	unsigned long samples;
+	unsigned long bad;			// Failed COBS or CRC, or an unknown layout
+	unsigned long gaps;			// Sequence numbers skipped
+	int have_sequence;
+	unsigned char sequence;		// Expected next
+} Summary;
+
+/*============*/
+/* Functions. */
+/*============*/
+static unsigned int get16(const unsigned char *p) {
+	return p[0] | (p[1] << 8);
+}
+
+static unsigned int get32(const unsigned char *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+}
+
+static void frame_out(const unsigned char *payload, int length, FILE *stats_file, Summary *summary) {
+	int i;
+
+	if ((payload[0] == TELEMETRY_SAMPLES) && (length >= TELEMETRY_HEADER_BYTES)
+			&& (length == TELEMETRY_HEADER_BYTES + payload[7] * TELEMETRY_SAMPLE_BYTES)) {
+		unsigned int time = get32(&payload[2]);
+		for (i = 0; i < payload[7]; i++) {
+			const unsigned char *sample = &payload[TELEMETRY_HEADER_BYTES + i * TELEMETRY_SAMPLE_BYTES];
+			printf("%u,%.3f,%.2f,%u,%d,%d,%d\n", time + i * payload[6], get16(&sample[0]) / 1000.0,
+					(short) get16(&sample[2]) / 100.0, sample[4], (sample[5] & TELEMETRY_MAINTENANCE) != 0,
+					(sample[5] & TELEMETRY_MANAGING) != 0, (sample[5] & TELEMETRY_UNSTABLE) != 0);
+		}
+		summary->samples += payload[7];
+	} else if ((payload[0] == TELEMETRY_STATS) && (length == TELEMETRY_STATS_BYTES)) {
+		if (stats_file != NULL) {
+			fprintf(stats_file, "%u,%u,%u,%u,%.2f,%u\n", get32(&payload[2]), get32(&payload[6]), get16(&payload[10]),
+					get16(&payload[12]), get32(&payload[14]) / 100.0, get32(&payload[18]));
+		}
+	} else {
+		summary->bad++;
+		return;
+	}
+
+	if (summary->have_sequence && (payload[1] != summary->sequence)) {
+		summary->gaps += (unsigned char) (payload[1] - summary->sequence);
+	}
+	summary->sequence = payload[1] + 1;
+	summary->have_sequence = 1;
+	summary->frames++;
+}
+
+static int decode(FILE *in, FILE *stats_file) {
+	unsigned char frame[TELEMETRY_MAX_FRAME], payload[TELEMETRY_MAX_FRAME];
+	Summary summary = { 0 };
+	int length = 0, overlong = 0, c;
+
+	printf("time_ms,freq_hz,roc_hz_s,loads,maintenance,managing,unstable\n");
+	if (stats_file != NULL) {
+		fprintf(stats_file, "time_ms,loads_shed,min_drop_ms,max_drop_ms,average_drop_ms,unsent_frames\n");
+	}
+
+	while ((c = getc(in)) != EOF) {
+		summary.bytes++;
+		if (c != 0) {
+			if (length < TELEMETRY_MAX_FRAME) {
+				frame[length++] = c;
+			} else {
+				overlong = 1; // Not a frame, e.g. console text; skip to the next delimiter
+			}
+			continue;
+		}
+		if (length > 0) {
+			int payload_length = overlong ? -1 : telemetry_decode(frame, length, payload);
+			if (payload_length > 0) {
+				frame_out(payload, payload_length, stats_file, &summary);
+			} else {
+				summary.bad++;
+			}
+		}
+		length = 0;
+		overlong = 0;
+	}
+
+	fprintf(stderr, "%llu bytes, %lu frames, %lu samples (%.2f bytes per sample), %lu bad frames, %lu frames missing\n",
+			summary.bytes, summary.frames, summary.samples, summary.samples ? (double) summary.bytes / summary.samples : 0.0,
+			summary.bad, summary.gaps);
+	return 0;
+}
+
+static void emit(const unsigned char *frame, int length, int error_every, unsigned long long *written) {
+	int i;
+
+	for (i = 0; i < length; i++) {
+		unsigned char byte = frame[i];
+		(*written)++;
+		if ((error_every > 0) && (*written % error_every == 0)) {
+			byte ^= 0x5A;
+		}
+		putchar(byte);
+	}
+}
+
+// Same sampling as prvTelemetryTask, on a virtual millisecond clock
+static int generate(double seconds, int period, int error_every, unsigned int seed) {
+	unsigned char frame[TELEMETRY_MAX_FRAME];
+	unsigned long long written = 0;
+	unsigned int now, end = (unsigned int) (seconds * 1000);
+	Telemetry telemetry;
+	Relay relay;
+	Feeder feeder;
+	int length;
+
+	if (isatty(fileno(stdout))) {
+		fprintf(stderr, "Not writing a binary stream to a terminal\n");
+		return 1;
+	}
+
+	relay_init(&relay);
+	telemetry_init(&telemetry, period);
+	feeder_init(&feeder, seed);
+	feeder.event_time = seconds / 2;
+	relay_set_frequency(&relay, feeder.nominal);
+	unsigned int count = feeder_next(&feeder);
+
+	for (now = 1; now <= end; now++) {
+		while (feeder.time * 1000 < now) {
+			relay_measure(&relay, count, (unsigned int) (feeder.time * 1000));
+			count = feeder_next(&feeder);
+		}
+		if (now % 20 == 0) {
+			relay_step(&relay, 0xff, now); // The decision task's period
+		}
+		if (now % telemetry.period == 0) {
+			length = telemetry_sample(&telemetry, &relay, now, frame);
+			emit(frame, length, error_every, &written);
+		}
+		if (now % STATS_PERIOD == 0) {
+			length = telemetry_stats(&telemetry, &relay, now, frame);
+			emit(frame, length, error_every, &written);
+		}
+	}
+	length = telemetry_flush(&telemetry, frame);
+	emit(frame, length, error_every, &written);
+
+	fprintf(stderr, "%llu bytes for %u samples, %.0f bytes/s\n", written, end / telemetry.period, written / seconds);
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	const char *stats_path = NULL;
+	double seconds = 0;
+	int period = 1, error_every = 0, opt;
+	unsigned int seed = 1;
+	FILE *in = stdin, *stats_file = NULL;
+
+	while ((opt = getopt(argc, argv, "s:g:p:e:S:")) != -1) {
+		switch (opt) {
+			case 's':
+				stats_path = optarg;
+				break;
+			case 'g':
+				seconds = atof(optarg);
+				break;
+			case 'p':
+				period = atoi(optarg);
+				break;
+			case 'e':
+				error_every = atoi(optarg);
+				break;
+			case 'S':
+				seed = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-s stats.csv] [capture]\n"
+						"       %s -g seconds [-p period_ms] [-e n] [-S seed]\n", argv[0], argv[0]);
+				return 1;
+		}
+	}
+
+	if (seconds > 0) {
+		return generate(seconds, period, error_every, seed);
+	}
+	if ((optind < argc) && ((in = fopen(argv[optind], "rb")) == NULL)) {
+		perror(argv[optind]);
+		return 1;
+	}
+	if ((stats_path != NULL) && ((stats_file = fopen(stats_path, "w")) == NULL)) {
+		perror(stats_path);
+		return 1;
+	}
+	decode(in, stats_file);
+	if (stats_file != NULL) {
+		fclose(stats_file);
+	}
+	return 0;
+}
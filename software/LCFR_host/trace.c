@@ -0,0 +1,410 @@
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "trace.h"
+
+/*===================*/
+/* Global Variables. */
+/*===================*/
+// CRC-32 (IEEE 802.3, reflected 0xEDB88320)
+static const uint32_t crc_table[256] = {
+	0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
+	0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
+	0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
+	0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
+	0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9,
+	0xfa0f3d63, 0x8d080df5, 0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
+	0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b, 0x35b5a8fa, 0x42b2986c,
+	0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
+	0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
+	0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
+	0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190, 0x01db7106,
+	0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
+	0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
+	0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
+	0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
+	0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
+	0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
+	0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
+	0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
+	0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
+	0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
+	0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
+	0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
+	0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
+	0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
+	0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
+	0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
+	0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
+	0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
+	0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
+	0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
+	0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
+	0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
+	0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
+	0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
+	0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
+	0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
+	0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
+	0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
+	0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
+	0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
+	0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
+	0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
+};
+
+/*============*/
+/* Functions. */
+/*============*/
+uint32_t trace_crc32(const unsigned char *data, size_t length) {
+	uint32_t crc = 0xffffffff;
+	while (length--) {
+		crc = crc_table[(crc ^ *data++) & 0xff] ^ (crc >> 8);
+	}
+	return crc ^ 0xffffffff;
+}
+
+static unsigned char *put_varint(unsigned char *out, uint32_t value) {
+	while (value >= 0x80) {
+		*out++ = (unsigned char) (value | 0x80);
+		value >>= 7;
+	}
+	*out++ = (unsigned char) value;
+	return out;
+}
+
+// Returns NULL if the varint runs past end
+static const unsigned char *get_varint(const unsigned char *in, const unsigned char *end, uint32_t *value) {
+	uint32_t result = 0;
+	int shift = 0;
+	while (in < end && shift < 35) {
+		unsigned char byte = *in++;
+		result |= (uint32_t) (byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) {
+			*value = result;
+			return in;
+		}
+		shift += 7;
+	}
+	return NULL;
+}
+
+static uint32_t zigzag(uint32_t delta) {
+	return (delta << 1) ^ (uint32_t) -(int32_t) (delta >> 31);
+}
+
+static uint32_t unzigzag(uint32_t value) {
+	return (value >> 1) ^ (uint32_t) -(int32_t) (value & 1);
+}
+
+/*==========*/
+/* Writing. */
+/*==========*/
+// flags is 0 or TRACE_FLAG_XOR_COUNTS
+int trace_writer_open(TraceWriter *writer, const char *path, unsigned int sample_freq, unsigned int flags) {
+	memset(writer, 0, sizeof(TraceWriter));
+	writer->file = fopen(path, "wb");
+	if (writer->file == NULL) {
+		return -1;
+	}
+
+	writer->header.magic = TRACE_MAGIC;
+	writer->header.version = TRACE_VERSION;
+	writer->header.flags = (uint16_t) flags;
+	writer->header.sample_freq = sample_freq;
+	writer->header.block_samples = TRACE_BLOCK_SAMPLES;
+
+	// Placeholder header, rewritten on close once the index offset is known
+	if (fwrite(&writer->header, sizeof(TraceHeader), 1, writer->file) != 1) {
+		fclose(writer->file);
+		return -1;
+	}
+	return 0;
+}
+
+static int trace_writer_flush(TraceWriter *writer) {
+	unsigned char *out = writer->buffer;
+	TraceIndex *entry;
+	uint64_t base;
+	unsigned int i;
+
+	if (writer->pending == 0) {
+		return 0;
+	}
+	if (writer->header.num_blocks == writer->index_capacity) {
+		unsigned int capacity = writer->index_capacity ? writer->index_capacity * 2 : 64;
+		TraceIndex *index = realloc(writer->index, capacity * sizeof(TraceIndex));
+		if (index == NULL) {
+			return -1;
+		}
+		writer->index = index;
+		writer->index_capacity = capacity;
+	}
+
+	// Counts column, then times column
+	out = put_varint(out, writer->counts[0]);
+	if (writer->header.flags & TRACE_FLAG_XOR_COUNTS) {
+		for (i = 1; i < writer->pending; i++) {
+			out = put_varint(out, writer->counts[i] ^ writer->counts[i-1]);
+		}
+	} else {
+		for (i = 1; i < writer->pending; i++) {
+			out = put_varint(out, zigzag(writer->counts[i] - writer->counts[i-1]));
+		}
+	}
+	base = writer->times[0];
+	for (i = 1; i < writer->pending; i++) {
+		out = put_varint(out, zigzag((uint32_t) (writer->times[i] - base) - (uint32_t) (writer->times[i-1] - base)));
+	}
+
+	entry = &writer->index[writer->header.num_blocks];
+	memset(entry, 0, sizeof(TraceIndex));
+	entry->offset = (uint64_t) ftell(writer->file);
+	entry->first_sample = writer->header.total_samples;
+	entry->first_time = base;
+	entry->last_time = writer->times[writer->pending - 1];
+	entry->bytes = (uint32_t) (out - writer->buffer);
+	entry->samples = writer->pending;
+	entry->crc = trace_crc32(writer->buffer, entry->bytes);
+
+	if (fwrite(writer->buffer, 1, entry->bytes, writer->file) != entry->bytes) {
+		return -1;
+	}
+	writer->header.num_blocks++;
+	writer->header.total_samples += writer->pending;
+	writer->pending = 0;
+	return 0;
+}
+
+// Time is in milliseconds and should not go backwards. A time before the
+// block's first or 2^32 ms after it starts a new block, which may be short.
+int trace_writer_append(TraceWriter *writer, unsigned int count, uint64_t time) {
+	if ((writer->pending > 0) && ((time < writer->times[0]) || (time - writer->times[0] > UINT32_MAX))) {
+		if (trace_writer_flush(writer) != 0) {
+			return -1;
+		}
+	}
+	writer->counts[writer->pending] = count;
+	writer->times[writer->pending] = time;
+	writer->pending++;
+	if (writer->pending == TRACE_BLOCK_SAMPLES) {
+		return trace_writer_flush(writer);
+	}
+	return 0;
+}
+
+int trace_writer_close(TraceWriter *writer) {
+	static const unsigned char padding[sizeof(uint64_t)];
+	int status = trace_writer_flush(writer);
+
+	// The index is read in place from the mapping, so align it for its 64-bit fields
+	writer->header.index_offset = (uint64_t) ftell(writer->file);
+	if (writer->header.index_offset % sizeof(uint64_t) != 0) {
+		size_t pad = sizeof(uint64_t) - writer->header.index_offset % sizeof(uint64_t);
+		if (fwrite(padding, 1, pad, writer->file) != pad) {
+			status = -1;
+		}
+		writer->header.index_offset += pad;
+	}
+	if (writer->header.num_blocks > 0 &&
+			fwrite(writer->index, sizeof(TraceIndex), writer->header.num_blocks, writer->file) != writer->header.num_blocks) {
+		status = -1;
+	}
+	if (fseek(writer->file, 0, SEEK_SET) != 0 || fwrite(&writer->header, sizeof(TraceHeader), 1, writer->file) != 1) {
+		status = -1;
+	}
+	if (fclose(writer->file) != 0) {
+		status = -1;
+	}
+	free(writer->index);
+	writer->index = NULL;
+	return status;
+}
+
+/*==========*/
+/* Reading. */
+/*==========*/
+// The index must be aligned and describe blocks in order, back to back in
+// sample numbers, each no longer than block_samples and lying within the
+// file, so seeks never have to trust a sample number they did not check
+static int trace_index_valid(const TraceReader *reader) {
+	const TraceHeader *h = reader->header;
+	uint64_t next_sample = 0;
+	unsigned int block;
+
+	if (h->block_samples == 0 || h->block_samples > TRACE_BLOCK_SAMPLES || h->index_offset % sizeof(uint64_t) != 0 || h->index_offset > reader->size ||
+			(uint64_t) h->num_blocks * sizeof(TraceIndex) > reader->size - h->index_offset) {
+		return 0;
+	}
+	for (block = 0; block < h->num_blocks; block++) {
+		const TraceIndex *entry = (const TraceIndex *) (reader->map + h->index_offset) + block;
+		if (entry->first_sample != next_sample || entry->samples == 0 || entry->samples > h->block_samples ||
+				entry->offset > reader->size || entry->bytes > reader->size - entry->offset ||
+				entry->last_time < entry->first_time || entry->last_time - entry->first_time > UINT32_MAX) {
+			return 0;
+		}
+		next_sample += entry->samples;
+	}
+	return next_sample == h->total_samples;
+}
+
+int trace_reader_open(TraceReader *reader, const char *path) {
+	struct stat st;
+	int fd = open(path, O_RDONLY);
+
+	memset(reader, 0, sizeof(TraceReader));
+	if (fd < 0) {
+		return -1;
+	}
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(TraceHeader)) {
+		close(fd);
+		return -1;
+	}
+
+	reader->size = (size_t) st.st_size;
+	reader->map = mmap(NULL, reader->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (reader->map == MAP_FAILED) {
+		reader->map = NULL;
+		return -1;
+	}
+	madvise((void *) reader->map, reader->size, MADV_SEQUENTIAL);
+
+	reader->header = (const TraceHeader *) reader->map;
+	if (reader->header->magic != TRACE_MAGIC || reader->header->version != TRACE_VERSION || !trace_index_valid(reader)) {
+		trace_reader_close(reader);
+		return -1;
+	}
+	reader->index = (const TraceIndex *) (reader->map + reader->header->index_offset);
+	return 0;
+}
+
+void trace_reader_close(TraceReader *reader) {
+	if (reader->map != NULL) {
+		munmap((void *) reader->map, reader->size);
+	}
+	memset(reader, 0, sizeof(TraceReader));
+}
+
+// Decodes one block into counts and times (TRACE_BLOCK_SAMPLES each). Returns the number of samples, or -1 if the block is corrupt
+int trace_read_block(const TraceReader *reader, unsigned int block, uint32_t *counts, uint64_t *times) {
+	const TraceIndex *entry;
+	const unsigned char *in, *end;
+	uint32_t value, offset = 0;
+	unsigned int i;
+
+	if (block >= reader->header->num_blocks) {
+		return -1;
+	}
+	entry = &reader->index[block];
+	in = reader->map + entry->offset;
+	end = in + entry->bytes;
+	if (trace_crc32(in, entry->bytes) != entry->crc) {
+		return -1;
+	}
+
+	if ((in = get_varint(in, end, &counts[0])) == NULL) {
+		return -1;
+	}
+	if (reader->header->flags & TRACE_FLAG_XOR_COUNTS) {
+		for (i = 1; i < entry->samples; i++) {
+			if ((in = get_varint(in, end, &value)) == NULL) {
+				return -1;
+			}
+			counts[i] = counts[i-1] ^ value;
+		}
+	} else {
+		for (i = 1; i < entry->samples; i++) {
+			if ((in = get_varint(in, end, &value)) == NULL) {
+				return -1;
+			}
+			counts[i] = counts[i-1] + unzigzag(value);
+		}
+	}
+	times[0] = entry->first_time;
+	for (i = 1; i < entry->samples; i++) {
+		if ((in = get_varint(in, end, &value)) == NULL) {
+			return -1;
+		}
+		offset += unzigzag(value);
+		times[i] = entry->first_time + offset;
+	}
+	return (int) entry->samples;
+}
+
+// Returns the block holding the given sample number, or -1 if it is past the end
+int trace_find_sample(const TraceReader *reader, uint64_t sample) {
+	int low = 0, high = (int) reader->header->num_blocks - 1;
+
+	if (sample >= reader->header->total_samples) {
+		return -1;
+	}
+	// Blocks are full apart from the last, unless the writer had to start one early
+	low = (int) (sample / reader->header->block_samples);
+	if (low > high || reader->index[low].first_sample > sample) {
+		low = 0;
+	}
+	while (low < high) {
+		int mid = (low + high + 1) / 2;
+		if (reader->index[mid].first_sample <= sample) {
+			low = mid;
+		} else {
+			high = mid - 1;
+		}
+	}
+	return low;
+}
+
+// Returns the first block whose samples reach the given time, or -1 if the trace ends before it
+int trace_find_time(const TraceReader *reader, uint64_t time) {
+	int low = 0, high = (int) reader->header->num_blocks - 1, found = -1;
+	while (low <= high) {
+		int mid = (low + high) / 2;
+		if (reader->index[mid].last_time >= time) {
+			found = mid;
+			high = mid - 1;
+		} else {
+			low = mid + 1;
+		}
+	}
+	return found;
+}
+
+// Random access read of up to length samples starting at sample first. Returns the number read, or -1 on a corrupt block
+long trace_read(const TraceReader *reader, uint64_t first, unsigned int length, uint32_t *counts, uint64_t *times) {
+	uint32_t block_counts[TRACE_BLOCK_SAMPLES];
+	uint64_t block_times[TRACE_BLOCK_SAMPLES];
+	long done = 0;
+	int block = trace_find_sample(reader, first);
+
+	while (block >= 0 && (unsigned int) block < reader->header->num_blocks && done < (long) length) {
+		int samples = trace_read_block(reader, (unsigned int) block, block_counts, block_times);
+		uint64_t position = first + (uint64_t) done;
+		unsigned int skip, take;
+
+		if (samples < 0 || position < reader->index[block].first_sample ||
+				position - reader->index[block].first_sample >= (uint64_t) samples) {
+			return -1;
+		}
+		skip = (unsigned int) (position - reader->index[block].first_sample);
+		take = (unsigned int) samples - skip;
+		if (take > length - done) {
+			take = length - (unsigned int) done;
+		}
+		memcpy(counts + done, block_counts + skip, take * sizeof(uint32_t));
+		if (times != NULL) {
+			memcpy(times + done, block_times + skip, take * sizeof(uint64_t));
+		}
+		done += take;
+		block++;
+	}
+	return done;
+}
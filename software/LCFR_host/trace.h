@@ -0,0 +1,88 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+// Binary frequency trace (.lcft). Two columns per cycle: the frequency
+// analyser sample count and the arrival time in milliseconds. Samples are
+// stored in blocks, each holding all of its counts and then all of its
+// times. Counts are zigzag delta varints, or with TRACE_FLAG_XOR_COUNTS the
+// varint of each count XORed with the one before. Times are zigzag delta
+// varints of their 32-bit offsets from the block's 64-bit first time, which
+// the index holds, so a steady feeder costs about two bytes per cycle and
+// captures longer than 49 days keep their order. Each block has a CRC-32 in
+// the index at the end of the file, which allows random seeks by sample
+// number or time without decoding what comes before. All fields are little
+// endian.
+#define TRACE_MAGIC 0x5446434c	// "LCFT"
+#define TRACE_VERSION 2
+#define TRACE_BLOCK_SAMPLES 4096
+#define TRACE_MAX_BLOCK_BYTES (TRACE_BLOCK_SAMPLES * 10)
+#define TRACE_FLAG_XOR_COUNTS 0x0001
+
+/*=============*/
+/* Structures. */
+/*=============*/
+typedef struct {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t flags;
+	uint32_t sample_freq;
+	uint32_t block_samples;
+	uint32_t num_blocks;
+	uint32_t reserved;
+	uint64_t total_samples;
+	uint64_t index_offset;
+} TraceHeader;
+
+typedef struct {
+	uint64_t offset;
+	uint64_t first_sample;
+	uint64_t first_time;
+	uint64_t last_time;
+	uint32_t bytes;
+	uint32_t samples;
+	uint32_t crc;
+	uint32_t reserved;
+} TraceIndex;
+
+typedef struct {
+	FILE *file;
+	TraceHeader header;
+	TraceIndex *index;
+	unsigned int index_capacity;
+	uint32_t counts[TRACE_BLOCK_SAMPLES];
+	uint64_t times[TRACE_BLOCK_SAMPLES];
+	unsigned int pending;
+	unsigned char buffer[TRACE_MAX_BLOCK_BYTES];
+} TraceWriter;
+
+typedef struct {
+	const unsigned char *map;
+	size_t size;
+	const TraceHeader *header;
+	const TraceIndex *index;
+} TraceReader;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+uint32_t trace_crc32(const unsigned char *data, size_t length);
+
+int trace_writer_open(TraceWriter *writer, const char *path, unsigned int sample_freq, unsigned int flags);
+int trace_writer_append(TraceWriter *writer, unsigned int count, uint64_t time);
+int trace_writer_close(TraceWriter *writer);
+
+int trace_reader_open(TraceReader *reader, const char *path);
+void trace_reader_close(TraceReader *reader);
+int trace_read_block(const TraceReader *reader, unsigned int block, uint32_t *counts, uint64_t *times);
+int trace_find_sample(const TraceReader *reader, uint64_t sample);
+int trace_find_time(const TraceReader *reader, uint64_t time);
+long trace_read(const TraceReader *reader, uint64_t first, unsigned int length, uint32_t *counts, uint64_t *times);
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,237 @@
+/*
+ * Converts, checks and benchmarks binary frequency traces (see trace.h).
+ *
+ * Build: gcc -O2 -I../LCFR -o trace_tool trace_tool.c trace.c feeder.c -lm
+ * Usage: trace_tool encode in.txt out.lcft   text "count[,time_ms]" per line to binary
+ *        trace_tool decode in.lcft           binary to "count,time_ms" on stdout
+ *        trace_tool info in.lcft             header, size and compression
+ *        trace_tool verify in.lcft           check every block checksum
+ *        trace_tool synth out.lcft hours     synthetic feeder recording
+ *        trace_tool bench in.lcft            sequential and random-seek decode speed
+ * encode and synth take -x before the paths to store counts as XOR deltas.
+ */
+
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "relay.h"
+#include "feeder.h"
+#include "trace.h"
+
+/*============*/
+/* Functions. */
+/*============*/
+static double wall_seconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int encode(const char *in_path, const char *out_path, unsigned int flags) {
+	FILE *in = fopen(in_path, "r");
+	TraceWriter *writer = malloc(sizeof(TraceWriter));
+	char line[128];
+	double time = 0;
+
+	if (in == NULL) {
+		perror(in_path);
+		return 1;
+	}
+	if (writer == NULL || trace_writer_open(writer, out_path, SAMPLE_FREQ, flags) != 0) {
+		perror(out_path);
+		return 1;
+	}
+	while (fgets(line, sizeof(line), in) != NULL) {
+		char *end;
+		unsigned long count = strtoul(line, &end, 10);
+		if (end == line) {
+			continue; // Blank or comment
+		}
+		if (*end == ',') {
+			time = strtod(end + 1, NULL);
+		} else {
+			time += (1000.0 * count) / SAMPLE_FREQ; // No timestamp, derive it from the cycle length
+		}
+		if (trace_writer_append(writer, (unsigned int) count, (uint64_t) time) != 0) {
+			perror(out_path);
+			return 1;
+		}
+	}
+	fclose(in);
+	if (trace_writer_close(writer) != 0) {
+		perror(out_path);
+		return 1;
+	}
+	free(writer);
+	return 0;
+}
+
+static int decode(const TraceReader *reader) {
+	uint32_t counts[TRACE_BLOCK_SAMPLES];
+	uint64_t times[TRACE_BLOCK_SAMPLES];
+	unsigned int block;
+	int i, samples;
+
+	for (block = 0; block < reader->header->num_blocks; block++) {
+		samples = trace_read_block(reader, block, counts, times);
+		if (samples < 0) {
+			fprintf(stderr, "Block %u is corrupt\n", block);
+			return 1;
+		}
+		for (i = 0; i < samples; i++) {
+			printf("%u,%llu\n", counts[i], (unsigned long long) times[i]);
+		}
+	}
+	return 0;
+}
+
+static int info(const TraceReader *reader) {
+	const TraceHeader *h = reader->header;
+	double span = (h->num_blocks > 0) ? (reader->index[h->num_blocks - 1].last_time - reader->index[0].first_time) / 1000.0 : 0;
+
+	printf("Version:        %u%s\n", h->version, (h->flags & TRACE_FLAG_XOR_COUNTS) ? ", XOR counts" : "");
+	printf("Sample freq:    %u Hz\n", h->sample_freq);
+	printf("Samples:        %llu in %u blocks\n", (unsigned long long) h->total_samples, h->num_blocks);
+	printf("Span:           %.1f s\n", span);
+	printf("File size:      %lu bytes\n", (unsigned long) reader->size);
+	if (h->total_samples > 0) {
+		printf("Bytes/sample:   %.3f (raw 8)\n", (double) reader->size / h->total_samples);
+	}
+	return 0;
+}
+
+static int verify(const TraceReader *reader) {
+	uint32_t counts[TRACE_BLOCK_SAMPLES];
+	uint64_t times[TRACE_BLOCK_SAMPLES];
+	unsigned int block, bad = 0;
+
+	for (block = 0; block < reader->header->num_blocks; block++) {
+		if (trace_read_block(reader, block, counts, times) != (int) reader->index[block].samples) {
+			printf("Block %u is corrupt\n", block);
+			bad++;
+		}
+	}
+	printf("%u of %u blocks OK\n", reader->header->num_blocks - bad, reader->header->num_blocks);
+	return bad ? 1 : 0;
+}
+
+static int synth(const char *out_path, double hours, unsigned int flags) {
+	TraceWriter *writer = malloc(sizeof(TraceWriter));
+	Feeder feeder;
+	double seconds = hours * 3600.0, next_event = 0;
+	unsigned int seed = 1;
+
+	if (writer == NULL || trace_writer_open(writer, out_path, SAMPLE_FREQ, flags) != 0) {
+		perror(out_path);
+		return 1;
+	}
+
+	// A new disturbance every minute or so, with time carried across
+	feeder_init(&feeder, seed);
+	while (feeder.time < seconds) {
+		if (feeder.time >= next_event) {
+			double time = feeder.time;
+			feeder_init(&feeder, ++seed);
+			feeder.event_time += time;
+			feeder.time = time;
+			next_event = time + 60.0;
+		}
+		unsigned int count = feeder_next(&feeder);
+		if (trace_writer_append(writer, count, (uint64_t) (feeder.time * 1000)) != 0) {
+			perror(out_path);
+			return 1;
+		}
+	}
+	if (trace_writer_close(writer) != 0) {
+		perror(out_path);
+		return 1;
+	}
+	free(writer);
+	return 0;
+}
+
+static int bench(const TraceReader *reader) {
+	uint32_t counts[TRACE_BLOCK_SAMPLES];
+	uint64_t times[TRACE_BLOCK_SAMPLES];
+	unsigned long long sum = 0, samples = 0;
+	unsigned int block, i, seed = 12345;
+	double start, elapsed;
+
+	start = wall_seconds();
+	for (block = 0; block < reader->header->num_blocks; block++) {
+		int n = trace_read_block(reader, block, counts, times);
+		if (n < 0) {
+			fprintf(stderr, "Block %u is corrupt\n", block);
+			return 1;
+		}
+		for (i = 0; i < (unsigned int) n; i++) {
+			sum += counts[i];
+		}
+		samples += n;
+	}
+	elapsed = wall_seconds() - start;
+	printf("Sequential:     %.1f Msamples/s, %.1f MB/s of file (checksum %llu)\n",
+			samples / elapsed / 1e6, reader->size / elapsed / 1e6, sum);
+
+	if (reader->header->total_samples < 100) {
+		return 0;
+	}
+	start = wall_seconds();
+	for (i = 0; i < 10000; i++) {
+		uint64_t first = feeder_rand(&seed) % (reader->header->total_samples - 100);
+		if (trace_read(reader, first, 100, counts, times) < 0) {
+			return 1;
+		}
+	}
+	elapsed = wall_seconds() - start;
+	printf("Random seek:    %.1f us per 100-sample read\n", elapsed / 10000 * 1e6);
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	TraceReader reader;
+	unsigned int flags = 0;
+	int status;
+
+	if (argc == 5 && strcmp(argv[2], "-x") == 0) {
+		flags = TRACE_FLAG_XOR_COUNTS;
+		argv[2] = argv[1];
+		argv++;
+		argc--;
+	}
+	if (argc == 4 && strcmp(argv[1], "encode") == 0) {
+		return encode(argv[2], argv[3], flags);
+	}
+	if (argc == 4 && strcmp(argv[1], "synth") == 0) {
+		return synth(argv[2], atof(argv[3]), flags);
+	}
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s encode|decode|info|verify|synth|bench ...\n", argv[0]);
+		return 1;
+	}
+
+	if (trace_reader_open(&reader, argv[2]) != 0) {
+		fprintf(stderr, "%s: not a readable trace\n", argv[2]);
+		return 1;
+	}
+	if (strcmp(argv[1], "decode") == 0) {
+		status = decode(&reader);
+	} else if (strcmp(argv[1], "info") == 0) {
+		status = info(&reader);
+	} else if (strcmp(argv[1], "verify") == 0) {
+		status = verify(&reader);
+	} else if (strcmp(argv[1], "bench") == 0) {
+		status = bench(&reader);
+	} else {
+		fprintf(stderr, "Unknown command %s\n", argv[1]);
+		status = 1;
+	}
+	trace_reader_close(&reader);
+	return status;
+}
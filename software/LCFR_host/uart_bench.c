@@ -0,0 +1,374 @@
+/*
+ * UART transmit benchmark: runs the interrupt driven Avalon UART driver
+ * (../LCFR_bsp/drivers/src/altera_avalon_uart_*.c) against a model of the
+ * UART on a virtual clock, so the line takes ten bit times per byte as on
+ * the board. A producer emits telemetry-sized frames at a fixed period
+ * through either path:
+ *
+ *   write     altera_avalon_uart_write(), copying into the 64-byte circular
+ *             buffer. A full buffer stalls the caller, as a blocking write()
+ *             does, and the next frame waits for it.
+ *   sg        altera_avalon_uart_write_sg(), queuing one of a few frame
+ *             buffers with a completion callback. The caller never waits;
+ *             a frame with no free buffer is dropped.
+ *
+ * Reports line throughput, interrupts and UART register accesses per byte,
+ * host time spent in the driver per byte, caller stall time and dropped
+ * frames, and checks the bytes on the line are exactly the frames sent.
+ *
+ * Build: gcc -O2 -Iinc -I../LCFR_bsp -I../LCFR_bsp/drivers/inc -o uart_bench uart_bench.c host_io.c \
+ *            ../LCFR_bsp/drivers/src/altera_avalon_uart_init.c ../LCFR_bsp/drivers/src/altera_avalon_uart_write.c
+ * Usage: uart_bench [-s seconds] [-p period_us] [-l frame_bytes] [-b baud] [-n buffers]
+ *        Defaults are 1 kHz telemetry: 60-byte frames every 8 ms at 115200 baud
+ */
+
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include "system.h"
+#include "altera_avalon_uart.h"
+#include "altera_avalon_uart_regs.h"
+#include "host_io.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define MAX_BUFFERS 16
+#define MAX_FRAME 256
+#define NEVER ~0ull
+
+/*=============*/
+/* Structures. */
+/*=============*/
+// The Avalon UART transmitter: a holding register feeding a shift register
+typedef struct {
+	unsigned long long now;			// Virtual ns
+	unsigned long long byte_time;	// ns per byte on the line
+	unsigned long long shift_end;	// When the byte in the shift register is out
+	int holding_full;
+	unsigned char holding;
+	unsigned int control;
+	unsigned int overruns;
+	unsigned char *line;			// Every byte sent, in order
+	unsigned long line_bytes;
+	unsigned long line_capacity;
+} UartModel;
+
+typedef struct {
+	altera_avalon_uart_tx tx;
+	unsigned char data[MAX_FRAME];
+	int busy;
+} FrameBuffer;
+
+typedef struct {
+	unsigned long frames;
+	unsigned long dropped;
+	unsigned long late;				// Frames produced after their period because the caller was stalled
+	unsigned long long stall;		// Virtual ns the caller spent waiting
+	unsigned long long worst_stall;
+	unsigned long long irqs;
+	double driver_seconds;			// Host time in driver calls and the ISR
+} Result;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+// The driver's own entry point behind write(), declared in altera_avalon_uart_fd.c
+extern int altera_avalon_uart_write(altera_avalon_uart_state* sp, const char* ptr, int count, int flags);
+
+/*===================*/
+/* Global Variables. */
+/*===================*/
+static UartModel uart;
+static altera_avalon_uart_state state = { .base = (void *) UART_BASE };
+static FrameBuffer buffers[MAX_BUFFERS];
+static unsigned char *expected;
+static unsigned long expected_bytes;
+static HostIoRegion *uart_region;
+
+/*============*/
+/* Functions. */
+/*============*/
+static double wall_seconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Move the holding register into an idle shift register
+static void uart_load(UartModel *model) {
+	if (model->holding_full && (model->now >= model->shift_end)) {
+		model->shift_end = model->now + model->byte_time;
+		model->holding_full = 0;
+		if (model->line_bytes < model->line_capacity) {
+			model->line[model->line_bytes] = model->holding;
+		}
+		model->line_bytes++;
+	}
+}
+
+static unsigned int uart_registers(void *context, unsigned int offset, unsigned int data, int bytes, int write) {
+	UartModel *model = (UartModel *) context;
+
+	(void) bytes;
+
+	switch (offset / 4) {
+		case ALTERA_AVALON_UART_TXDATA_REG:
+			if (write) {
+				if (model->holding_full) {
+					model->overruns++;
+				}
+				model->holding = data;
+				model->holding_full = 1;
+				uart_load(model);
+			}
+			return 0;
+		case ALTERA_AVALON_UART_STATUS_REG:
+			if (write) {
+				return 0;
+			}
+			return (model->holding_full ? 0 : ALTERA_AVALON_UART_STATUS_TRDY_MSK)
+					| ((!model->holding_full && (model->now >= model->shift_end)) ? ALTERA_AVALON_UART_STATUS_TMT_MSK : 0);
+		case ALTERA_AVALON_UART_CONTROL_REG:
+			if (write) {
+				model->control = data;
+			}
+			return model->control;
+		default:
+			return 0;
+	}
+}
+
+// Time of the next change the driver could see
+static unsigned long long uart_next_event(const UartModel *model) {
+	return model->holding_full ? model->shift_end : NEVER;
+}
+
+static void uart_advance(UartModel *model, unsigned long long time) {
+	model->now = time;
+	uart_load(model);
+}
+
+static int uart_irq_pending(const UartModel *model) {
+	return (model->control & ALTERA_AVALON_UART_CONTROL_TRDY_MSK) && !model->holding_full;
+}
+
+static void run_irqs(Result *result) {
+	while (uart_irq_pending(&uart)) {
+		double start = wall_seconds();
+		host_io_irq(UART_IRQ);
+		result->driver_seconds += wall_seconds() - start;
+		result->irqs++;
+	}
+}
+
+static void frame_done(altera_avalon_uart_tx *tx) {
+	((FrameBuffer *) tx->context)->busy = 0;
+}
+
+static void make_frame(unsigned char *data, int length, unsigned long frame) {
+	int i;
+	for (i = 0; i < length; i++) {
+		data[i] = (unsigned char) (frame * 31 + i * 7);
+	}
+}
+
+static void reset(unsigned long long byte_time) {
+	memset(&state, 0, sizeof(state));
+	state.base = (void *) UART_BASE;
+	altera_avalon_uart_init(&state, UART_IRQ_INTERRUPT_CONTROLLER_ID, UART_IRQ);
+	uart.now = 0;
+	uart.byte_time = byte_time;
+	uart.shift_end = 0;
+	uart.holding_full = 0;
+	uart.overruns = 0;
+	uart.line_bytes = 0;
+	expected_bytes = 0;
+	memset(buffers, 0, sizeof(buffers));
+	host_io_clear_counters();
+}
+
+// Blocking write(): the caller keeps retrying as space frees up
+static void run_write(Result *result, unsigned long long end, unsigned long long period, int length) {
+	unsigned char data[MAX_FRAME];
+	unsigned long long next_frame = 0;
+
+	while (next_frame < end) {
+		unsigned long long start_time, event = uart_next_event(&uart);
+		int sent = 0;
+
+		if (event < next_frame) {
+			uart_advance(&uart, event);
+			run_irqs(result);
+			continue;
+		}
+		uart_advance(&uart, next_frame);
+		run_irqs(result);
+		make_frame(data, length, result->frames);
+		memcpy(&expected[expected_bytes], data, length);
+		expected_bytes += length;
+
+		start_time = uart.now;
+		while (1) {
+			double start = wall_seconds();
+			int n = altera_avalon_uart_write(&state, (const char *) &data[sent], length - sent, O_NONBLOCK);
+			result->driver_seconds += wall_seconds() - start;
+			sent += (n > 0) ? n : 0;
+			run_irqs(result);
+			if (sent == length) {
+				break;
+			}
+			event = uart_next_event(&uart);
+			uart_advance(&uart, event);
+			run_irqs(result);
+		}
+		result->frames++;
+		result->stall += uart.now - start_time;
+		if (uart.now - start_time > result->worst_stall) {
+			result->worst_stall = uart.now - start_time;
+		}
+
+		next_frame += period;
+		if (next_frame < uart.now) {
+			result->late++;
+			next_frame = uart.now;
+		}
+	}
+}
+
+// Scatter/gather: queue a free frame buffer or drop the frame
+static void run_sg(Result *result, unsigned long long end, unsigned long long period, int length, int num_buffers) {
+	unsigned long long next_frame = 0;
+	int i;
+
+	while (next_frame < end) {
+		unsigned long long event = uart_next_event(&uart);
+
+		if (event < next_frame) {
+			uart_advance(&uart, event);
+			run_irqs(result);
+			continue;
+		}
+		uart_advance(&uart, next_frame);
+		run_irqs(result);
+
+		for (i = 0; (i < num_buffers) && buffers[i].busy; i++) {
+		}
+		if (i == num_buffers) {
+			result->dropped++;
+		} else {
+			FrameBuffer *buffer = &buffers[i];
+			make_frame(buffer->data, length, result->frames);
+			memcpy(&expected[expected_bytes], buffer->data, length);
+			expected_bytes += length;
+			buffer->busy = 1;
+			buffer->tx.ptr = buffer->data;
+			buffer->tx.len = length;
+			buffer->tx.done = frame_done;
+			buffer->tx.context = buffer;
+
+			double start = wall_seconds();
+			altera_avalon_uart_write_sg(&state, &buffer->tx, 1);
+			result->driver_seconds += wall_seconds() - start;
+			run_irqs(result);
+		}
+		result->frames++;
+		next_frame += period;
+	}
+}
+
+// Let the line drain so every accepted byte can be compared
+static void drain(Result *result) {
+	unsigned long long event;
+	while ((event = uart_next_event(&uart)) != NEVER) {
+		uart_advance(&uart, event);
+		run_irqs(result);
+	}
+}
+
+static int report(const char *name, const Result *result, double seconds, unsigned long long byte_time) {
+	double line_rate = 1e9 / byte_time;
+	unsigned long bytes = uart.line_bytes;
+
+	if ((bytes != expected_bytes) || (memcmp(uart.line, expected, bytes) != 0) || (uart.overruns != 0)) {
+		fprintf(stderr, "%s: line carried %lu bytes, %lu expected, %u overruns\n", name, bytes, expected_bytes, uart.overruns);
+		return -1;
+	}
+	printf("%-6s %8.0f B/s (%5.1f%% of line)  %5.2f irqs/B  %5.2f regs/B  %6.1f ns/B  stall %8.3f ms mean %7.3f ms worst  %lu late  %lu dropped\n",
+			name, bytes / seconds, 100.0 * bytes / seconds / line_rate, (double) result->irqs / bytes,
+			(double) (uart_region->reads + uart_region->writes) / bytes, result->driver_seconds / bytes * 1e9,
+			result->frames ? result->stall / 1e6 / result->frames : 0.0, result->worst_stall / 1e6, result->late, result->dropped);
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	double seconds = 10;
+	int period_us = 8000, length = 60, baud = UART_BAUD, num_buffers = 4, opt;
+	Result result;
+
+	while ((opt = getopt(argc, argv, "s:p:l:b:n:")) != -1) {
+		switch (opt) {
+			case 's':
+				seconds = atof(optarg);
+				break;
+			case 'p':
+				period_us = atoi(optarg);
+				break;
+			case 'l':
+				length = atoi(optarg);
+				break;
+			case 'b':
+				baud = atoi(optarg);
+				break;
+			case 'n':
+				num_buffers = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-s seconds] [-p period_us] [-l frame_bytes] [-b baud] [-n buffers]\n", argv[0]);
+				return 1;
+		}
+	}
+	if ((length < 1) || (length > MAX_FRAME) || (num_buffers < 1) || (num_buffers > MAX_BUFFERS) || (period_us < 1)) {
+		fprintf(stderr, "Frames are 1 to %d bytes, with 1 to %d buffers\n", MAX_FRAME, MAX_BUFFERS);
+		return 1;
+	}
+
+	unsigned long long byte_time = 10 * 1000000000ull / baud; // Start, 8 data and stop bits
+	unsigned long long end = (unsigned long long) (seconds * 1e9);
+	uart.line_capacity = (unsigned long) (seconds * 1e9 / byte_time) + 2 * MAX_FRAME * MAX_BUFFERS;
+	uart.line = malloc(uart.line_capacity);
+	expected = malloc(uart.line_capacity + (unsigned long) (seconds * 1e6 / period_us + 1) * length);
+	if ((uart.line == NULL) || (expected == NULL)) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	uart_region = host_io_map_registers("uart", UART_BASE, UART_SPAN, uart_registers, &uart);
+
+	printf("%d-byte frames every %d us (%.0f B/s offered) at %d baud (%.0f B/s), %.0f s, TX burst %d\n", length, period_us,
+			length * 1e6 / period_us, baud, 1e9 / byte_time, seconds, ALTERA_AVALON_UART_TX_BURST);
+
+	reset(byte_time);
+	memset(&result, 0, sizeof(result));
+	run_write(&result, end, period_us * 1000ull, length);
+	drain(&result);
+	if (report("write", &result, uart.now / 1e9, byte_time) != 0) {
+		return 1;
+	}
+
+	reset(byte_time);
+	memset(&result, 0, sizeof(result));
+	run_sg(&result, end, period_us * 1000ull, length, num_buffers);
+	drain(&result);
+	if (report("sg", &result, uart.now / 1e9, byte_time) != 0) {
+		return 1;
+	}
+	return 0;
+}
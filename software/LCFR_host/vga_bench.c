@@ -0,0 +1,216 @@
+/*
+ * Renders the firmware's VGA screen (display.c) through the real pixel and
+ * character buffer drivers into the host backend (vga_host.c). A feeder
+ * drives a relay as on the board, and a frame is drawn every 20 ms of feeder
+ * time, as prvVGAOutTask does. Reports draw time and bus writes per frame,
+ * writes the last frame as PPM and text, and compares it against golden
+ * copies so renderer changes can be checked without a monitor.
+ *
+ * Build: gcc -O2 -Iinc -I../LCFR -I../LCFR_bsp -I../LCFR_bsp/drivers/inc -o vga_bench vga_bench.c vga_host.c host_io.c feeder.c \
+ *            ../LCFR/display.c ../LCFR/history.c ../LCFR/format.c ../LCFR/relay.c ../LCFR_bsp/drivers/src/altera_up_avalon_video_pixel_buffer_dma.c \
+ *            ../LCFR_bsp/drivers/src/altera_up_avalon_video_character_buffer_with_dma.c -lm
+ * Usage: vga_bench [-f frames] [-c color_mode] [-l] [-s] [-z zoom] [-o out_prefix] [-g golden_prefix]
+ *        -c 1..4 is 8, 16, 24 or 30-bit colour (default 4, as the board), -l linear addressing
+ *        -s draws the plots as a strip chart, as the firmware does (VGA_STRIP_CHART), instead of redrawing them
+ *        -z 1..6 shows a history view (1 min to 1 week) instead of the live plots
+ *        Frames are written to and compared against prefix.ppm and prefix.txt
+ */
+
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "system.h"
+#include "relay.h"
+#include "display.h"
+#include "history.h"
+#include "format.h"
+#include "feeder.h"
+#include "vga_host.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define FRAME_PERIOD 20 // Milliseconds between frames, as prvVGAOutTask
+
+/*===================*/
+/* Global Variables. */
+/*===================*/
+History history;
+
+/*============*/
+/* Functions. */
+/*============*/
+static double wall_seconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Same text as prvLEDOutTask formats
+static void format_status(DisplayStatus *status, const Relay *relay, int store_freq[5], int store_dfreq[5], int uptime) {
+	int i;
+
+	for (i = 4; i >= 1; i--) {
+		store_freq[i] = store_freq[i-1];
+		store_dfreq[i] = store_dfreq[i-1];
+	}
+	store_freq[0] = relay->signal_mhz;
+	store_dfreq[0] = relay->roc_mhz;
+	for (i = 0; i < 5; i++) {
+		format_fixed(status->freq[i], 5, store_freq[i], 3, 0);
+		format_fixed(status->dfreq[i], 5, store_dfreq[i], 3, 0);
+	}
+	format_int(status->system_uptime, 10, uptime, " s");
+	format_fixed(status->min_freq, 12, (relay->desired_min_mhz + 50) / 100, 1, " Hz  ");
+	format_fixed(status->max_roc, 12, (relay->desired_max_roc_mhz + 50) / 100, 1, " Hz/s  ");
+	format_int(status->min_drop, 8, relay->min_drop_delay, " ms  ");
+	format_int(status->max_drop, 8, relay->max_drop_delay, " ms  ");
+	format_fixed(status->average_drop, 12, relay->drop_average, 2, " ms  ");
+
+	if (relay->maintenance == 1) {
+		status->mode = DISPLAY_MAINTENANCE;
+	} else if (relay->first_load_shed == 0) {
+		status->mode = DISPLAY_MONITORING;
+	} else {
+		status->mode = DISPLAY_LOAD_MANAGEMENT;
+	}
+}
+
+static int check(const char *golden_prefix) {
+	char path[512];
+	long pixels, chars;
+
+	snprintf(path, sizeof(path), "%s.ppm", golden_prefix);
+	pixels = vga_host_compare_ppm(path);
+	snprintf(path, sizeof(path), "%s.txt", golden_prefix);
+	chars = vga_host_compare_text(path);
+	if ((pixels < 0) || (chars < 0)) {
+		fprintf(stderr, "Cannot read golden frame %s.ppm/.txt\n", golden_prefix);
+		return 1;
+	}
+	printf("Golden frame:       %ld pixels and %ld characters differ\n", pixels, chars);
+	return (pixels != 0) || (chars != 0);
+}
+
+int main(int argc, char *argv[]) {
+	const char *out_prefix = NULL, *golden_prefix = NULL;
+	int frames = 500, strip_chart = 0, zoom = 0, color_mode = ALT_UP_30BIT_COLOR_MODE, addressing_mode = ALT_UP_PIXEL_BUFFER_XY_ADDRESS_MODE;
+	int store_freq[5] = { 0, 0, 0, 0, 0 }, store_dfreq[5] = { 0, 0, 0, 0, 0 };
+	unsigned long long pixel_writes = 0, pixel_bytes = 0, char_writes = 0;
+	double draw_time = 0, worst_time = 0;
+	DisplayStatus status;
+	Display display;
+	VgaCounters counters;
+	Relay relay;
+	Feeder feeder;
+	int opt, frame;
+
+	while ((opt = getopt(argc, argv, "f:c:lsz:o:g:")) != -1) {
+		switch (opt) {
+			case 'f':
+				frames = atoi(optarg);
+				break;
+			case 'c':
+				color_mode = atoi(optarg);
+				break;
+			case 'l':
+				addressing_mode = ALT_UP_PIXEL_BUFFER_CONSECUTIVE_ADDRESS_MODE;
+				break;
+			case 's':
+				strip_chart = 1;
+				break;
+			case 'z':
+				zoom = atoi(optarg);
+				break;
+			case 'o':
+				out_prefix = optarg;
+				break;
+			case 'g':
+				golden_prefix = optarg;
+				break;
+			default:
+				fprintf(stderr, "Usage: %s [-f frames] [-c color_mode] [-l] [-s] [-z zoom] [-o out_prefix] [-g golden_prefix]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (vga_host_init(color_mode, addressing_mode) != 0) {
+		fprintf(stderr, "Colour mode must be 1 to 4\n");
+		return 1;
+	}
+
+	// Same device lookups as prvVGAOutTask
+	alt_up_pixel_buffer_dma_dev *pixel_buf = alt_up_pixel_buffer_dma_open_dev(VIDEO_PIXEL_BUFFER_DMA_NAME);
+	alt_up_char_buffer_dev *char_buf = alt_up_char_buffer_open_dev("/dev/video_character_buffer_with_dma");
+	if ((pixel_buf == NULL) || (char_buf == NULL)) {
+		fprintf(stderr, "Cannot open the VGA devices\n");
+		return 1;
+	}
+	history_init(&history);
+	display_init(&display, pixel_buf, char_buf, strip_chart, &history);
+	display_zoom(&display, zoom);
+	vga_host_counters(&counters);
+	printf("Screen set up:      %llu pixel writes, %llu character writes\n", counters.pixel_writes, counters.char_writes);
+
+	relay_init(&relay);
+	feeder_init(&feeder, 1);
+	feeder.event_time = frames * FRAME_PERIOD / 2000.0; // Disturbance half way through
+	relay_set_frequency(&relay, feeder.nominal);
+	unsigned int count = feeder_next(&feeder);
+
+	for (frame = 1; frame <= frames; frame++) {
+		unsigned int frame_time = frame * FRAME_PERIOD;
+
+		// Samples that arrived since the last frame
+		while (feeder.time * 1000 < frame_time) {
+			relay_measure(&relay, count, (unsigned int) (feeder.time * 1000));
+			display_push(&display, relay.signal_mhz);
+			count = feeder_next(&feeder);
+		}
+		relay_step(&relay, 0xff, frame_time);
+		format_status(&status, &relay, store_freq, store_dfreq, frame_time / 1000);
+
+		vga_host_clear_counters();
+		double start = wall_seconds();
+		display_draw(&display, &status);
+		double elapsed = wall_seconds() - start;
+
+		vga_host_counters(&counters);
+		pixel_writes += counters.pixel_writes;
+		pixel_bytes += counters.pixel_bytes;
+		char_writes += counters.char_writes;
+		draw_time += elapsed;
+		if (elapsed > worst_time) {
+			worst_time = elapsed;
+		}
+	}
+
+	printf("Frames:             %d, colour mode %d, %s addressing, %s\n", frames, color_mode,
+			(addressing_mode == ALT_UP_PIXEL_BUFFER_XY_ADDRESS_MODE) ? "XY" : "linear", strip_chart ? "strip chart" : "full redraw");
+	printf("Pixel writes:       %.0f per frame (%.0f bytes)\n", (double) pixel_writes / frames, (double) pixel_bytes / frames);
+	printf("Character writes:   %.0f per frame\n", (double) char_writes / frames);
+	printf("Host draw time:     %.1f us mean, %.1f us worst per frame\n", draw_time / frames * 1e6, worst_time * 1e6);
+
+	if (out_prefix != NULL) {
+		char path[512];
+		snprintf(path, sizeof(path), "%s.ppm", out_prefix);
+		if (vga_host_write_ppm(path) != 0) {
+			perror(path);
+			return 1;
+		}
+		snprintf(path, sizeof(path), "%s.txt", out_prefix);
+		if (vga_host_write_text(path) != 0) {
+			perror(path);
+			return 1;
+		}
+	}
+	if (golden_prefix != NULL) {
+		return check(golden_prefix);
+	}
+	return 0;
+}
@@ -0,0 +1,278 @@
+/*
+ * Host backend for the pixel buffer DMA and character buffer drivers. The
+ * real driver sources are built against inc/io.h; this file models the
+ * SRAM frame buffer, the character memory and both controllers' registers
+ * at their system.h addresses, and registers the devices under the names
+ * the firmware opens. Frames can be written as PPM (pixels) and text
+ * (character grid), or compared against golden copies of either.
+ */
+
+/*===========*/
+/* Includes. */
+/*===========*/
+// Standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "system.h"
+#include "io.h"
+#include "host_io.h"
+#include "vga_host.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+#define PIXEL_BUFFER_ADDRESS SRAM_BASE
+#define X_BITS 10		// Address bits for x and y in XY addressing mode
+#define Y_BITS 9
+
+/*===================*/
+/* Global Variables. */
+/*===================*/
+static unsigned char sram[SRAM_SPAN];
+static unsigned char char_memory[VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_BUFFER_SLAVE_SPAN];
+static unsigned int pixel_registers[4];	// Front buffer, back buffer, resolution, status
+static HostIoRegion *sram_region, *char_region;
+
+static char pixel_name[] = VIDEO_PIXEL_BUFFER_DMA_NAME;
+static char char_name[] = VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_BUFFER_SLAVE_NAME;
+static alt_up_pixel_buffer_dma_dev pixel_dev;
+static alt_up_char_buffer_dev char_dev;
+
+/*============*/
+/* Functions. */
+/*============*/
+static unsigned int pixel_controller(void *context, unsigned int offset, unsigned int data, int bytes, int write) {
+	(void) context;
+	(void) bytes;
+
+	if (!write) {
+		return pixel_registers[offset / 4];
+	}
+	if (offset == 0) {
+		// Swap request: the host "refresh" happens at once, so the status bit never shows pending
+		unsigned int front = pixel_registers[0];
+		pixel_registers[0] = pixel_registers[1];
+		pixel_registers[1] = front;
+	} else if (offset == 4) {
+		pixel_registers[1] = data;
+	}
+	return 0;
+}
+
+static unsigned int char_controller(void *context, unsigned int offset, unsigned int data, int bytes, int write) {
+	(void) context;
+	(void) bytes;
+
+	if (!write) {
+		if (offset == 4) {
+			return (VGA_HOST_ROWS << 16) | VGA_HOST_COLUMNS;
+		}
+		return 0; // Clear screen always reads back as complete
+	}
+	if ((offset == 2) && (data & 1)) {
+		memset(char_memory, 0, sizeof(char_memory));
+	}
+	return 0;
+}
+
+// Set up the models and the devices. The devices are filled in from the
+// registers exactly as the drivers' INIT macros do in alt_sys_init().
+int vga_host_init(int color_mode, int addressing_mode) {
+	static int mapped = 0;
+	unsigned int status;
+
+	if ((color_mode < ALT_UP_8BIT_COLOR_MODE) || (color_mode > ALT_UP_30BIT_COLOR_MODE)) {
+		return -1;
+	}
+	if (!mapped) {
+		sram_region = host_io_map_memory("sram", SRAM_BASE, SRAM_SPAN, sram);
+		char_region = host_io_map_memory("char buffer", VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_BUFFER_SLAVE_BASE,
+				VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_BUFFER_SLAVE_SPAN, char_memory);
+		host_io_map_registers("pixel buffer control", VIDEO_PIXEL_BUFFER_DMA_BASE, VIDEO_PIXEL_BUFFER_DMA_SPAN, pixel_controller, NULL);
+		host_io_map_registers("char buffer control", VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_CONTROL_SLAVE_BASE,
+				VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_CONTROL_SLAVE_SPAN, char_controller, NULL);
+	}
+	memset(sram, 0, sizeof(sram));
+	memset(char_memory, 0, sizeof(char_memory));
+
+	pixel_registers[0] = PIXEL_BUFFER_ADDRESS;
+	pixel_registers[1] = PIXEL_BUFFER_ADDRESS;
+	pixel_registers[2] = (VGA_HOST_HEIGHT << 16) | VGA_HOST_WIDTH;
+	pixel_registers[3] = (Y_BITS << 24) | (X_BITS << 16) | (color_mode << 4) | ((addressing_mode & 1) << 1);
+
+	// ALTERA_UP_AVALON_VIDEO_PIXEL_BUFFER_DMA_INIT
+	pixel_dev.dev.name = pixel_name;
+	pixel_dev.base = VIDEO_PIXEL_BUFFER_DMA_BASE;
+	pixel_dev.buffer_start_address = IORD_32DIRECT(pixel_dev.base, 0);
+	pixel_dev.back_buffer_start_address = IORD_32DIRECT(pixel_dev.base, 4);
+	pixel_dev.x_resolution = IORD_32DIRECT(pixel_dev.base, 8) & 0xFFFF;
+	pixel_dev.y_resolution = (IORD_32DIRECT(pixel_dev.base, 8) >> 16) & 0xFFFF;
+	status = IORD_32DIRECT(pixel_dev.base, 12);
+	pixel_dev.addressing_mode = (status >> 1) & 0x1;
+	pixel_dev.color_mode = (status >> 4) & 0xF;
+	if (pixel_dev.color_mode == ALT_UP_8BIT_COLOR_MODE) {
+		pixel_dev.x_coord_offset = 0;
+	} else if (pixel_dev.color_mode == ALT_UP_16BIT_COLOR_MODE) {
+		pixel_dev.x_coord_offset = 1;
+	} else {
+		pixel_dev.x_coord_offset = 2;
+	}
+	pixel_dev.x_coord_mask = 0xFFFFFFFF >> (32 - ((status >> 16) & 0xFF));
+	pixel_dev.y_coord_offset = ((status >> 16) & 0xFF) + pixel_dev.x_coord_offset;
+	pixel_dev.y_coord_mask = 0xFFFFFFFF >> (32 - ((status >> 24) & 0xFF));
+
+	// ALTERA_UP_AVALON_VIDEO_CHARACTER_BUFFER_WITH_DMA_INSTANCE and _INIT
+	char_dev.dev.name = char_name;
+	char_dev.ctrl_reg_base = VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_CONTROL_SLAVE_BASE;
+	char_dev.buffer_base = VIDEO_CHARACTER_BUFFER_WITH_DMA_AVALON_CHAR_BUFFER_SLAVE_BASE;
+	char_dev.x_resolution = IORD_32DIRECT(char_dev.ctrl_reg_base, 4) & 0xFFFF;
+	char_dev.y_resolution = (IORD_32DIRECT(char_dev.ctrl_reg_base, 4) >> 16) & 0xFFFF;
+	char_dev.x_coord_offset = 0;
+	char_dev.x_coord_mask = 0x007F;
+	char_dev.y_coord_offset = 7;
+	char_dev.y_coord_mask = 0x003F;
+
+	if (!mapped) {
+		alt_up_char_buffer_init(&char_dev);
+		alt_dev_reg(&pixel_dev.dev);
+		alt_dev_reg(&char_dev.dev);
+		mapped = 1;
+	}
+	host_io_clear_counters();
+	return 0;
+}
+
+void vga_host_counters(VgaCounters *counters) {
+	counters->pixel_writes = sram_region->writes;
+	counters->pixel_bytes = sram_region->bytes_written;
+	counters->char_writes = char_region->writes;
+}
+
+void vga_host_clear_counters(void) {
+	host_io_clear_counters();
+}
+
+// Colour of a displayed (front buffer) pixel as 8-bit RGB
+void vga_host_pixel(unsigned int x, unsigned int y, unsigned char rgb[3]) {
+	unsigned int offset = pixel_registers[0] - SRAM_BASE;
+	unsigned int color = 0;
+
+	if (pixel_dev.addressing_mode == ALT_UP_PIXEL_BUFFER_XY_ADDRESS_MODE) {
+		offset += (x << pixel_dev.x_coord_offset) + (y << pixel_dev.y_coord_offset);
+	} else {
+		offset += (y * VGA_HOST_WIDTH + x) << pixel_dev.x_coord_offset;
+	}
+	memcpy(&color, sram + offset, 1 << pixel_dev.x_coord_offset);
+
+	if (pixel_dev.color_mode == ALT_UP_8BIT_COLOR_MODE) {
+		rgb[0] = ((color >> 5) & 0x7) * 255 / 7;
+		rgb[1] = ((color >> 2) & 0x7) * 255 / 7;
+		rgb[2] = (color & 0x3) * 255 / 3;
+	} else if (pixel_dev.color_mode == ALT_UP_16BIT_COLOR_MODE) {
+		rgb[0] = ((color >> 11) & 0x1f) * 255 / 31;
+		rgb[1] = ((color >> 5) & 0x3f) * 255 / 63;
+		rgb[2] = (color & 0x1f) * 255 / 31;
+	} else if (pixel_dev.color_mode == ALT_UP_24BIT_COLOR_MODE) {
+		rgb[0] = (color >> 16) & 0xff;
+		rgb[1] = (color >> 8) & 0xff;
+		rgb[2] = color & 0xff;
+	} else {
+		rgb[0] = (color >> 22) & 0xff;
+		rgb[1] = (color >> 12) & 0xff;
+		rgb[2] = (color >> 2) & 0xff;
+	}
+}
+
+char vga_host_char(unsigned int x, unsigned int y) {
+	char ch = char_memory[(y << char_dev.y_coord_offset) + x];
+	return (ch == 0) ? ' ' : ch;
+}
+
+int vga_host_write_ppm(const char *path) {
+	FILE *file = fopen(path, "wb");
+	unsigned char rgb[3];
+	unsigned int x, y;
+
+	if (file == NULL) {
+		return -1;
+	}
+	fprintf(file, "P6\n%d %d\n255\n", VGA_HOST_WIDTH, VGA_HOST_HEIGHT);
+	for (y = 0; y < VGA_HOST_HEIGHT; y++) {
+		for (x = 0; x < VGA_HOST_WIDTH; x++) {
+			vga_host_pixel(x, y, rgb);
+			fwrite(rgb, 3, 1, file);
+		}
+	}
+	return fclose(file);
+}
+
+int vga_host_write_text(const char *path) {
+	FILE *file = fopen(path, "w");
+	unsigned int x, y;
+
+	if (file == NULL) {
+		return -1;
+	}
+	for (y = 0; y < VGA_HOST_ROWS; y++) {
+		for (x = 0; x < VGA_HOST_COLUMNS; x++) {
+			fputc(vga_host_char(x, y), file);
+		}
+		fputc('\n', file);
+	}
+	return fclose(file);
+}
+
+// Number of pixels that differ from a golden PPM, -1 if it cannot be read
+long vga_host_compare_ppm(const char *path) {
+	FILE *file = fopen(path, "rb");
+	unsigned char rgb[3], golden[3];
+	unsigned int x, y;
+	int width, height, depth;
+	long differ = 0;
+
+	if (file == NULL) {
+		return -1;
+	}
+	if ((fscanf(file, "P6 %d %d %d", &width, &height, &depth) != 3) || (fgetc(file) == EOF)
+			|| (width != VGA_HOST_WIDTH) || (height != VGA_HOST_HEIGHT) || (depth != 255)) {
+		fclose(file);
+		return -1;
+	}
+	for (y = 0; y < VGA_HOST_HEIGHT; y++) {
+		for (x = 0; x < VGA_HOST_WIDTH; x++) {
+			if (fread(golden, 3, 1, file) != 1) {
+				fclose(file);
+				return -1;
+			}
+			vga_host_pixel(x, y, rgb);
+			differ += (memcmp(rgb, golden, 3) != 0);
+		}
+	}
+	fclose(file);
+	return differ;
+}
+
+// Number of character cells that differ from a golden text dump, -1 if it cannot be read
+long vga_host_compare_text(const char *path) {
+	FILE *file = fopen(path, "r");
+	char line[VGA_HOST_COLUMNS + 2];
+	unsigned int x, y;
+	long differ = 0;
+
+	if (file == NULL) {
+		return -1;
+	}
+	for (y = 0; y < VGA_HOST_ROWS; y++) {
+		if ((fgets(line, sizeof(line), file) == NULL) || (strlen(line) != VGA_HOST_COLUMNS + 1)) {
+			fclose(file);
+			return -1;
+		}
+		for (x = 0; x < VGA_HOST_COLUMNS; x++) {
+			differ += (vga_host_char(x, y) != line[x]);
+		}
+	}
+	fclose(file);
+	return differ;
+}
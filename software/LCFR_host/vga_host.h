@@ -0,0 +1,39 @@
+#ifndef VGA_HOST_H_
+#define VGA_HOST_H_
+
+#include "altera_up_avalon_video_character_buffer_with_dma.h"
+#include "altera_up_avalon_video_pixel_buffer_dma.h"
+
+/*==============*/
+/* Definitions. */
+/*==============*/
+// The DE2-115 video system: 640x480 pixels in SRAM, 30-bit colour, XY
+// addressing, and an 80x60 character overlay.
+#define VGA_HOST_WIDTH 640
+#define VGA_HOST_HEIGHT 480
+#define VGA_HOST_COLUMNS 80
+#define VGA_HOST_ROWS 60
+
+/*=============*/
+/* Structures. */
+/*=============*/
+typedef struct {
+	unsigned long long pixel_writes;	// Bus writes into the pixel buffer memory
+	unsigned long long pixel_bytes;
+	unsigned long long char_writes;		// Bus writes into the character buffer memory
+} VgaCounters;
+
+/*========================*/
+/* Function Declarations. */
+/*========================*/
+int vga_host_init(int color_mode, int addressing_mode);
+void vga_host_counters(VgaCounters *counters);
+void vga_host_clear_counters(void);
+void vga_host_pixel(unsigned int x, unsigned int y, unsigned char rgb[3]);
+char vga_host_char(unsigned int x, unsigned int y);
+int vga_host_write_ppm(const char *path);
+int vga_host_write_text(const char *path);
+long vga_host_compare_ppm(const char *path);
+long vga_host_compare_text(const char *path);
+
+#endif /* VGA_HOST_H_ */